@@ -0,0 +1,22 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(set = 0, binding = 0) uniform texture2D textures[];
+layout(set = 0, binding = 1) uniform sampler samplers[];
+
+layout(push_constant) uniform PushConstants {
+    vec2 scale;
+    vec2 translate;
+    uint textureIndex;
+    uint samplerIndex;
+    uint linearizeColors;
+    uint pad;
+} pc;
+
+layout(location = 0) in vec4 fragColor;
+layout(location = 1) in vec2 fragUV;
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    outColor = fragColor * texture(sampler2D(textures[nonuniformEXT(pc.textureIndex)], samplers[pc.samplerIndex]), fragUV);
+}
@@ -0,0 +1,32 @@
+#version 450
+
+// Dear ImGui vertices: pixel positions mapped to NDC by the push constants
+
+layout(location = 0) in vec2 inPos;
+layout(location = 1) in vec2 inUV;
+layout(location = 2) in vec4 inColor;
+
+layout(push_constant) uniform PushConstants {
+    vec2 scale;
+    vec2 translate;
+    uint textureIndex;
+    uint samplerIndex;
+    uint linearizeColors;
+    uint pad;
+} pc;
+
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec2 fragUV;
+
+vec3 srgbToLinear(vec3 c) {
+    return mix(c / 12.92, pow((c + 0.055) / 1.055, vec3(2.4)), greaterThan(c, vec3(0.04045)));
+}
+
+void main() {
+    fragColor = inColor;
+    if (pc.linearizeColors != 0) {
+        fragColor.rgb = srgbToLinear(inColor.rgb);
+    }
+    fragUV = inUV;
+    gl_Position = vec4(inPos * pc.scale + pc.translate, 0.0, 1.0);
+}
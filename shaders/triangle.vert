@@ -0,0 +1,26 @@
+#version 450
+
+layout(push_constant) uniform PushConstants {
+    vec2 offset;
+    float scale;
+    float hue;
+} pc;
+
+layout(location = 0) out vec3 fragColor;
+
+const vec2 positions[3] = vec2[](
+    vec2(0.0, -0.5),
+    vec2(0.5, 0.5),
+    vec2(-0.5, 0.5)
+);
+
+const vec3 colors[3] = vec3[](
+    vec3(1.0, 0.0, 0.0),
+    vec3(0.0, 1.0, 0.0),
+    vec3(0.0, 0.0, 1.0)
+);
+
+void main() {
+    gl_Position = vec4(positions[gl_VertexIndex] * pc.scale + pc.offset, 0.0, 1.0);
+    fragColor = mix(colors[gl_VertexIndex], colors[(gl_VertexIndex + 1) % 3], pc.hue);
+}
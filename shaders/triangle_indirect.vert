@@ -0,0 +1,43 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// triangle.vert for the GPU-driven path: per-object data comes from the object buffer,
+// indexed by the firstInstance the cull pass wrote into the draw command
+
+struct Object {
+    vec2 offset;
+    float scale;
+    float hue;
+    float depth;
+    float radius;
+    vec2 pad;
+};
+
+layout(set = 0, binding = 2) readonly buffer Objects { Object objects[]; } objectBuffers[];
+
+layout(push_constant) uniform PushConstants {
+    vec2 viewCenter;
+    float zoom;
+    uint objects;
+} pc;
+
+layout(location = 0) out vec3 fragColor;
+
+const vec2 positions[3] = vec2[](
+    vec2(0.0, -0.5),
+    vec2(0.5, 0.5),
+    vec2(-0.5, 0.5)
+);
+
+const vec3 colors[3] = vec3[](
+    vec3(1.0, 0.0, 0.0),
+    vec3(0.0, 1.0, 0.0),
+    vec3(0.0, 0.0, 1.0)
+);
+
+void main() {
+    Object obj = objectBuffers[pc.objects].objects[gl_InstanceIndex];
+    vec2 pos = (positions[gl_VertexIndex] * obj.scale + obj.offset - pc.viewCenter) * pc.zoom;
+    gl_Position = vec4(pos, obj.depth, 1.0);
+    fragColor = mix(colors[gl_VertexIndex], colors[(gl_VertexIndex + 1) % 3], obj.hue);
+}
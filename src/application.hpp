@@ -0,0 +1,2447 @@
+#pragma once
+
+#if defined(__INTELLISENSE__) || !defined(USE_CPP20_MODULES)
+#include <vulkan/vulkan_raii.hpp>
+#else
+import vulkan_hpp;
+#endif
+#include <GLFW/glfw3.h>
+
+#include "bindless.hpp"
+#include "debug_message_sink.hpp"
+#include "deletion_queue.hpp"
+#include "device_features.hpp"
+#include "frame_allocator.hpp"
+#include "frame_capture.hpp"
+#include "frame_pacer.hpp"
+#include "gpu_allocator.hpp"
+#include "gpu_culling.hpp"
+#include "init_graph.hpp"
+#include "job_system.hpp"
+#include "layout_cache.hpp"
+#include "parallel_recorder.hpp"
+#include "pipeline_cache.hpp"
+#include "post_process.hpp"
+#include "profiler.hpp"
+#include "render_graph.hpp"
+#include "scene.hpp"
+#include "texture_file.hpp"
+#include "texture_streamer.hpp"
+#include "upload_service.hpp"
+#include "vk_dispatch.hpp"
+#include "vk_utils.hpp"
+
+#ifdef VUK_HAS_IMGUI
+#include "imgui_renderer.hpp"
+
+#include <imgui.h>
+#endif
+
+#include <iostream>
+#include <fstream>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <string>
+#include <set>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+
+// Must match the push_constant block in shaders/triangle.vert
+struct TrianglePushConstants {
+    float offset[2];
+    float scale;
+    float hue;
+};
+
+class HelloTriangleApplication {
+public:
+    const uint32_t WIDTH = 800;
+    const uint32_t HEIGHT = 600;
+    static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 3;
+
+    // Number of frames the CPU may record ahead of the GPU (clamped to [1, MAX_FRAMES_IN_FLIGHT])
+    uint32_t framesInFlight = 2;
+    // Headless mode renders into device-owned images: no window, surface or swapchain
+    bool headless = false;
+    // Stop after this many frames (0 = run until the window closes; headless renders at least one)
+    uint32_t frameLimit = 0;
+    // Optional PPM path the last headless frame is read back into
+    std::string readbackPath;
+    // Writes every frame to disk without stalling the GPU: a path ending in .y4m becomes one
+    // Y4M stream, anything else the prefix of numbered PPM files
+    std::string capturePath;
+    // On-disk VkPipelineCache blob (empty disables persistence)
+    std::string pipelineCachePath = "pipeline_cache.bin";
+    // Triangles drawn per frame, laid out on a grid
+    uint32_t drawCount = 1;
+    // Recording workers including the main thread (0 = one per hardware thread)
+    uint32_t recordThreads = 0;
+    // Headless only: instead of rendering, time recording this many draws on 1..recordThreads threads
+    uint32_t benchRecordDraws = 0;
+    // Print p50/p95/p99 frame, CPU and GPU times periodically and at exit
+    bool profile = false;
+    // Chrome trace JSON written at exit (implies profiling)
+    std::string tracePath;
+    // Forces a physical device by enumeration index or name substring; falls back to VUK_DEVICE
+    std::string deviceOverride;
+    // Cull on the GPU and draw the scene with one indirect draw (falls back to CPU draws when
+    // the device lacks descriptor indexing or indirect draw count)
+    bool gpuDriven = false;
+    // World position at the center of the view and magnification; at zoom 1 the [-1, 1]
+    // square the scene is laid out in fills the view
+    float cameraCenter[2] = {0.0f, 0.0f};
+    float cameraZoom = 1.0f;
+    // Headless only: compare CPU-submitted and GPU-driven draws for object counts up to this
+    uint32_t benchIndirectObjects = 0;
+    // Dear ImGui overlay with frame statistics (needs a build with Dear ImGui and descriptor
+    // indexing; cleared when unavailable)
+    bool uiEnabled = false;
+    // Extra rectangles the overlay draws each frame, to load the UI renderer
+    uint32_t uiStressRects = 0;
+    // Render the scene in HDR and bloom and tonemap it in compute passes (needs descriptor indexing)
+    bool postEnabled = false;
+    // Run the post-processing passes on a dedicated compute queue when the device has one
+    bool asyncCompute = true;
+    // Headless only: stream this many synthetic textures past a moving camera
+    uint32_t benchStreamingTextures = 0;
+    // Present mode, swapchain image count and frame limiting of the windowed loop
+    FramePacerConfig pacingConfig;
+    // Headless only: time recording this many draws through the loader and the dispatch table
+    uint32_t benchDispatchDraws = 0;
+    // Headless only: time the scene kernels (transforms, culling, draw sort) on this many objects
+    uint32_t benchSceneObjects = 0;
+    // Headless only: time freeing descriptor sets one by one against resetting a frame's pools,
+    // creating set layouts against cache lookups, and buffer creation against bump allocation
+    uint32_t benchDescriptorOps = 0;
+
+    // Below this many draws per job the cost of a secondary command buffer outweighs the split
+    static constexpr uint32_t MIN_DRAWS_PER_JOB = 128;
+    static constexpr uint32_t PROFILE_SUMMARY_INTERVAL = 600;
+    // Distance from the triangle's origin to its farthest corner, at scale 1
+    static constexpr float TRIANGLE_BOUNDS_RADIUS = 0.7072f;
+
+    GLFWwindow* window = nullptr;
+
+    // Vulkan RAII objects
+    std::unique_ptr<vk::raii::Context> context;
+    std::unique_ptr<vk::raii::Instance> instance;
+    std::unique_ptr<vk::raii::DebugUtilsMessengerEXT> debugMessenger;
+    // Counts and prints the messenger's messages off the calling thread; started with it
+    DebugMessageSink debugMessages;
+    std::unique_ptr<vk::raii::SurfaceKHR> surface;
+    vk::PhysicalDevice physicalDevice{VK_NULL_HANDLE};
+    // What the logical device was actually created with
+    DeviceFeatures deviceFeatures;
+    // Logical device (using C API to avoid RAII constructor overload issues)
+    VkDevice device = VK_NULL_HANDLE;
+    VkQueue graphicsQueue = VK_NULL_HANDLE;
+    VkQueue presentQueue = VK_NULL_HANDLE;
+    // Aliases graphicsQueue when the device has no separate transfer family
+    VkQueue transferQueue = VK_NULL_HANDLE;
+    // Null without a compute family separate from graphics; may alias transferQueue
+    VkQueue computeQueue = VK_NULL_HANDLE;
+    // Device memory sub-allocator; every buffer/image goes through it
+    GpuAllocator allocator;
+    // Objects replaced at runtime (resizes, rebuilt graphs) are destroyed through it once
+    // the frames that may use them have completed
+    DeletionQueue deletionQueue;
+    // Only initialized for --capture
+    FrameCapture capture;
+    PipelineCache pipelineCache;
+    // Owns every pipeline layout and sampler; modules look theirs up at init
+    LayoutCache layouts;
+    // Per-frame uniform/storage data and transient descriptor sets
+    FrameAllocator frameAllocator;
+    UploadService uploads;
+    JobSystem jobs;
+    ParallelRecorder recorder;
+    Profiler profiler;
+    FramePacer pacer;
+    // Only created when the device supports descriptor indexing; set 0 of every pipeline layout
+    BindlessTable bindless;
+    // Only initialized for --gpu-driven or --bench-indirect on a capable device
+    GpuCulling gpuCulling;
+    bool gpuCullingReady = false;
+#ifdef VUK_HAS_IMGUI
+    ImGuiRenderer ui;
+#endif
+    std::chrono::steady_clock::time_point lastUiFrame{};
+    // Only initialized for --post on a device with descriptor indexing
+    PostProcess post;
+    // Only initialized by --bench-streaming
+    TextureStreamer streamer;
+    bool streamerReady = false;
+    VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+    std::vector<VkImage> swapchainImages;
+    std::vector<VkImageView> swapchainImageViews;
+    // Indexed by swapchain image: a present holds its semaphore until the image is presented, which
+    // no frame fence covers, so one per frame in flight could be signalled again while still waited on
+    std::vector<VkSemaphore> renderFinished;
+    VkFormat swapchainImageFormat = VK_FORMAT_UNDEFINED;
+    VkExtent2D swapchainExtent{};
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline graphicsPipeline = VK_NULL_HANDLE;
+    // Scene pipeline of the GPU-driven path: object data from the object buffer, depth tested
+    VkPipeline indirectPipeline = VK_NULL_HANDLE;
+    // Rebuilt whenever the swapchain changes; the backbuffer is rebound every frame
+    std::unique_ptr<RenderGraph> renderGraph;
+    RGHandle backbuffer = RG_INVALID;
+    // Rebound to this frame's capture slot every frame
+    RGHandle captureTarget = RG_INVALID;
+    uint32_t scenePass = 0;
+    // Per-frame switches read by the graph's pass callbacks while recording
+    bool recordParallel = false;
+    bool readbackThisFrame = false;
+    // Backing memory for the headless render targets (swapchainImages holds the images)
+    std::vector<GpuAllocation> offscreenAllocations;
+    VkExtent2D offscreenExtent{WIDTH, HEIGHT};
+    VkBuffer readbackBuffer = VK_NULL_HANDLE;
+    GpuAllocation readbackAllocation;
+    bool framebufferResized = false;
+    // Number of frames submitted so far
+    uint64_t frameNumber = 0;
+    std::optional<uint32_t> graphicsFamily;
+    std::optional<uint32_t> presentFamily;
+    std::optional<uint32_t> transferFamily;
+    std::optional<uint32_t> computeFamily;
+    uint32_t computeQueueIndex = 0;
+    // Orders the render graph's segments across the graphics and compute queues. Segment k of
+    // an execution signals the value counted up for it; the previous execution's values are
+    // kept for segments that wait on it (cleared whenever the graph is rebuilt).
+    VkSemaphore graphTimeline = VK_NULL_HANDLE;
+    uint64_t graphTimelineValue = 0;
+    std::vector<uint64_t> previousSegmentValues;
+
+    // Per-frame-in-flight resources. Each frame owns its own pool so it can be reset
+    // wholesale once its fence has signalled, without touching frames still on the GPU.
+    struct FrameData {
+        VkCommandPool commandPool = VK_NULL_HANDLE;
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        // Render graph segments after the first, indexed by segment; allocated on first use
+        VkCommandPool computePool = VK_NULL_HANDLE;
+        std::vector<VkCommandBuffer> graphicsSegments;
+        std::vector<VkCommandBuffer> computeSegments;
+        VkSemaphore imageAvailable = VK_NULL_HANDLE;
+        VkFence inFlight = VK_NULL_HANDLE;
+    };
+    std::vector<FrameData> frames;
+    uint32_t currentFrame = 0;
+    // What both draw paths render; drawCount objects
+    Scene scene;
+    // The scene as uploaded for the GPU-driven path
+    std::vector<GpuObject> sceneObjects;
+    // CPU time of the last recordCommandBuffer(), read by the benchmarks
+    double lastRecordMs = 0.0;
+    // Start of initVulkan(), for the time to the first frame
+    std::chrono::steady_clock::time_point startTime{};
+
+    void run() {
+        profiler.setEnabled(profile || !tracePath.empty());
+        initVulkan();
+        mainLoop();
+        cleanup();
+    }
+
+private:
+    // Drives frames, resizes and pipeline creation for the synthetic workloads of src/bench_main.cpp
+    friend class BenchRunner;
+
+    // Startup as a dependency graph (see InitGraph). Windowing stays on this thread while the
+    // instance, device and everything built on them are set up on the job system's workers;
+    // pipelines, GPU culling, post-processing and the UI compile their shaders concurrently.
+    void initVulkan() {
+        ProfileZone zone(profiler, "initVulkan");
+        startTime = std::chrono::steady_clock::now();
+        framesInFlight = std::clamp(framesInFlight, 1u, MAX_FRAMES_IN_FLIGHT);
+        jobs.init(recordThreads);
+
+        InitGraph graph;
+        std::vector<InitGraph::Task> deviceInputs;
+        InitGraph::Task windowTask = 0;
+        if (headless) {
+            deviceInputs.push_back(graph.add("instance", [this] { createInstance(); }));
+        } else {
+            InitGraph::Task glfw = graph.add("glfw", [] {
+                if (!glfwInit()) {
+                    throw std::runtime_error("Failed to initialize GLFW");
+                }
+            }, {}, true);
+            InitGraph::Task instanceTask = graph.add("instance", [this] { createInstance(); }, {glfw});
+            windowTask = graph.add("window", [this] { createWindow(); }, {glfw}, true);
+            deviceInputs.push_back(graph.add("surface", [this] { createSurface(); }, {instanceTask, windowTask}));
+        }
+        InitGraph::Task physical = graph.add("physicalDevice", [this] { pickPhysicalDevice(); }, deviceInputs);
+        InitGraph::Task deviceTask = graph.add("device", [this] {
+            createLogicalDevice();
+            retrieveQueues();
+            allocator.init(static_cast<VkPhysicalDevice>(physicalDevice), device, GpuAllocator::DEFAULT_BLOCK_SIZE,
+                           deviceFeatures.memoryBudget);
+            deletionQueue.init(device, allocator, framesInFlight);
+            layouts.init(device);
+        }, {physical});
+        InitGraph::Task cache = graph.add("pipelineCache", [this] {
+            pipelineCache.init(static_cast<VkPhysicalDevice>(physicalDevice), device, pipelineCachePath);
+        }, {deviceTask});
+        InitGraph::Task bindlessTask = graph.add("bindless", [this] { createBindlessTable(); }, {deviceTask});
+        InitGraph::Task uploadsTask = graph.add("uploads", [this] { createUploadService(); }, {deviceTask});
+        InitGraph::Task targets;
+        if (headless) {
+            targets = graph.add("targets", [this] {
+                createOffscreenTargets();
+                createImageViews();
+                if (!readbackPath.empty()) {
+                    createReadbackBuffer();
+                }
+            }, {deviceTask});
+        } else {
+            // The swapchain extent comes from the window's framebuffer size, a main-thread query
+            targets = graph.add("targets", [this] {
+                pacer.init(device, pacingConfig, deviceFeatures.presentWait);
+                createSwapchain();
+                createImageViews();
+            }, {deviceTask, windowTask}, true);
+        }
+        InitGraph::Task culling = graph.add("gpuCulling", [this] { createGpuCulling(); }, {cache, bindlessTask});
+        InitGraph::Task postTask = graph.add("postProcess", [this] { createPostProcess(); }, {cache, bindlessTask});
+        InitGraph::Task sceneTask = graph.add("scene", [this] { createScene(); }, {culling, uploadsTask});
+        // The scene pipeline's color format depends on whether post-processing stayed enabled
+        InitGraph::Task pipelines = graph.add("pipelines", [this] { createGraphicsPipeline(); },
+                                              {cache, bindlessTask, targets, culling, postTask});
+        InitGraph::Task uiTask = graph.add("ui", [this] { createUi(); }, {cache, bindlessTask, uploadsTask, targets});
+        InitGraph::Task frameTask = graph.add("frameResources", [this] { createFrameResources(); }, {deviceTask});
+        InitGraph::Task recorderTask = graph.add("recorder", [this] { createRecorder(); }, {deviceTask});
+        InitGraph::Task captureTask = graph.add("capture", [this] {
+            if (!capturePath.empty()) capture.init(device, allocator, framesInFlight, capturePath);
+        }, {deviceTask});
+        InitGraph::Task frameAllocatorTask = graph.add("frameAllocator", [this] {
+            frameAllocator.init(static_cast<VkPhysicalDevice>(physicalDevice), device, allocator, layouts, framesInFlight);
+        }, {deviceTask});
+        graph.add("renderGraph", [this] { buildRenderGraph(); },
+                  {pipelines, sceneTask, uiTask, frameTask, recorderTask, captureTask, frameAllocatorTask});
+
+        graph.run(jobs, profiler);
+        printStartupReport(graph);
+    }
+
+    void createWindow() {
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+        glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+
+        window = glfwCreateWindow(WIDTH, HEIGHT, "Vulkan", nullptr, nullptr);
+        if (!window) {
+            throw std::runtime_error("Failed to create GLFW window");
+        }
+
+        // setup framebuffer resize callback
+        glfwSetWindowUserPointer(window, this);
+        glfwSetFramebufferSizeCallback(window, [](GLFWwindow* win, int w, int h){
+            auto app = reinterpret_cast<HelloTriangleApplication*>(glfwGetWindowUserPointer(win));
+            app->framebufferResized = true;
+        });
+    }
+
+    void printFirstFrame() {
+        std::cout << "First frame submitted "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count()
+                  << " ms after startup\n";
+    }
+
+    void printCaptureSummary() {
+        FrameCaptureStats s = capture.stats();
+        std::cout << "Frame capture: " << s.framesWritten << "/" << s.framesCaptured << " frames written to "
+                  << capture.path() << " (" << s.framesDropped << " dropped), "
+                  << (s.framesWritten + s.framesDropped > 0 ? s.encodeMs / (s.framesWritten + s.framesDropped) : 0.0)
+                  << " ms encode per frame, " << s.encoderStalls << " encoder stalls (" << s.stallMs << " ms)\n";
+    }
+
+    // One line per run; the phases with --profile
+    void printStartupReport(const InitGraph &graph) {
+        std::cout << "Initialized in " << graph.totalMs() << " ms (" << graph.workMs() << " ms of work on "
+                  << jobs.workerCount() << " threads)\n";
+        if (!profile) return;
+        std::cout << "phase  start ms  end ms  worker\n";
+        for (const InitGraph::Timing &t : graph.timings()) {
+            std::cout << "  " << t.name << "  " << t.startMs << "  " << t.endMs << "  " << t.worker
+                      << (t.skipped ? "  (skipped)" : "") << "\n";
+        }
+    }
+
+    static VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats) {
+        if (availableFormats.size() == 1 && availableFormats[0].format == VK_FORMAT_UNDEFINED) {
+            return {VK_FORMAT_B8G8R8A8_SRGB, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR};
+        }
+
+        for (const auto &avail : availableFormats) {
+            if (avail.format == VK_FORMAT_B8G8R8A8_SRGB && avail.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
+                return avail;
+            }
+        }
+
+        return availableFormats[0];
+    }
+
+    VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities) {
+        if (capabilities.currentExtent.width != UINT32_MAX) {
+            return capabilities.currentExtent;
+        } else {
+            int width, height;
+            glfwGetFramebufferSize(window, &width, &height);
+            VkExtent2D actualExtent = { static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+            actualExtent.width = std::clamp(actualExtent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
+            actualExtent.height = std::clamp(actualExtent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
+            return actualExtent;
+        }
+    }
+
+    void createSwapchain() {
+        ProfileZone zone(profiler, "createSwapchain");
+        // Query surface capabilities, formats, present modes
+        VkPhysicalDevice vkpd = static_cast<VkPhysicalDevice>(physicalDevice);
+
+        VkSurfaceCapabilitiesKHR capabilities;
+        vkGetPhysicalDeviceSurfaceCapabilitiesKHR(vkpd, static_cast<VkSurfaceKHR>(static_cast<vk::SurfaceKHR>(*surface)), &capabilities);
+
+        uint32_t formatCount = 0;
+        vkGetPhysicalDeviceSurfaceFormatsKHR(vkpd, static_cast<VkSurfaceKHR>(static_cast<vk::SurfaceKHR>(*surface)), &formatCount, nullptr);
+        std::vector<VkSurfaceFormatKHR> formats(formatCount);
+        if (formatCount > 0) {
+            vkGetPhysicalDeviceSurfaceFormatsKHR(vkpd, static_cast<VkSurfaceKHR>(static_cast<vk::SurfaceKHR>(*surface)), &formatCount, formats.data());
+        }
+
+        uint32_t presentModeCount = 0;
+        vkGetPhysicalDeviceSurfacePresentModesKHR(vkpd, static_cast<VkSurfaceKHR>(static_cast<vk::SurfaceKHR>(*surface)), &presentModeCount, nullptr);
+        std::vector<VkPresentModeKHR> presentModes(presentModeCount);
+        if (presentModeCount > 0) {
+            vkGetPhysicalDeviceSurfacePresentModesKHR(vkpd, static_cast<VkSurfaceKHR>(static_cast<vk::SurfaceKHR>(*surface)), &presentModeCount, presentModes.data());
+        }
+
+    VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(formats);
+        VkPresentModeKHR presentMode = pacer.choosePresentMode(presentModes);
+        VkExtent2D extent = chooseSwapExtent(capabilities);
+
+    // store chosen format/extent
+    swapchainImageFormat = surfaceFormat.format;
+    swapchainExtent = extent;
+
+        uint32_t imageCount = pacer.chooseImageCount(capabilities);
+
+        VkSwapchainCreateInfoKHR scInfo{};
+        scInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+        scInfo.surface = static_cast<VkSurfaceKHR>(static_cast<vk::SurfaceKHR>(*surface));
+        scInfo.minImageCount = imageCount;
+        scInfo.imageFormat = surfaceFormat.format;
+        scInfo.imageColorSpace = surfaceFormat.colorSpace;
+        scInfo.imageExtent = extent;
+        scInfo.imageArrayLayers = 1;
+        scInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        if (postEnabled) {
+            // The post-processing result is blitted into the swapchain image
+            if (!(capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT)) {
+                throw std::runtime_error("Swapchain images can't be blitted to; run without --post!");
+            }
+            scInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        }
+        if (!capturePath.empty()) {
+            // Captures copy the finished swapchain image into a readback buffer
+            if (!(capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) ||
+                !FrameCapture::isSupportedFormat(surfaceFormat.format)) {
+                throw std::runtime_error("Swapchain images can't be captured; run without --capture!");
+            }
+            scInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        }
+
+        uint32_t queueFamilyIndicesArr[2] = {};
+        uint32_t queueFamilyCount = 0;
+        if (graphicsFamily.value() != presentFamily.value()) {
+            queueFamilyIndicesArr[0] = graphicsFamily.value();
+            queueFamilyIndicesArr[1] = presentFamily.value();
+            scInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
+            scInfo.queueFamilyIndexCount = 2;
+            scInfo.pQueueFamilyIndices = queueFamilyIndicesArr;
+        } else {
+            scInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            scInfo.queueFamilyIndexCount = 0;
+            scInfo.pQueueFamilyIndices = nullptr;
+        }
+
+        scInfo.preTransform = capabilities.currentTransform;
+        scInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+        scInfo.presentMode = presentMode;
+        scInfo.clipped = VK_TRUE;
+        // Handing over the current swapchain lets the driver recycle its resources and keep
+        // presenting queued images; the caller retires the old handle.
+        scInfo.oldSwapchain = swapchain;
+
+        VkSwapchainKHR newSwapchain = VK_NULL_HANDLE;
+        if (vkCreateSwapchainKHR(device, &scInfo, nullptr, &newSwapchain) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create swap chain!");
+        }
+        swapchain = newSwapchain;
+
+        // retrieve images
+        uint32_t actualCount = 0;
+        vkGetSwapchainImagesKHR(device, swapchain, &actualCount, nullptr);
+        swapchainImages.resize(actualCount);
+        vkGetSwapchainImagesKHR(device, swapchain, &actualCount, swapchainImages.data());
+
+        VkSemaphoreCreateInfo semInfo{};
+        semInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        renderFinished.assign(actualCount, VK_NULL_HANDLE);
+        for (VkSemaphore &semaphore : renderFinished) {
+            if (vkCreateSemaphore(device, &semInfo, nullptr, &semaphore) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create present semaphore!");
+            }
+        }
+        pacer.swapchainCreated(swapchain, presentMode, actualCount);
+    }
+
+    void createImageViews() {
+        swapchainImageViews.resize(swapchainImages.size());
+        VkFormat imageFormat = swapchainImageFormat;
+        for (size_t i = 0; i < swapchainImages.size(); ++i) {
+            VkImageViewCreateInfo viewInfo{};
+            viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            viewInfo.image = swapchainImages[i];
+            viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            viewInfo.format = imageFormat;
+            viewInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+            viewInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+            viewInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+            viewInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+            viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            viewInfo.subresourceRange.baseMipLevel = 0;
+            viewInfo.subresourceRange.levelCount = 1;
+            viewInfo.subresourceRange.baseArrayLayer = 0;
+            viewInfo.subresourceRange.layerCount = 1;
+
+            if (vkCreateImageView(device, &viewInfo, nullptr, &swapchainImageViews[i]) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create image views!");
+            }
+        }
+    }
+
+    // Headless stand-in for createSwapchain(): one device-owned target per frame in flight,
+    // stored in swapchainImages so views, the render graph and recording are shared with the windowed path.
+    void createOffscreenTargets() {
+        swapchainImageFormat = VK_FORMAT_R8G8B8A8_SRGB;
+        swapchainExtent = offscreenExtent;
+
+        swapchainImages.resize(framesInFlight);
+        offscreenAllocations.resize(framesInFlight);
+        for (uint32_t i = 0; i < framesInFlight; ++i) {
+            VkImageCreateInfo imageInfo{};
+            imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageInfo.format = swapchainImageFormat;
+            imageInfo.extent = {swapchainExtent.width, swapchainExtent.height, 1};
+            imageInfo.mipLevels = 1;
+            imageInfo.arrayLayers = 1;
+            imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+                              VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+            imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            swapchainImages[i] = allocator.createImage(imageInfo, MemoryUsage::GpuOnly, offscreenAllocations[i]);
+        }
+    }
+
+    void createReadbackBuffer() {
+        VkBufferCreateInfo bufInfo{};
+        bufInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufInfo.size = static_cast<VkDeviceSize>(swapchainExtent.width) * swapchainExtent.height * 4;
+        bufInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        bufInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        readbackBuffer = allocator.createBuffer(bufInfo, MemoryUsage::GpuToCpu, readbackAllocation);
+    }
+
+    // Writes the readback buffer as a binary PPM. Caller must have waited for the copy.
+    void writeReadback(const std::string &path) {
+        allocator.invalidate(readbackAllocation);
+
+        std::ofstream out(path, std::ios::binary);
+        if (!out) {
+            throw std::runtime_error("Failed to open readback output: " + path);
+        }
+        out << "P6\n" << swapchainExtent.width << " " << swapchainExtent.height << "\n255\n";
+        const uint8_t *pixels = static_cast<const uint8_t*>(readbackAllocation.mapped);
+        std::vector<uint8_t> row(static_cast<size_t>(swapchainExtent.width) * 3);
+        for (uint32_t y = 0; y < swapchainExtent.height; ++y) {
+            const uint8_t *src = pixels + static_cast<size_t>(y) * swapchainExtent.width * 4;
+            for (uint32_t x = 0; x < swapchainExtent.width; ++x) {
+                row[x * 3 + 0] = src[x * 4 + 0];
+                row[x * 3 + 1] = src[x * 4 + 1];
+                row[x * 3 + 2] = src[x * 4 + 2];
+            }
+            out.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size()));
+        }
+        std::cout << "Wrote readback to " << path << "\n";
+    }
+
+    void destroyOffscreenTargets() {
+        if (readbackBuffer != VK_NULL_HANDLE) {
+            allocator.destroyBuffer(readbackBuffer, readbackAllocation);
+            readbackBuffer = VK_NULL_HANDLE;
+        }
+        for (auto iv : swapchainImageViews) vkDestroyImageView(device, iv, nullptr);
+        swapchainImageViews.clear();
+        for (size_t i = 0; i < swapchainImages.size(); ++i) {
+            allocator.destroyImage(swapchainImages[i], offscreenAllocations[i]);
+        }
+        swapchainImages.clear();
+        offscreenAllocations.clear();
+    }
+
+    // Headless stand-in for recreateSwapchain(); the old targets go to the deletion queue
+    void resizeOffscreenTargets(VkExtent2D extent) {
+        ProfileZone zone(profiler, "resizeOffscreenTargets");
+        retireRenderGraph();
+        for (VkImageView view : swapchainImageViews) deletionQueue.destroyImageView(view);
+        for (size_t i = 0; i < swapchainImages.size(); ++i) {
+            deletionQueue.destroyImage(swapchainImages[i], offscreenAllocations[i]);
+        }
+        swapchainImageViews.clear();
+        swapchainImages.clear();
+        offscreenAllocations.clear();
+        bool readback = readbackBuffer != VK_NULL_HANDLE;
+        deletionQueue.destroyBuffer(readbackBuffer, readbackAllocation);
+        readbackBuffer = VK_NULL_HANDLE;
+        offscreenExtent = extent;
+        createOffscreenTargets();
+        createImageViews();
+        if (readback) {
+            createReadbackBuffer();
+        }
+        buildRenderGraph();
+    }
+
+    struct SwapChainSupportDetails {
+        VkSurfaceCapabilitiesKHR capabilities;
+        std::vector<VkSurfaceFormatKHR> formats;
+        std::vector<VkPresentModeKHR> presentModes;
+    };
+
+    SwapChainSupportDetails querySwapchainSupport(VkPhysicalDevice vkpd) {
+        SwapChainSupportDetails details;
+
+        vkGetPhysicalDeviceSurfaceCapabilitiesKHR(vkpd, static_cast<VkSurfaceKHR>(static_cast<vk::SurfaceKHR>(*surface)), &details.capabilities);
+
+        uint32_t formatCount;
+        vkGetPhysicalDeviceSurfaceFormatsKHR(vkpd, static_cast<VkSurfaceKHR>(static_cast<vk::SurfaceKHR>(*surface)), &formatCount, nullptr);
+        if (formatCount != 0) {
+            details.formats.resize(formatCount);
+            vkGetPhysicalDeviceSurfaceFormatsKHR(vkpd, static_cast<VkSurfaceKHR>(static_cast<vk::SurfaceKHR>(*surface)), &formatCount, details.formats.data());
+        }
+
+        uint32_t presentCount;
+        vkGetPhysicalDeviceSurfacePresentModesKHR(vkpd, static_cast<VkSurfaceKHR>(static_cast<vk::SurfaceKHR>(*surface)), &presentCount, nullptr);
+        if (presentCount != 0) {
+            details.presentModes.resize(presentCount);
+            vkGetPhysicalDeviceSurfacePresentModesKHR(vkpd, static_cast<VkSurfaceKHR>(static_cast<vk::SurfaceKHR>(*surface)), &presentCount, details.presentModes.data());
+        }
+
+        return details;
+    }
+
+    // The frame as a render graph: the scene pass draws into the backbuffer (with --post into an HDR
+    // target that the post-processing passes resolve into the backbuffer), the UI pass (with --ui)
+    // draws the overlay on top and, in headless mode with --readback, a transfer pass copies it into
+    // the host-visible readback buffer (with --capture, into this frame's capture slot). The
+    // GPU-driven scene is preceded by the cull passes and followed by the Hi-Z build of its depth
+    // buffer. Barriers and layout transitions (including the final one to PRESENT_SRC) come from
+    // the graph.
+    void buildRenderGraph() {
+        ProfileZone zone(profiler, "buildRenderGraph");
+        renderGraph = std::make_unique<RenderGraph>();
+        renderGraph->init(allocator);
+        renderGraph->setProfiler(&profiler);
+        uint32_t asyncFamily = asyncCompute && computeFamily.has_value() ? computeFamily.value() : graphicsFamily.value();
+        renderGraph->setQueueFamilies(graphicsFamily.value(), asyncFamily);
+        renderGraph->setFrameCount(framesInFlight);
+        previousSegmentValues.clear();
+
+        // The acquire semaphore is waited on at COLOR_ATTACHMENT_OUTPUT, so the first
+        // transition chains onto that stage
+        RGState initial{VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_NONE};
+        RGState final{};
+        if (!headless) {
+            final.layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        }
+        backbuffer = renderGraph->importImage("backbuffer", swapchainImages[0], swapchainImageViews[0],
+                                              swapchainImageFormat, swapchainExtent, initial, final);
+        RGHandle sceneColor = backbuffer;
+        if (postEnabled) {
+            sceneColor = renderGraph->createTexture("hdr", {PostProcess::HDR_FORMAT, swapchainExtent});
+        }
+
+        if (gpuDriven) {
+            gpuCulling.addCullPasses(*renderGraph, swapchainExtent);
+            RGHandle depth = renderGraph->createTexture("depth", {GpuCulling::DEPTH_FORMAT, swapchainExtent});
+            scenePass = renderGraph->addPass("scene",
+                [&](RenderGraph::PassBuilder &pass) {
+                    pass.writeColor(sceneColor, VK_ATTACHMENT_LOAD_OP_CLEAR, {{0.0f, 0.0f, 0.0f, 1.0f}});
+                    pass.writeDepth(depth, VK_ATTACHMENT_LOAD_OP_CLEAR, 1.0f);
+                    gpuCulling.readDrawCommands(pass);
+                },
+                [this](RGPassContext &ctx) {
+                    bindSceneState(ctx.cmd, indirectPipeline);
+                    gpuCulling.recordDraw(ctx.cmd, pipelineLayout);
+                });
+            gpuCulling.addHiZPass(*renderGraph, depth);
+        } else {
+            scenePass = renderGraph->addPass("scene",
+                [&](RenderGraph::PassBuilder &pass) {
+                    pass.writeColor(sceneColor, VK_ATTACHMENT_LOAD_OP_CLEAR, {{0.0f, 0.0f, 0.0f, 1.0f}});
+                },
+                [this](RGPassContext &ctx) {
+                    if (recordParallel) {
+                        const auto &secondaries = recordDrawsParallel();
+                        vkd.cmdExecuteCommands(ctx.cmd, static_cast<uint32_t>(secondaries.size()), secondaries.data());
+                    } else {
+                        recordDraws(ctx.cmd, 0, scene.visibleCount());
+                    }
+                });
+        }
+
+        if (postEnabled) {
+            post.addPasses(*renderGraph, sceneColor, backbuffer, swapchainExtent);
+        }
+
+        if (uiEnabled) {
+            renderGraph->addPass("ui",
+                [&](RenderGraph::PassBuilder &pass) {
+                    pass.writeColor(backbuffer, VK_ATTACHMENT_LOAD_OP_LOAD);
+                },
+                [this](RGPassContext &ctx) {
+                    recordUi(ctx.cmd);
+                });
+        }
+
+        if (readbackBuffer != VK_NULL_HANDLE) {
+            RGState hostRead{VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_HOST_BIT, VK_ACCESS_2_HOST_READ_BIT};
+            RGHandle readback = renderGraph->importBuffer("readback", readbackBuffer, readbackAllocation.size,
+                                                          RGState{}, hostRead);
+            renderGraph->addPass("readback",
+                [&](RenderGraph::PassBuilder &pass) {
+                    pass.read(backbuffer, RGUsage::TransferSrc);
+                    pass.write(readback, RGUsage::TransferDst);
+                },
+                [this](RGPassContext &ctx) {
+                    if (!readbackThisFrame) return;
+                    VkBufferImageCopy region{};
+                    region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+                    region.imageExtent = {swapchainExtent.width, swapchainExtent.height, 1};
+                    vkd.cmdCopyImageToBuffer(ctx.cmd, ctx.graph->image(backbuffer), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                           readbackBuffer, 1, &region);
+                });
+        }
+
+        if (capture.enabled()) {
+            RGState hostRead{VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_HOST_BIT, VK_ACCESS_2_HOST_READ_BIT};
+            captureTarget = renderGraph->importBuffer("capture", VK_NULL_HANDLE,
+                                                      FrameCapture::frameBytes(swapchainExtent), RGState{}, hostRead);
+            renderGraph->addPass("capture",
+                [&](RenderGraph::PassBuilder &pass) {
+                    pass.read(backbuffer, RGUsage::TransferSrc);
+                    pass.write(captureTarget, RGUsage::TransferDst);
+                },
+                [this](RGPassContext &ctx) {
+                    VkBufferImageCopy region{};
+                    region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+                    region.imageExtent = {swapchainExtent.width, swapchainExtent.height, 1};
+                    vkd.cmdCopyImageToBuffer(ctx.cmd, ctx.graph->image(backbuffer), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                             ctx.graph->buffer(captureTarget), 1, &region);
+                });
+        }
+
+        renderGraph->compile();
+        if (gpuDriven) {
+            gpuCulling.graphCompiled(*renderGraph);
+        }
+        if (postEnabled) {
+            post.graphCompiled(*renderGraph);
+        }
+        const RenderGraphStats &stats = renderGraph->stats();
+        std::cout << "Render graph: " << stats.passCount << " passes (" << stats.culledPasses << " culled, "
+                  << stats.asyncPasses << " async compute), " << stats.segmentCount << " segments, "
+                  << stats.barrierCount << " barriers (" << stats.queueTransfers << " queue transfers), " << stats.transientBytes / (1024 * 1024) << " MiB transient ("
+                  << stats.transientBytesUnaliased / (1024 * 1024) << " MiB without aliasing)\n";
+    }
+
+    // Viewport and scissor are dynamic so a resize never invalidates the pipeline; only a
+    // surface format change does, since the color format is baked in for dynamic rendering.
+    void createGraphicsPipeline() {
+        ProfileZone zone(profiler, "createGraphicsPipeline");
+        if (pipelineLayout == VK_NULL_HANDLE) {
+            VkPushConstantRange pushRange{};
+            pushRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+            pushRange.offset = 0;
+            pushRange.size = sizeof(TrianglePushConstants);
+            static_assert(sizeof(TrianglePushConstants) >= GpuCulling::DRAW_PUSH_CONSTANTS_SIZE,
+                          "the scene layout's push range must cover the indirect draw's constants");
+
+            VkDescriptorSetLayout setLayout = bindless.layout();
+
+            VkPipelineLayoutCreateInfo layoutInfo{};
+            layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+            layoutInfo.setLayoutCount = setLayout != VK_NULL_HANDLE ? 1 : 0;
+            layoutInfo.pSetLayouts = &setLayout;
+            layoutInfo.pushConstantRangeCount = 1;
+            layoutInfo.pPushConstantRanges = &pushRange;
+            pipelineLayout = layouts.pipelineLayout(layoutInfo);
+        }
+
+        graphicsPipeline = createScenePipeline("triangle.vert.spv", VK_FORMAT_UNDEFINED);
+        if (gpuCullingReady) {
+            indirectPipeline = createScenePipeline("triangle_indirect.vert.spv", GpuCulling::DEPTH_FORMAT);
+        }
+    }
+
+    // Without a depth format the pipeline has no depth attachment and no depth test. A nonzero
+    // variant sets an otherwise unused depth bias, so each variant is a distinct pipeline.
+    VkPipeline createScenePipeline(const char *vertexShader, VkFormat depthFormat, uint32_t variant = 0) {
+        VkShaderModule vertModule = loadShaderModule(device, vertexShader);
+        VkShaderModule fragModule = loadShaderModule(device, "triangle.frag.spv");
+
+        VkPipelineShaderStageCreateInfo stages[2]{};
+        stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+        stages[0].module = vertModule;
+        stages[0].pName = "main";
+        stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+        stages[1].module = fragModule;
+        stages[1].pName = "main";
+
+        VkPipelineVertexInputStateCreateInfo vertexInput{};
+        vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+        VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+        inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+        inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+        VkPipelineViewportStateCreateInfo viewportState{};
+        viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+        viewportState.viewportCount = 1;
+        viewportState.scissorCount = 1;
+
+        VkPipelineRasterizationStateCreateInfo rasterizer{};
+        rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+        rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+        rasterizer.cullMode = VK_CULL_MODE_NONE;
+        rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
+        rasterizer.lineWidth = 1.0f;
+        rasterizer.depthBiasEnable = variant != 0 ? VK_TRUE : VK_FALSE;
+        rasterizer.depthBiasConstantFactor = static_cast<float>(variant);
+
+        VkPipelineMultisampleStateCreateInfo multisampling{};
+        multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+        multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+        VkPipelineColorBlendAttachmentState blendAttachment{};
+        blendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                                         VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+        VkPipelineColorBlendStateCreateInfo colorBlending{};
+        colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+        colorBlending.attachmentCount = 1;
+        colorBlending.pAttachments = &blendAttachment;
+
+        VkPipelineDepthStencilStateCreateInfo depthStencil{};
+        depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+        depthStencil.depthTestEnable = depthFormat != VK_FORMAT_UNDEFINED ? VK_TRUE : VK_FALSE;
+        depthStencil.depthWriteEnable = depthStencil.depthTestEnable;
+        depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+
+        VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+        VkPipelineDynamicStateCreateInfo dynamicState{};
+        dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+        dynamicState.dynamicStateCount = 2;
+        dynamicState.pDynamicStates = dynamicStates;
+
+        VkPipelineRenderingCreateInfo renderingInfo{};
+        renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+        VkFormat colorFormat = postEnabled ? PostProcess::HDR_FORMAT : swapchainImageFormat;
+        renderingInfo.colorAttachmentCount = 1;
+        renderingInfo.pColorAttachmentFormats = &colorFormat;
+        renderingInfo.depthAttachmentFormat = depthFormat;
+
+        VkGraphicsPipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipelineInfo.pNext = &renderingInfo;
+        pipelineInfo.stageCount = 2;
+        pipelineInfo.pStages = stages;
+        pipelineInfo.pVertexInputState = &vertexInput;
+        pipelineInfo.pInputAssemblyState = &inputAssembly;
+        pipelineInfo.pViewportState = &viewportState;
+        pipelineInfo.pRasterizationState = &rasterizer;
+        pipelineInfo.pMultisampleState = &multisampling;
+        pipelineInfo.pColorBlendState = &colorBlending;
+        pipelineInfo.pDepthStencilState = &depthStencil;
+        pipelineInfo.pDynamicState = &dynamicState;
+        pipelineInfo.layout = pipelineLayout;
+        pipelineInfo.renderPass = VK_NULL_HANDLE;
+
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        try {
+            pipeline = pipelineCache.createGraphicsPipeline(pipelineInfo);
+        } catch (...) {
+            vkDestroyShaderModule(device, fragModule, nullptr);
+            vkDestroyShaderModule(device, vertModule, nullptr);
+            throw;
+        }
+        vkDestroyShaderModule(device, fragModule, nullptr);
+        vkDestroyShaderModule(device, vertModule, nullptr);
+        return pipeline;
+    }
+
+    void createBindlessTable() {
+        if (!deviceFeatures.descriptorIndexing) {
+            std::cout << "Bindless descriptors unavailable (no descriptor indexing)\n";
+            return;
+        }
+        bindless.init(static_cast<VkPhysicalDevice>(physicalDevice), device, framesInFlight);
+    }
+
+    void createUploadService() {
+        ProfileZone zone(profiler, "createUploadService");
+        uploads.init(allocator, static_cast<VkPhysicalDevice>(physicalDevice),
+                     transferFamily.value(), transferQueue, graphicsFamily.value());
+    }
+
+    void createGpuCulling() {
+        if (!gpuDriven && benchIndirectObjects == 0) return;
+        if (bindless.set() == VK_NULL_HANDLE || !deviceFeatures.indirectDraws) {
+            std::cout << "GPU-driven rendering unavailable (needs descriptor indexing and indirect draws)\n";
+            gpuDriven = false;
+            return;
+        }
+        ProfileZone zone(profiler, "createGpuCulling");
+        gpuCulling.init(static_cast<VkPhysicalDevice>(physicalDevice), device, allocator, pipelineCache, layouts, bindless,
+                        deletionQueue);
+        gpuCullingReady = true;
+    }
+
+    void createPostProcess() {
+        if (!postEnabled) return;
+        if (bindless.set() == VK_NULL_HANDLE) {
+            std::cout << "Post-processing unavailable (needs descriptor indexing)\n";
+            postEnabled = false;
+            return;
+        }
+        ProfileZone zone(profiler, "createPostProcess");
+        post.init(device, pipelineCache, layouts, bindless);
+    }
+
+    void createUi() {
+        if (!uiEnabled) return;
+#ifdef VUK_HAS_IMGUI
+        if (bindless.set() == VK_NULL_HANDLE) {
+            std::cout << "UI overlay unavailable (needs descriptor indexing)\n";
+            uiEnabled = false;
+            return;
+        }
+        ProfileZone zone(profiler, "createUi");
+        ImGui::CreateContext();
+        ImGui::GetIO().IniFilename = nullptr;
+        ui.init(static_cast<VkPhysicalDevice>(physicalDevice), device, allocator, pipelineCache, layouts, bindless,
+                uploads, deletionQueue, swapchainImageFormat, framesInFlight);
+#else
+        std::cout << "UI overlay unavailable (built without Dear ImGui)\n";
+        uiEnabled = false;
+#endif
+    }
+
+    void destroyUi() {
+#ifdef VUK_HAS_IMGUI
+        if (!uiEnabled) return;
+        ui.destroy();
+        ImGui::DestroyContext();
+#endif
+    }
+
+    void uiColorFormatChanged() {
+#ifdef VUK_HAS_IMGUI
+        if (uiEnabled) ui.setColorFormat(swapchainImageFormat);
+#endif
+    }
+
+    // Feeds ImGui this frame's input and builds the overlay; the draw data is recorded later
+    // by the graph's UI pass
+    void buildUi() {
+#ifdef VUK_HAS_IMGUI
+        ProfileZone zone(profiler, "buildUi");
+        ImGuiIO &io = ImGui::GetIO();
+        auto now = std::chrono::steady_clock::now();
+        float dt = lastUiFrame == std::chrono::steady_clock::time_point{}
+                       ? 1.0f / 60.0f
+                       : std::chrono::duration<float>(now - lastUiFrame).count();
+        lastUiFrame = now;
+        io.DeltaTime = std::max(dt, 1e-4f);
+        io.DisplaySize = ImVec2(static_cast<float>(swapchainExtent.width), static_cast<float>(swapchainExtent.height));
+        if (window) {
+            // ImGui works in framebuffer pixels here, GLFW reports the cursor in window coordinates
+            int windowWidth = 0, windowHeight = 0;
+            glfwGetWindowSize(window, &windowWidth, &windowHeight);
+            double x = 0.0, y = 0.0;
+            glfwGetCursorPos(window, &x, &y);
+            float sx = windowWidth > 0 ? io.DisplaySize.x / static_cast<float>(windowWidth) : 1.0f;
+            float sy = windowHeight > 0 ? io.DisplaySize.y / static_cast<float>(windowHeight) : 1.0f;
+            io.AddMousePosEvent(static_cast<float>(x) * sx, static_cast<float>(y) * sy);
+            for (int button = 0; button < 3; ++button) {
+                io.AddMouseButtonEvent(button, glfwGetMouseButton(window, button) == GLFW_PRESS);
+            }
+        }
+
+        ImGui::NewFrame();
+        ImGui::SetNextWindowPos(ImVec2(10.0f, 10.0f), ImGuiCond_FirstUseEver);
+        ImGui::Begin("Stats", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+        ImGui::Text("%.2f ms/frame (%.0f FPS)", 1000.0f / io.Framerate, io.Framerate);
+        ImGui::Text("Record %.3f ms, %u objects (%s)", lastRecordMs, drawCount,
+                    gpuDriven ? "GPU-driven" : "CPU draws");
+        const RenderGraphStats &graphStats = renderGraph->stats();
+        ImGui::Text("Graph: %u passes, %u barriers", graphStats.passCount, graphStats.barrierCount);
+        const ImGuiRendererStats &uiStats = ui.stats();
+        ImGui::Text("UI: %u vertices, %u commands in %u draws", uiStats.vertices, uiStats.commands,
+                    uiStats.drawCalls);
+        ImGui::Text("UI ring: %llu KiB, grown %u times", static_cast<unsigned long long>(uiStats.ringBytes / 1024),
+                    uiStats.ringGrowths);
+        ImGui::End();
+
+        // Behind every window, so none of it is clipped away before reaching the renderer
+        if (uiStressRects != 0) {
+            ImDrawList *drawList = ImGui::GetBackgroundDrawList();
+            uint32_t columns = std::max(swapchainExtent.width / 8, 1u);
+            for (uint32_t i = 0; i < uiStressRects; ++i) {
+                float x = static_cast<float>(i % columns) * 8.0f;
+                float y = static_cast<float>((i / columns) * 8 % std::max(swapchainExtent.height, 1u));
+                drawList->AddRectFilled(ImVec2(x, y), ImVec2(x + 6.0f, y + 6.0f), IM_COL32(255, 255, 255, 48));
+            }
+        }
+        ImGui::Render();
+#endif
+    }
+
+    void recordUi(VkCommandBuffer cmd) {
+#ifdef VUK_HAS_IMGUI
+        ui.record(cmd, ImGui::GetDrawData(), currentFrame);
+#else
+        (void)cmd;
+#endif
+    }
+
+    // drawCount objects on a square grid covering the [-1, 1] square; a single one fills it.
+    // The GPU must not be using the previous scene.
+    void createScene() {
+        scene.clear();
+        scene.reserve(drawCount);
+        uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(std::max(drawCount, 1u)))));
+        float cell = 2.0f / static_cast<float>(side);
+        for (uint32_t i = 0; i < drawCount; ++i) {
+            SceneObjectDesc desc;
+            if (drawCount != 1) {
+                desc.x = -1.0f + cell * (static_cast<float>(i % side) + 0.5f);
+                desc.y = -1.0f + cell * (static_cast<float>(i / side) + 0.5f);
+                desc.scale = cell;
+                desc.hue = static_cast<float>(i) / static_cast<float>(drawCount);
+            }
+            desc.depth = 0.25f + 0.5f * desc.hue;
+            desc.radius = TRIANGLE_BOUNDS_RADIUS;
+            scene.add(desc);
+        }
+        // On the calling thread: at startup this already runs as a job
+        scene.updateTransforms(nullptr);
+        if (gpuCullingReady) {
+            sceneObjects.assign(scene.size(), GpuObject{});
+            for (uint32_t i = 0; i < scene.size(); ++i) {
+                GpuObject &obj = sceneObjects[i];
+                obj.offset[0] = scene.worldX(i);
+                obj.offset[1] = scene.worldY(i);
+                obj.scale = scene.worldScale(i);
+                obj.hue = scene.hue(i);
+                obj.depth = scene.depth(i);
+                obj.radius = scene.worldRadius(i);
+            }
+            gpuCulling.setObjects(uploads, sceneObjects);
+        }
+    }
+
+    void createFrameResources() {
+        ProfileZone zone(profiler, "createFrameResources");
+        frames.resize(framesInFlight);
+
+        for (auto &frame : frames) {
+            VkCommandPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            poolInfo.queueFamilyIndex = graphicsFamily.value();
+            if (vkCreateCommandPool(device, &poolInfo, nullptr, &frame.commandPool) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create command pool!");
+            }
+
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.commandPool = frame.commandPool;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandBufferCount = 1;
+            if (vkd.allocateCommandBuffers(device, &allocInfo, &frame.commandBuffer) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to allocate command buffer!");
+            }
+
+            VkSemaphoreCreateInfo semInfo{};
+            semInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+            // Fences start signalled so the first wait on each frame returns immediately
+            VkFenceCreateInfo fenceInfo{};
+            fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+            if (vkCreateSemaphore(device, &semInfo, nullptr, &frame.imageAvailable) != VK_SUCCESS ||
+                vkCreateFence(device, &fenceInfo, nullptr, &frame.inFlight) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create frame synchronization objects!");
+            }
+
+            if (computeQueue != VK_NULL_HANDLE) {
+                poolInfo.queueFamilyIndex = computeFamily.value();
+                if (vkCreateCommandPool(device, &poolInfo, nullptr, &frame.computePool) != VK_SUCCESS) {
+                    throw std::runtime_error("Failed to create compute command pool!");
+                }
+            }
+        }
+        currentFrame = 0;
+
+        VkSemaphoreTypeCreateInfo timelineInfo{};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        timelineInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        timelineInfo.initialValue = 0;
+        VkSemaphoreCreateInfo timelineSemInfo{};
+        timelineSemInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        timelineSemInfo.pNext = &timelineInfo;
+        if (vkCreateSemaphore(device, &timelineSemInfo, nullptr, &graphTimeline) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create render graph timeline semaphore!");
+        }
+        // Timestamp queries are owned per frame slot as well
+        profiler.initGpu(static_cast<VkPhysicalDevice>(physicalDevice), device, graphicsFamily.value(), framesInFlight);
+    }
+
+    void destroyFrameResources() {
+        for (auto &frame : frames) {
+            vkDestroyFence(device, frame.inFlight, nullptr);
+            vkDestroySemaphore(device, frame.imageAvailable, nullptr);
+            // Destroying the pool frees its command buffers
+            vkDestroyCommandPool(device, frame.commandPool, nullptr);
+            if (frame.computePool != VK_NULL_HANDLE) vkDestroyCommandPool(device, frame.computePool, nullptr);
+        }
+        frames.clear();
+        if (graphTimeline != VK_NULL_HANDLE) vkDestroySemaphore(device, graphTimeline, nullptr);
+        graphTimeline = VK_NULL_HANDLE;
+    }
+
+    void createRecorder() {
+        ProfileZone zone(profiler, "createRecorder");
+        recorder.init(device, graphicsFamily.value(), jobs.workerCount(), framesInFlight);
+    }
+
+    // The camera is applied on the CPU, so triangle.vert only scales and offsets
+    TrianglePushConstants drawConstants(uint32_t i) const {
+        TrianglePushConstants push{};
+        push.offset[0] = (scene.worldX(i) - cameraCenter[0]) * cameraZoom;
+        push.offset[1] = (scene.worldY(i) - cameraCenter[1]) * cameraZoom;
+        push.scale = scene.worldScale(i) * cameraZoom;
+        push.hue = scene.hue(i);
+        return push;
+    }
+
+    // Propagates moved transforms, culls against the camera (the frustum half of
+    // shaders/cull.comp, so both paths skip the same objects) and sorts the survivors into
+    // draw order for recordDraws()
+    void prepareSceneDraws() {
+        ProfileZone zone(profiler, "prepareSceneDraws");
+        scene.updateTransforms(&jobs);
+        scene.cull(cameraCenter[0], cameraCenter[1], cameraZoom, &jobs);
+        scene.sortDrawKeys();
+    }
+
+    void bindSceneState(VkCommandBuffer cmd, VkPipeline pipeline) {
+        VkViewport viewport{};
+        viewport.width = static_cast<float>(swapchainExtent.width);
+        viewport.height = static_cast<float>(swapchainExtent.height);
+        viewport.maxDepth = 1.0f;
+        VkRect2D scissor{{0, 0}, swapchainExtent};
+        vkd.cmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+        // One bind covers every draw; per-draw resources are bindless handles in push constants
+        if (bindless.set() != VK_NULL_HANDLE) {
+            bindless.bind(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout);
+        }
+        vkd.cmdSetViewport(cmd, 0, 1, &viewport);
+        vkd.cmdSetScissor(cmd, 0, 1, &scissor);
+    }
+
+    // Draws [begin, end) of the sorted visible list. Secondary command buffers inherit nothing
+    // but the attachment formats, so every range sets its own pipeline and dynamic state.
+    void recordDraws(VkCommandBuffer cmd, uint32_t begin, uint32_t end) {
+        bindSceneState(cmd, graphicsPipeline);
+        for (uint32_t k = begin; k < end; ++k) {
+            TrianglePushConstants push = drawConstants(scene.drawIndex(k));
+            vkd.cmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(push), &push);
+            vkd.cmdDraw(cmd, 3, 1, 0, 0);
+        }
+    }
+
+    // A few jobs per worker so stealing can even out uneven progress
+    uint32_t drawsPerJob(uint32_t draws) const {
+        uint32_t jobCount = jobs.workerCount() * 4;
+        return std::max(MIN_DRAWS_PER_JOB, (draws + jobCount - 1) / jobCount);
+    }
+
+    const std::vector<VkCommandBuffer> &recordDrawsParallel() {
+        VkCommandBufferInheritanceInfo inheritance{};
+        inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritance.pNext = &renderGraph->renderingInheritance(scenePass);
+
+        uint32_t draws = scene.visibleCount();
+        return recorder.record(jobs, draws, drawsPerJob(draws), inheritance,
+                               [this](VkCommandBuffer cmd, uint32_t begin, uint32_t end) {
+                                   ProfileZone zone(profiler, "recordDraws");
+                                   recordDraws(cmd, begin, end);
+                               });
+    }
+
+    // Command buffer of the frame for a render graph segment; segment 0 uses frame.commandBuffer
+    VkCommandBuffer segmentCommandBuffer(FrameData &frame, uint32_t segment) {
+        if (segment == 0) return frame.commandBuffer;
+        bool async = renderGraph->isAsyncSegment(segment);
+        std::vector<VkCommandBuffer> &buffers = async ? frame.computeSegments : frame.graphicsSegments;
+        if (buffers.size() <= segment) buffers.resize(segment + 1, VK_NULL_HANDLE);
+        if (buffers[segment] == VK_NULL_HANDLE) {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.commandPool = async ? frame.computePool : frame.commandPool;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandBufferCount = 1;
+            if (vkd.allocateCommandBuffers(device, &allocInfo, &buffers[segment]) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to allocate command buffer!");
+            }
+        }
+        return buffers[segment];
+    }
+
+    // Records every segment of the graph; frame setup goes into segment 0. Returns the upload
+    // timeline wait the submission of segment 0 has to carry.
+    UploadWait recordCommandBuffer(FrameData &frame, uint32_t imageIndex, bool readback) {
+        ProfileZone zone(profiler, "record");
+        auto start = std::chrono::steady_clock::now();
+        VkCommandBuffer cmd = frame.commandBuffer;
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        if (vkd.beginCommandBuffer(cmd, &beginInfo) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to begin recording command buffer!");
+        }
+        profiler.beginFrame(cmd, currentFrame);
+
+        // Take ownership of everything the upload service finished since the last frame
+        UploadWait uploadWait = uploads.recordPendingAcquires(cmd);
+
+        if (gpuDriven) {
+            gpuCulling.setView(cameraCenter[0], cameraCenter[1], cameraZoom);
+            gpuCulling.recordPendingInit(cmd);
+        }
+
+        // Small frames aren't worth the fan-out; record them inline on this thread. The
+        // GPU-driven scene is a single draw.
+        if (!gpuDriven) {
+            prepareSceneDraws();
+        }
+        recordParallel = !gpuDriven && jobs.workerCount() > 1 && scene.visibleCount() >= 2 * MIN_DRAWS_PER_JOB;
+        readbackThisFrame = readback;
+        if (uiEnabled) {
+            buildUi();
+        }
+        renderGraph->setSecondaryContents(scenePass, recordParallel);
+        renderGraph->setFrameSlot(currentFrame);
+        renderGraph->setImportedImage(backbuffer, swapchainImages[imageIndex], swapchainImageViews[imageIndex]);
+        if (capture.enabled()) {
+            renderGraph->setImportedBuffer(captureTarget,
+                                           capture.acquire(frameNumber, swapchainExtent, swapchainImageFormat));
+        }
+        renderGraph->executeSegment(0, cmd);
+        if (vkd.endCommandBuffer(cmd) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to record command buffer!");
+        }
+
+        for (uint32_t segment = 1; segment < renderGraph->segmentCount(); ++segment) {
+            VkCommandBuffer segmentCmd = segmentCommandBuffer(frame, segment);
+            if (vkd.beginCommandBuffer(segmentCmd, &beginInfo) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to begin recording command buffer!");
+            }
+            renderGraph->executeSegment(segment, segmentCmd);
+            if (vkd.endCommandBuffer(segmentCmd) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to record command buffer!");
+            }
+        }
+        lastRecordMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return uploadWait;
+    }
+
+    // Submits the graph's segments in order, each to its queue. Segments are chained through
+    // graphTimeline: segment s of this frame signals base + s + 1, and waits either on a value
+    // of this frame or on the value its previous execution signalled. acquireSemaphore is
+    // waited on by the first segment touching the backbuffer; the last segment signals
+    // signalSemaphore and the frame's fence. Either semaphore may be VK_NULL_HANDLE.
+    void submitFrame(FrameData &frame, VkSemaphore acquireSemaphore, const UploadWait &uploadWait,
+                     VkSemaphore signalSemaphore) {
+        ProfileZone zone(profiler, "submit");
+        uint32_t count = renderGraph->segmentCount();
+        uint32_t acquireSegment = renderGraph->firstSegment(backbuffer);
+        uint64_t base = graphTimelineValue;
+        bool chained = count > 1;
+
+        for (uint32_t s = 0; s < count; ++s) {
+            std::vector<VkSemaphoreSubmitInfo> waits;
+            auto addWait = [&](VkSemaphore semaphore, uint64_t value, VkPipelineStageFlags2 stages) {
+                VkSemaphoreSubmitInfo info{};
+                info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+                info.semaphore = semaphore;
+                info.value = value;
+                info.stageMask = stages;
+                waits.push_back(info);
+            };
+            if (s == acquireSegment && acquireSemaphore != VK_NULL_HANDLE) {
+                addWait(acquireSemaphore, 0, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT);
+            }
+            if (s == 0 && uploadWait.value != 0) {
+                addWait(uploads.timeline(), uploadWait.value, static_cast<VkPipelineStageFlags2>(uploadWait.stages));
+            }
+            for (const RGSegmentWait &w : renderGraph->segmentWaits(s)) {
+                if (!w.previousExecution) {
+                    addWait(graphTimeline, base + w.segment + 1, w.stages);
+                } else if (w.segment < previousSegmentValues.size()) {
+                    // Nothing to wait for on the first execution of the graph
+                    addWait(graphTimeline, previousSegmentValues[w.segment], w.stages);
+                }
+            }
+
+            std::vector<VkSemaphoreSubmitInfo> signals;
+            if (chained) {
+                VkSemaphoreSubmitInfo info{};
+                info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+                info.semaphore = graphTimeline;
+                info.value = base + s + 1;
+                info.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+                signals.push_back(info);
+            }
+            bool last = s + 1 == count;
+            if (last && signalSemaphore != VK_NULL_HANDLE) {
+                VkSemaphoreSubmitInfo info{};
+                info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+                info.semaphore = signalSemaphore;
+                info.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+                signals.push_back(info);
+            }
+
+            VkCommandBufferSubmitInfo cmdInfo{};
+            cmdInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+            cmdInfo.commandBuffer = segmentCommandBuffer(frame, s);
+
+            VkSubmitInfo2 submitInfo{};
+            submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+            submitInfo.waitSemaphoreInfoCount = static_cast<uint32_t>(waits.size());
+            submitInfo.pWaitSemaphoreInfos = waits.data();
+            submitInfo.commandBufferInfoCount = 1;
+            submitInfo.pCommandBufferInfos = &cmdInfo;
+            submitInfo.signalSemaphoreInfoCount = static_cast<uint32_t>(signals.size());
+            submitInfo.pSignalSemaphoreInfos = signals.data();
+            VkQueue queue = renderGraph->isAsyncSegment(s) ? computeQueue : graphicsQueue;
+            if (vkd.queueSubmit2(queue, 1, &submitInfo, last ? frame.inFlight : VK_NULL_HANDLE) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to submit draw command buffer!");
+            }
+        }
+
+        if (chained) {
+            previousSegmentValues.resize(count);
+            for (uint32_t s = 0; s < count; ++s) previousSegmentValues[s] = base + s + 1;
+            graphTimelineValue += count;
+        }
+    }
+
+    void resetFrameCommandPools(FrameData &frame) {
+        vkd.resetCommandPool(device, frame.commandPool, 0);
+        if (frame.computePool != VK_NULL_HANDLE) vkd.resetCommandPool(device, frame.computePool, 0);
+    }
+
+    // Headless frames render into the target owned by the frame slot; there is nothing to
+    // acquire or present, so the fence alone orders reuse.
+    void drawHeadlessFrame(bool readback) {
+        FrameData &frame = frames[currentFrame];
+        {
+            ProfileZone zone(profiler, "waitFence", true);
+            vkd.waitForFences(device, 1, &frame.inFlight, VK_TRUE, UINT64_MAX);
+        }
+        deletionQueue.beginFrame(frameNumber);
+        if (capture.enabled()) capture.beginFrame(frameNumber);
+        frameAllocator.beginFrame(currentFrame);
+        bindless.beginFrame(frameNumber);
+        if (streamerReady) streamer.beginFrame(frameNumber);
+        vkd.resetFences(device, 1, &frame.inFlight);
+        resetFrameCommandPools(frame);
+        recorder.beginFrame(currentFrame);
+        if (streamerReady) streamer.update();
+        uploads.flush();
+        UploadWait uploadWait = recordCommandBuffer(frame, currentFrame, readback);
+        submitFrame(frame, VK_NULL_HANDLE, uploadWait, VK_NULL_HANDLE);
+        profiler.endFrame();
+        if (frameNumber == 0) printFirstFrame();
+
+        ++frameNumber;
+        currentFrame = (currentFrame + 1) % framesInFlight;
+    }
+
+    void drawFrame() {
+        FrameData &frame = frames[currentFrame];
+
+        // Only blocks if the GPU is still working on the frame recorded framesInFlight ago
+        {
+            ProfileZone zone(profiler, "waitFence", true);
+            vkd.waitForFences(device, 1, &frame.inFlight, VK_TRUE, UINT64_MAX);
+        }
+        deletionQueue.beginFrame(frameNumber);
+        if (capture.enabled()) capture.beginFrame(frameNumber);
+        frameAllocator.beginFrame(currentFrame);
+        bindless.beginFrame(frameNumber);
+        if (streamerReady) streamer.beginFrame(frameNumber);
+
+        uint32_t imageIndex = 0;
+        VkResult result;
+        {
+            ProfileZone zone(profiler, "acquire", true);
+            result = vkd.acquireNextImageKHR(device, swapchain, UINT64_MAX, frame.imageAvailable, VK_NULL_HANDLE, &imageIndex);
+        }
+        if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+            recreateSwapchain();
+            return;
+        } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+            throw std::runtime_error("Failed to acquire swap chain image!");
+        }
+
+        // Reset only once we know work will be submitted, otherwise the early return
+        // above would leave the fence unsignalled and deadlock the next wait.
+        vkd.resetFences(device, 1, &frame.inFlight);
+        resetFrameCommandPools(frame);
+        recorder.beginFrame(currentFrame);
+        if (streamerReady) streamer.update();
+        // Uploads requested since the last frame go out as one batch on the transfer queue
+        uploads.flush();
+        UploadWait uploadWait = recordCommandBuffer(frame, imageIndex, false);
+        submitFrame(frame, frame.imageAvailable, uploadWait, renderFinished[imageIndex]);
+        profiler.endFrame();
+        if (frameNumber == 0) printFirstFrame();
+
+        VkPresentInfoKHR presentInfo{};
+        presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+        presentInfo.waitSemaphoreCount = 1;
+        presentInfo.pWaitSemaphores = &renderFinished[imageIndex];
+        presentInfo.swapchainCount = 1;
+        presentInfo.pSwapchains = &swapchain;
+        presentInfo.pImageIndices = &imageIndex;
+        pacer.preparePresent(presentInfo);
+
+        ++frameNumber;
+
+        {
+            ProfileZone zone(profiler, "present");
+            result = vkd.queuePresentKHR(presentQueue, &presentInfo);
+        }
+        pacer.framePresented();
+        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebufferResized) {
+            recreateSwapchain();
+        } else if (result != VK_SUCCESS) {
+            throw std::runtime_error("Failed to present swap chain image!");
+        }
+
+        currentFrame = (currentFrame + 1) % framesInFlight;
+    }
+
+    // Immediate; the GPU must be idle
+    void cleanupSwapchain() {
+        if (renderGraph) {
+            renderGraph->destroy();
+            renderGraph.reset();
+        }
+        if (headless) {
+            destroyOffscreenTargets();
+            return;
+        }
+        for (auto iv : swapchainImageViews) vkDestroyImageView(device, iv, nullptr);
+        swapchainImageViews.clear();
+        for (VkSemaphore semaphore : renderFinished) vkDestroySemaphore(device, semaphore, nullptr);
+        renderFinished.clear();
+        if (swapchain != VK_NULL_HANDLE) vkDestroySwapchainKHR(device, swapchain, nullptr);
+        swapchain = VK_NULL_HANDLE;
+        swapchainImages.clear();
+    }
+
+    // Its transient resources may be in use by frames in flight
+    void retireRenderGraph() {
+        if (!renderGraph) return;
+        std::shared_ptr<RenderGraph> graph(std::move(renderGraph));
+        deletionQueue.defer([graph] { graph->destroy(); });
+    }
+
+    void recreateSwapchain() {
+        ProfileZone zone(profiler, "recreateSwapchain");
+        // A minimized window has a zero-sized framebuffer; wait until it is restored
+        int width = 0, height = 0;
+        glfwGetFramebufferSize(window, &width, &height);
+        while (width == 0 || height == 0) {
+            glfwWaitEvents();
+            glfwGetFramebufferSize(window, &width, &height);
+        }
+
+        // Frames in flight may still reference the old objects; nothing waits for the device
+        retireRenderGraph();
+        for (VkImageView view : swapchainImageViews) deletionQueue.destroyImageView(view);
+        swapchainImageViews.clear();
+        // Presents of the old images may still be waiting on these
+        for (VkSemaphore semaphore : renderFinished) {
+            deletionQueue.defer([this, semaphore] { vkDestroySemaphore(device, semaphore, nullptr); });
+        }
+        renderFinished.clear();
+        VkSwapchainKHR oldSwapchain = swapchain;
+
+        VkFormat previousFormat = swapchainImageFormat;
+        createSwapchain();
+        createImageViews();
+        deletionQueue.destroySwapchain(oldSwapchain);
+
+        // The pipeline only depends on the attachment format, so a plain resize keeps it
+        if (swapchainImageFormat != previousFormat) {
+            deletionQueue.destroyPipeline(graphicsPipeline);
+            deletionQueue.destroyPipeline(indirectPipeline);
+            indirectPipeline = VK_NULL_HANDLE;
+            createGraphicsPipeline();
+            uiColorFormatChanged();
+        }
+        // Transient sizes follow the swapchain extent
+        buildRenderGraph();
+
+        framebufferResized = false;
+    }
+
+    void retrieveQueues() {
+        if (device == VK_NULL_HANDLE) return;
+        if (!graphicsFamily.has_value()) return;
+
+        vkGetDeviceQueue(device, graphicsFamily.value(), 0, &graphicsQueue);
+        if (presentFamily.has_value()) {
+            vkGetDeviceQueue(device, presentFamily.value(), 0, &presentQueue);
+        }
+        if (transferFamily.has_value()) {
+            vkGetDeviceQueue(device, transferFamily.value(), 0, &transferQueue);
+        } else {
+            transferFamily = graphicsFamily;
+            transferQueue = graphicsQueue;
+        }
+        if (computeFamily.has_value()) {
+            vkGetDeviceQueue(device, computeFamily.value(), computeQueueIndex, &computeQueue);
+        }
+
+        std::cout << "Retrieved queues: graphics=" << graphicsQueue << " present=" << presentQueue
+                  << " transfer=" << transferQueue
+                  << (transferFamily != graphicsFamily ? " (dedicated family)" : " (shared with graphics)")
+                  << " compute=" << computeQueue << "\n";
+    }
+
+    void createInstance() {
+        ProfileZone zone(profiler, "createInstance");
+        // Application info
+        vk::ApplicationInfo appInfo{};
+        appInfo.pApplicationName = "Hello Triangle";
+        appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+        appInfo.pEngineName = "No Engine";
+        appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+        appInfo.apiVersion = vk::ApiVersion14;
+
+        // Create RAII context early so we can query available layers/extensions
+        context = std::make_unique<vk::raii::Context>();
+
+        // Query available layers and extensions
+        auto availableLayers = vk::enumerateInstanceLayerProperties();
+        auto availableExtensions = vk::enumerateInstanceExtensionProperties();
+
+        // Decide whether to enable validation layers at build-time via macro
+#ifdef ENABLE_VALIDATION_LAYERS
+        const bool requestValidationLayers = true;
+#else
+        const bool requestValidationLayers = false;
+#endif
+
+        const char* validationLayerName = "VK_LAYER_KHRONOS_validation";
+        bool validationLayerPresent = false;
+        for (auto const &layer : availableLayers) {
+            if (std::string(layer.layerName.data()) == validationLayerName) {
+                validationLayerPresent = true;
+                break;
+            }
+        }
+
+        // Get required extensions from GLFW (headless needs no surface extensions)
+        std::vector<const char*> extensions;
+        if (!headless) {
+            uint32_t glfwExtensionCount = 0;
+            const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+            if (glfwExtensions != nullptr) {
+                extensions.insert(extensions.end(), glfwExtensions, glfwExtensions + glfwExtensionCount);
+            }
+        }
+
+        // Only enable debug utils if available
+        bool debugUtilsAvailable = false;
+        for (auto const &ext : availableExtensions) {
+            if (std::string(ext.extensionName.data()) == VK_EXT_DEBUG_UTILS_EXTENSION_NAME) {
+                debugUtilsAvailable = true;
+                break;
+            }
+        }
+        if (debugUtilsAvailable) {
+            extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+        }
+
+        // Build lists of enabled layers/extensions
+        std::vector<const char*> enabledLayers;
+        if (requestValidationLayers && validationLayerPresent) {
+            enabledLayers.push_back(validationLayerName);
+        }
+
+        // Instance create info
+        vk::InstanceCreateInfo createInfo{};
+        createInfo.pApplicationInfo = &appInfo;
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+        createInfo.ppEnabledExtensionNames = extensions.empty() ? nullptr : extensions.data();
+        createInfo.enabledLayerCount = static_cast<uint32_t>(enabledLayers.size());
+        createInfo.ppEnabledLayerNames = enabledLayers.empty() ? nullptr : enabledLayers.data();
+
+        // Create instance
+        instance = std::make_unique<vk::raii::Instance>(*context, createInfo);
+
+        // Setup debug messenger only if extension available and layer requested
+        if (debugUtilsAvailable && requestValidationLayers && validationLayerPresent) {
+            vk::DebugUtilsMessengerCreateInfoEXT debugCreateInfo{};
+            debugCreateInfo.messageSeverity = vk::DebugUtilsMessageSeverityFlagBitsEXT::eWarning |
+                                             vk::DebugUtilsMessageSeverityFlagBitsEXT::eError;
+            debugCreateInfo.messageType = vk::DebugUtilsMessageTypeFlagBitsEXT::eGeneral |
+                                          vk::DebugUtilsMessageTypeFlagBitsEXT::eValidation |
+                                          vk::DebugUtilsMessageTypeFlagBitsEXT::ePerformance;
+            debugMessages.init();
+            debugCreateInfo.pfnUserCallback = reinterpret_cast<vk::PFN_DebugUtilsMessengerCallbackEXT>(DebugMessageSink::callback);
+            debugCreateInfo.pUserData = &debugMessages;
+            debugMessenger = std::make_unique<vk::raii::DebugUtilsMessengerEXT>(*instance, debugCreateInfo);
+        }
+    }
+
+    void createSurface() {
+        VkSurfaceKHR c_surface;
+        if (glfwCreateWindowSurface(static_cast<VkInstance>(static_cast<vk::Instance>(*instance)), window, nullptr, &c_surface) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create window surface!");
+        }
+        surface = std::make_unique<vk::raii::SurfaceKHR>(*instance, vk::SurfaceKHR(c_surface));
+    }
+
+    struct QueueFamilyIndices {
+        std::optional<uint32_t> graphicsFamily;
+        std::optional<uint32_t> presentFamily;
+        // Transfer-capable family without graphics; empty means uploads share the graphics queue
+        std::optional<uint32_t> transferFamily;
+        // Compute family without graphics; empty means async compute passes run on the graphics queue
+        std::optional<uint32_t> computeFamily;
+        // Queue of computeFamily to use; 1 when it shares the transfer family and has a second queue
+        uint32_t computeQueueIndex = 0;
+
+        // Headless devices only need a graphics queue
+        bool isComplete(bool requirePresent = true) {
+            return graphicsFamily.has_value() && (!requirePresent || presentFamily.has_value());
+        }
+    };
+
+    QueueFamilyIndices findQueueFamilies(vk::PhysicalDevice pd) {
+        QueueFamilyIndices indices;
+
+        auto queueFamilies = pd.getQueueFamilyProperties();
+        uint32_t i = 0;
+        for (const auto &qf : queueFamilies) {
+            if (qf.queueFlags & vk::QueueFlagBits::eGraphics) {
+                indices.graphicsFamily = i;
+            }
+
+            if (surface) {
+                VkBool32 presentSupport = VK_FALSE;
+                VkPhysicalDevice vkpd = static_cast<VkPhysicalDevice>(pd);
+                vk::SurfaceKHR surf = static_cast<vk::SurfaceKHR>(*surface);
+                VkSurfaceKHR vksurf = static_cast<VkSurfaceKHR>(surf);
+                vkGetPhysicalDeviceSurfaceSupportKHR(vkpd, i, vksurf, &presentSupport);
+                if (presentSupport == VK_TRUE) {
+                    indices.presentFamily = i;
+                }
+            }
+
+            if (indices.isComplete(surface != nullptr)) break;
+            ++i;
+        }
+
+        // Prefer a transfer-only family (usually backed by a DMA engine) over an async compute one
+        i = 0;
+        for (const auto &qf : queueFamilies) {
+            bool transfer = static_cast<bool>(qf.queueFlags & vk::QueueFlagBits::eTransfer);
+            bool graphics = static_cast<bool>(qf.queueFlags & vk::QueueFlagBits::eGraphics);
+            bool compute = static_cast<bool>(qf.queueFlags & vk::QueueFlagBits::eCompute);
+            if (transfer && !graphics) {
+                if (!compute) {
+                    indices.transferFamily = i;
+                    break;
+                }
+                if (!indices.transferFamily.has_value()) {
+                    indices.transferFamily = i;
+                }
+            }
+            ++i;
+        }
+
+        // Async compute prefers a family of its own so it doesn't queue up behind uploads
+        i = 0;
+        for (const auto &qf : queueFamilies) {
+            bool graphics = static_cast<bool>(qf.queueFlags & vk::QueueFlagBits::eGraphics);
+            bool compute = static_cast<bool>(qf.queueFlags & vk::QueueFlagBits::eCompute);
+            if (compute && !graphics) {
+                if (indices.transferFamily != i) {
+                    indices.computeFamily = i;
+                    indices.computeQueueIndex = 0;
+                    break;
+                }
+                if (!indices.computeFamily.has_value()) {
+                    indices.computeFamily = i;
+                    indices.computeQueueIndex = qf.queueCount > 1 ? 1 : 0;
+                }
+            }
+            ++i;
+        }
+
+        return indices;
+    }
+
+    bool isDeviceSuitable(vk::PhysicalDevice pd, const DeviceFeatures &supported) {
+        if (!supported.missingRequired().empty()) {
+            return false;
+        }
+
+        // No present or swapchain requirement, so software rasterizers qualify
+        auto indices = findQueueFamilies(pd);
+        if (headless) {
+            return indices.isComplete(false);
+        }
+        return indices.isComplete() && supported.swapchain;
+    }
+
+    // Scores every suitable device and takes the best one, unless --device or VUK_DEVICE
+    // names a specific device. The first suitable device is often the wrong one: hybrid
+    // laptops list the integrated GPU first and lavapipe can show up next to a real GPU.
+    void pickPhysicalDevice() {
+        ProfileZone zone(profiler, "pickPhysicalDevice");
+        std::string override = deviceOverride;
+        if (override.empty()) {
+            if (const char *env = std::getenv("VUK_DEVICE")) override = env;
+        }
+
+        // Use RAII container to enumerate physical devices and obtain vk::PhysicalDevice handles
+        vk::raii::PhysicalDevices devices(*instance);
+        int64_t bestScore = -1;
+        bool overrideMatched = false;
+        std::cout << "Available physical devices:\n";
+        for (uint32_t i = 0; i < devices.size(); ++i) {
+            vk::PhysicalDevice pd = static_cast<vk::PhysicalDevice>(devices[i]);
+            VkPhysicalDevice vkpd = static_cast<VkPhysicalDevice>(pd);
+            VkPhysicalDeviceProperties props{};
+            vkGetPhysicalDeviceProperties(vkpd, &props);
+
+            DeviceFeatures supported = queryDeviceFeatures(vkpd);
+            bool suitable = isDeviceSuitable(pd, supported);
+            int64_t score = suitable ? scorePhysicalDevice(vkpd, supported) : -1;
+            std::cout << " [" << i << "] " << props.deviceName << " (type=" << static_cast<int>(props.deviceType) << ") ";
+            if (suitable) {
+                std::cout << "score " << score << ", optional: " << supported.describeOptional() << "\n";
+            } else {
+                std::string missing = supported.missingRequired();
+                std::cout << "unsuitable" << (missing.empty() ? "" : ", missing " + missing) << "\n";
+            }
+
+            if (!override.empty()) {
+                if (overrideMatched || !matchesDeviceOverride(override, i, props.deviceName)) continue;
+                if (!suitable) {
+                    throw std::runtime_error("Requested device " + std::string(props.deviceName) + " is not suitable!");
+                }
+                overrideMatched = true;
+                physicalDevice = pd;
+                deviceFeatures = supported;
+            } else if (suitable && score > bestScore) {
+                bestScore = score;
+                physicalDevice = pd;
+                deviceFeatures = supported;
+            }
+        }
+
+        if (!override.empty() && !overrideMatched) {
+            throw std::runtime_error("No physical device matches \"" + override + "\"!");
+        }
+        if (static_cast<VkPhysicalDevice>(physicalDevice) == VK_NULL_HANDLE) {
+            throw std::runtime_error("Failed to find a suitable GPU!");
+        }
+    }
+
+    void createLogicalDevice() {
+        ProfileZone zone(profiler, "createLogicalDevice");
+        auto indices = findQueueFamilies(physicalDevice);
+        graphicsFamily = indices.graphicsFamily;
+        presentFamily = indices.presentFamily;
+        transferFamily = indices.transferFamily;
+        computeFamily = indices.computeFamily;
+        computeQueueIndex = indices.computeQueueIndex;
+
+        std::set<uint32_t> uniqueQueueFamilies = {graphicsFamily.value()};
+        if (presentFamily.has_value()) {
+            uniqueQueueFamilies.insert(presentFamily.value());
+        }
+        if (transferFamily.has_value()) {
+            uniqueQueueFamilies.insert(transferFamily.value());
+        }
+        if (computeFamily.has_value()) {
+            uniqueQueueFamilies.insert(computeFamily.value());
+        }
+
+        float queuePriorities[] = {1.0f, 1.0f};
+        std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
+        for (uint32_t queueFamily : uniqueQueueFamilies) {
+            VkDeviceQueueCreateInfo qi{};
+            qi.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+            qi.queueFamilyIndex = queueFamily;
+            qi.queueCount = computeFamily == queueFamily ? computeQueueIndex + 1 : 1;
+            qi.pQueuePriorities = queuePriorities;
+            queueCreateInfos.push_back(qi);
+        }
+
+        // Required features plus every optional one the device supports
+        DeviceFeatureChain featureChain;
+        featureChain.build(deviceFeatures, !headless);
+
+        VkDeviceCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
+        createInfo.pQueueCreateInfos = queueCreateInfos.data();
+        featureChain.apply(createInfo);
+
+        VkResult res = vkCreateDevice(static_cast<VkPhysicalDevice>(physicalDevice), &createInfo, nullptr, &device);
+        if (res != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create logical device!");
+        }
+        deviceFeatures = featureChain.enabled();
+        std::cout << "Enabled optional device features: " << deviceFeatures.describeOptional() << "\n";
+        loadDeviceDispatch(device, !headless);
+    }
+
+    // Records drawCount draws into secondaries on 1..K workers (no submission) and reports the
+    // average CPU time per frame. Uses frame slot 0, which nothing else touches in this mode.
+    void runRecordBenchmark() {
+        const uint32_t maxThreads = jobs.workerCount();
+        const uint32_t iterations = 20;
+        drawCount = benchRecordDraws;
+        createScene();
+        prepareSceneDraws();
+
+        std::cout << "Recording " << drawCount << " draws, " << iterations << " iterations\n";
+        std::cout << "threads  ms/frame  speedup\n";
+        double baseline = 0.0;
+        for (uint32_t threads = 1; threads <= maxThreads; ++threads) {
+            recorder.destroy();
+            jobs.shutdown();
+            jobs.init(threads);
+            recorder.init(device, graphicsFamily.value(), threads, framesInFlight);
+
+            // One untimed pass allocates the command buffers
+            recorder.beginFrame(0);
+            recordDrawsParallel();
+
+            auto start = std::chrono::steady_clock::now();
+            for (uint32_t it = 0; it < iterations; ++it) {
+                recorder.beginFrame(0);
+                recordDrawsParallel();
+            }
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+            if (threads == 1) baseline = ms;
+            std::cout << threads << "  " << ms << "  " << (baseline / ms) << "x\n";
+        }
+    }
+
+    // Records benchDispatchDraws push-constant draws into one secondary (no submission), once
+    // through the loader's global entry points and once through the device dispatch table, and
+    // reports the CPU time per frame and per draw of each
+    void runDispatchBenchmark() {
+        const uint32_t iterations = 20;
+        const uint32_t draws = benchDispatchDraws;
+        TrianglePushConstants push = drawConstants(0);
+
+        VkCommandBufferInheritanceInfo inheritance{};
+        inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritance.pNext = &renderGraph->renderingInheritance(scenePass);
+
+        ParallelRecorder::RecordFn viaLoader = [&](VkCommandBuffer cmd, uint32_t begin, uint32_t end) {
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+            for (uint32_t i = begin; i < end; ++i) {
+                vkCmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(push), &push);
+                vkCmdDraw(cmd, 3, 1, 0, 0);
+            }
+        };
+        ParallelRecorder::RecordFn viaTable = [&](VkCommandBuffer cmd, uint32_t begin, uint32_t end) {
+            vkd.cmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+            for (uint32_t i = begin; i < end; ++i) {
+                vkd.cmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(push), &push);
+                vkd.cmdDraw(cmd, 3, 1, 0, 0);
+            }
+        };
+
+        std::cout << "Recording " << draws << " draws on one thread, " << iterations << " iterations\n";
+        std::cout << "path  ms/frame  ns/draw\n";
+        for (auto [name, fn] : {std::make_pair("loader", &viaLoader), std::make_pair("table", &viaTable)}) {
+            // One untimed pass allocates the command buffer; the whole range is a single job
+            recorder.beginFrame(0);
+            recorder.record(jobs, draws, draws, inheritance, *fn);
+
+            auto start = std::chrono::steady_clock::now();
+            for (uint32_t it = 0; it < iterations; ++it) {
+                recorder.beginFrame(0);
+                recorder.record(jobs, draws, draws, inheritance, *fn);
+            }
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+            std::cout << name << "  " << ms << "  " << ms * 1e6 / draws << "\n";
+        }
+    }
+
+    // Times each scene kernel on benchSceneObjects objects in an 8-ary hierarchy: transform
+    // propagation (with the root moved every call, so everything is dirty), culling against the
+    // camera and the draw key sort, scalar and SIMD, on one thread and on every worker. The AoS
+    // cull the CPU path used before is timed alongside for reference.
+    void runSceneBenchmark() {
+        const uint32_t iterations = 50;
+        const uint32_t count = benchSceneObjects;
+        Scene bench;
+        bench.reserve(count);
+        std::vector<SceneNode> nodes;
+        nodes.reserve(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            SceneObjectDesc desc;
+            if (i > 0) {
+                // The golden angle spreads siblings around their parent
+                float angle = static_cast<float>(i) * 2.39996f;
+                desc.parent = nodes[(i - 1) / 8];
+                desc.x = 0.9f * std::cos(angle);
+                desc.y = 0.9f * std::sin(angle);
+                desc.scale = 0.45f;
+            }
+            desc.radius = TRIANGLE_BOUNDS_RADIUS;
+            desc.depth = static_cast<float>(i % 1024) / 1024.0f;
+            desc.layer = static_cast<uint8_t>(i % 4);
+            nodes.push_back(bench.add(desc));
+        }
+        bench.updateTransforms(&jobs);
+
+        auto time = [&](auto &&fn) {
+            fn();
+            auto start = std::chrono::steady_clock::now();
+            for (uint32_t it = 0; it < iterations; ++it) fn();
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+        };
+        auto row = [&](const char *kernel, const char *path, uint32_t threads, double ms, uint32_t objects) {
+            std::cout << kernel << "  " << path << "  " << threads << "  " << ms << "  "
+                      << (objects != 0 ? ms * 1e6 / objects : 0.0) << "\n";
+        };
+
+        std::cout << "Scene kernels over " << count << " objects in " << bench.levelCount() << " levels, "
+                  << iterations << " iterations (" << Scene::simdName() << " build)\n";
+        std::cout << "kernel  path  threads  ms  ns/object\n";
+        float angle = 0.0f;
+        for (bool simd : {false, true}) {
+            bench.setSimdEnabled(simd);
+            const char *path = simd ? Scene::simdName() : "scalar";
+            for (JobSystem *pool : {static_cast<JobSystem*>(nullptr), &jobs}) {
+                uint32_t threads = pool != nullptr ? jobs.workerCount() : 1;
+                double transformMs = time([&] {
+                    angle += 0.01f;
+                    bench.setLocal(nodes[0], 0.1f * std::cos(angle), 0.1f * std::sin(angle), 1.0f);
+                    bench.updateTransforms(pool);
+                });
+                row("transforms", path, threads, transformMs, count);
+                double cullMs = time([&] { bench.cull(cameraCenter[0], cameraCenter[1], cameraZoom, pool); });
+                row("cull", path, threads, cullMs, count);
+            }
+        }
+        bench.cull(cameraCenter[0], cameraCenter[1], cameraZoom, &jobs);
+        row("sort", "radix", 1, time([&] { bench.sortDrawKeys(); }), bench.visibleCount());
+
+        std::vector<GpuObject> objects(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t dense = bench.index(nodes[i]);
+            objects[i].offset[0] = bench.worldX(dense);
+            objects[i].offset[1] = bench.worldY(dense);
+            objects[i].radius = bench.worldRadius(dense);
+        }
+        std::vector<uint32_t> visible;
+        visible.reserve(count);
+        double aosMs = time([&] {
+            visible.clear();
+            for (uint32_t i = 0; i < count; ++i) {
+                const GpuObject &obj = objects[i];
+                float x = (obj.offset[0] - cameraCenter[0]) * cameraZoom;
+                float y = (obj.offset[1] - cameraCenter[1]) * cameraZoom;
+                float radius = obj.radius * cameraZoom;
+                if (std::abs(x) - radius <= 1.0f && std::abs(y) - radius <= 1.0f) visible.push_back(i);
+            }
+        });
+        row("cull", "aos", 1, aosMs, count);
+        std::cout << bench.visibleCount() << " of " << count << " objects visible\n";
+    }
+
+    // Times benchDescriptorOps operations of each kind, on the render thread with nothing in
+    // flight: descriptor sets allocated and freed one at a time from a FREE_DESCRIPTOR_SET pool
+    // against allocated from the frame allocator and released by resetting its pools, set layouts
+    // created and destroyed against looked up in the layout cache, and a small uniform buffer
+    // created per use against a bump allocation.
+    void runDescriptorBenchmark() {
+        const uint32_t iterations = 20;
+        const uint32_t ops = benchDescriptorOps;
+
+        VkDescriptorSetLayoutBinding bindings[2]{};
+        bindings[0].binding = 0;
+        bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        bindings[0].descriptorCount = 1;
+        bindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        bindings[1] = bindings[0];
+        bindings[1].binding = 1;
+        bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = 2;
+        layoutInfo.pBindings = bindings;
+        VkDescriptorSetLayout setLayout = layouts.descriptorSetLayout(layoutInfo);
+
+        VkDescriptorPoolSize poolSizes[2] = {
+            {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, ops},
+            {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, ops},
+        };
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+        poolInfo.maxSets = ops;
+        poolInfo.poolSizeCount = 2;
+        poolInfo.pPoolSizes = poolSizes;
+        VkDescriptorPool freePool = VK_NULL_HANDLE;
+        if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &freePool) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create benchmark descriptor pool!");
+        }
+
+        struct FrameUniforms {
+            float viewProj[16];
+        };
+        FrameUniforms uniforms{};
+        // minUniformBufferOffsetAlignment is at most 256, so this many always fit in a region
+        const uint32_t perRegion = static_cast<uint32_t>(frameAllocator.stats().regionBytes / 256);
+
+        auto time = [&](auto &&fn) {
+            fn();
+            auto start = std::chrono::steady_clock::now();
+            for (uint32_t it = 0; it < iterations; ++it) fn();
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+        };
+        std::vector<VkDescriptorSet> sets(ops);
+        double freeMs = time([&] {
+            VkDescriptorSetAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            allocInfo.descriptorPool = freePool;
+            allocInfo.descriptorSetCount = 1;
+            allocInfo.pSetLayouts = &setLayout;
+            for (uint32_t i = 0; i < ops; ++i) {
+                if (vkd.allocateDescriptorSets(device, &allocInfo, &sets[i]) != VK_SUCCESS) {
+                    throw std::runtime_error("Failed to allocate benchmark descriptor set!");
+                }
+            }
+            for (uint32_t i = 0; i < ops; ++i) vkd.freeDescriptorSets(device, freePool, 1, &sets[i]);
+        });
+        double resetMs = time([&] {
+            frameAllocator.beginFrame(0);
+            for (uint32_t i = 0; i < ops; ++i) sets[i] = frameAllocator.allocateSet(setLayout);
+        });
+        double createMs = time([&] {
+            for (uint32_t i = 0; i < ops; ++i) {
+                VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+                if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &layout) != VK_SUCCESS) {
+                    throw std::runtime_error("Failed to create benchmark descriptor set layout!");
+                }
+                vkDestroyDescriptorSetLayout(device, layout, nullptr);
+            }
+        });
+        double cacheMs = time([&] {
+            for (uint32_t i = 0; i < ops; ++i) layouts.descriptorSetLayout(layoutInfo);
+        });
+        double bufferMs = time([&] {
+            VkBufferCreateInfo bufInfo{};
+            bufInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            bufInfo.size = sizeof(FrameUniforms);
+            bufInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+            bufInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            for (uint32_t i = 0; i < ops; ++i) {
+                GpuAllocation allocation;
+                VkBuffer buffer = allocator.createBuffer(bufInfo, MemoryUsage::CpuToGpu, allocation);
+                std::memcpy(allocation.mapped, &uniforms, sizeof(uniforms));
+                allocator.destroyBuffer(buffer, allocation);
+            }
+        });
+        double bumpMs = time([&] {
+            frameAllocator.beginFrame(0);
+            for (uint32_t i = 0; i < ops; ++i) {
+                if (i != 0 && i % perRegion == 0) frameAllocator.beginFrame(0);
+                uniforms.viewProj[0] = static_cast<float>(i);
+                frameAllocator.push(uniforms);
+            }
+        });
+        frameAllocator.beginFrame(0);
+        vkDestroyDescriptorPool(device, freePool, nullptr);
+
+        std::cout << ops << " operations of each kind, " << iterations << " iterations\n";
+        std::cout << "operation  path  ms  ns/op\n";
+        auto row = [&](const char *operation, const char *path, double ms) {
+            std::cout << operation << "  " << path << "  " << ms << "  " << ms * 1e6 / ops << "\n";
+        };
+        row("descriptor sets", "free", freeMs);
+        row("descriptor sets", "pool reset", resetMs);
+        row("set layouts", "create", createMs);
+        row("set layouts", "cache", cacheMs);
+        row("uniforms", "buffer", bufferMs);
+        row("uniforms", "bump", bumpMs);
+    }
+
+    // Renders the scene with both paths for growing object counts (1k, 10k, ... up to
+    // benchIndirectObjects) and reports the CPU time spent recording a frame and the whole frame
+    // time, submission to GPU idle. With --zoom above 1 most objects are outside the view.
+    void runIndirectBenchmark() {
+        if (!gpuCullingReady) {
+            throw std::runtime_error("GPU-driven rendering is not supported on this device!");
+        }
+        const uint32_t warmup = 5;
+        const uint32_t iterations = 50;
+
+        std::cout << "objects  path  record ms  frame ms\n";
+        for (uint32_t objects = std::min(1000u, benchIndirectObjects);; objects = std::min(objects * 10, benchIndirectObjects)) {
+            vkDeviceWaitIdle(device);
+            drawCount = objects;
+            createScene();
+            for (bool gpu : {false, true}) {
+                // Switching paths changes the graph; the previous one is idle after the waits below
+                gpuDriven = gpu;
+                renderGraph->destroy();
+                buildRenderGraph();
+
+                double recordMs = 0.0;
+                double frameMs = 0.0;
+                for (uint32_t it = 0; it < warmup + iterations; ++it) {
+                    auto start = std::chrono::steady_clock::now();
+                    drawHeadlessFrame(false);
+                    vkQueueWaitIdle(graphicsQueue);
+                    if (it < warmup) continue;
+                    recordMs += lastRecordMs;
+                    frameMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                }
+                std::cout << objects << "  " << (gpu ? "gpu" : "cpu") << "  " << recordMs / iterations << "  "
+                          << frameMs / iterations << "\n";
+            }
+            if (objects >= benchIndirectObjects) break;
+        }
+    }
+
+    // Renders frames until nothing is pending and done(stats) holds; requestFrame(frame) issues
+    // the frame's streaming requests
+    template <typename RequestFn, typename DoneFn>
+    void runStreamingFrames(uint32_t maxFrames, RequestFn &&requestFrame, DoneFn &&done) {
+        for (uint32_t frame = 0; frame < maxFrames; ++frame) {
+            requestFrame(frame);
+            drawHeadlessFrame(false);
+            TextureStreamerStats s = streamer.stats();
+            if (s.pending == 0 && done(s)) break;
+        }
+    }
+
+    // Writes benchStreamingTextures synthetic 2048x2048 textures, then compares loading them
+    // whole against streaming: time until every texture can be drawn, and residency while a
+    // camera moves along the row of textures with a budget of a quarter of the whole set.
+    void runStreamingBenchmark() {
+        if (bindless.set() == VK_NULL_HANDLE) {
+            throw std::runtime_error("Texture streaming needs descriptor indexing!");
+        }
+        const uint32_t size = 2048;
+        const uint32_t walkFrames = 240;
+        const uint32_t maxFrames = 10000;
+        const uint32_t count = benchStreamingTextures;
+        auto mb = [](VkDeviceSize bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); };
+        auto msSince = [](std::chrono::steady_clock::time_point start) {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        };
+
+        std::filesystem::path dir = std::filesystem::temp_directory_path() / "vuk_streaming";
+        std::filesystem::create_directories(dir);
+        std::vector<std::string> paths;
+        auto writeStart = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < count; ++i) {
+            paths.push_back((dir / ("texture" + std::to_string(i) + ".vuktex")).string());
+            writeSyntheticTextureFile(paths.back(), size, i);
+        }
+        std::cout << "Wrote " << count << " textures of " << size << "x" << size << " in " << msSince(writeStart)
+                  << " ms\n";
+
+        auto addAll = [&](std::vector<StreamedTexture> &ids) {
+            streamer.init(device, allocator, uploads, bindless, deletionQueue);
+            streamerReady = true;
+            for (const std::string &path : paths) ids.push_back(streamer.add(path));
+        };
+        auto finish = [&]() {
+            vkDeviceWaitIdle(device);
+            streamer.destroy();
+            streamerReady = false;
+        };
+
+        // Everything at full resolution before the first frame
+        std::vector<StreamedTexture> ids;
+        auto start = std::chrono::steady_clock::now();
+        addAll(ids);
+        streamer.setBudget(~VkDeviceSize(0));
+        streamer.setFrameUploadLimit(0);
+        runStreamingFrames(maxFrames,
+            [&](uint32_t) { for (StreamedTexture id : ids) streamer.request(id, static_cast<float>(size)); },
+            [&](const TextureStreamerStats &s) { return s.starved == 0; });
+        double eagerMs = msSince(start);
+        VkDeviceSize eagerBytes = streamer.stats().residentBytes;
+        std::cout << "eager: all textures resident after " << eagerMs << " ms, " << mb(eagerBytes) << " MB\n";
+        finish();
+
+        // Streaming: the first frame only needs the mip tails
+        ids.clear();
+        start = std::chrono::steady_clock::now();
+        addAll(ids);
+        streamer.setBudget(std::max<VkDeviceSize>(eagerBytes / 4, 1));
+        runStreamingFrames(maxFrames, [](uint32_t) {}, [&](const TextureStreamerStats &) {
+            return std::all_of(ids.begin(), ids.end(), [&](StreamedTexture id) { return streamer.handle(id) != BINDLESS_INVALID; });
+        });
+        double firstMs = msSince(start);
+        std::cout << "streaming: first frame drawable after " << firstMs << " ms, " << mb(streamer.stats().residentBytes)
+                  << " MB, budget " << mb(streamer.stats().budgetBytes) << " MB\n";
+
+        // The camera walks from the first texture to the last; nearby textures cover more pixels
+        std::cout << "frame  camera  resident MB  retiring MB  loads  evictions  starved  streamed MB\n";
+        auto walk = [&](uint32_t frame) {
+            float camera = count > 1 ? static_cast<float>(frame) / (walkFrames - 1) * (count - 1) : 0.0f;
+            for (uint32_t i = 0; i < count; ++i) {
+                float distance = std::abs(camera - static_cast<float>(i));
+                streamer.request(ids[i], static_cast<float>(size) / (1.0f + 4.0f * distance));
+            }
+            return camera;
+        };
+        for (uint32_t frame = 0; frame < walkFrames; ++frame) {
+            float camera = walk(frame);
+            drawHeadlessFrame(false);
+            if (frame % 30 == 29 || frame + 1 == walkFrames) {
+                TextureStreamerStats s = streamer.stats();
+                std::cout << frame + 1 << "  " << camera << "  " << mb(s.residentBytes) << "  " << mb(s.retiringBytes)
+                          << "  " << s.loads << "  " << s.evictions << "  " << s.starved << "  " << mb(s.bytesStreamed)
+                          << "\n";
+            }
+        }
+        runStreamingFrames(maxFrames, [&](uint32_t) { walk(walkFrames - 1); },
+                           [](const TextureStreamerStats &) { return true; });
+        finish();
+    }
+
+    void printProfileSummary() {
+        ProfilerSummary s = profiler.summary();
+        if (s.frames == 0) return;
+        auto line = [](const char *label, const FrameTimePercentiles &p) {
+            std::cout << "  " << label << " " << p.p50 << " / " << p.p95 << " / " << p.p99 << " ms\n";
+        };
+        std::cout << "Frame times over the last " << s.frames << " frames (p50 / p95 / p99):\n";
+        line("frame", s.frame);
+        line("cpu  ", s.cpu);
+        line("gpu  ", s.gpu);
+        std::cout << "  " << (s.gpu.p50 > s.cpu.p50 ? "GPU-bound" : "CPU-bound") << "\n";
+        if (debugMessages.enabled()) {
+            DebugMessageStats v = debugMessages.stats();
+            std::cout << "  validation: " << v.errors << " errors, " << v.warnings << " warnings, "
+                      << v.performance << " performance warnings so far\n";
+        }
+    }
+
+    // Totals plus the most frequent message IDs
+    void printValidationSummary() {
+        DebugMessageStats s = debugMessages.stats();
+        if (s.messages == 0) return;
+        std::cout << "Validation messages: " << s.messages << " (" << s.errors << " errors, " << s.warnings
+                  << " warnings, " << s.performance << " performance), " << s.suppressed << " repeats suppressed, "
+                  << s.dropped << " dropped, " << s.untracked << " untracked\n";
+        std::vector<DebugMessageCount> counts = debugMessages.counts();
+        for (size_t i = 0; i < std::min<size_t>(counts.size(), 5); ++i) {
+            const DebugMessageCount &c = counts[i];
+            std::cout << "  " << c.count << "x " << (c.name.empty() ? "?" : c.name) << " (id " << c.id << ")\n";
+        }
+    }
+
+    void printAllocatorSummary() {
+        LayoutCacheStats l = layouts.stats();
+        std::cout << "Layout cache: " << l.setLayouts << " set layouts, " << l.pipelineLayouts << " pipeline layouts, "
+                  << l.samplers << " samplers, " << l.hits << " hits\n";
+        FrameAllocatorStats f = frameAllocator.stats();
+        std::cout << "Frame allocator: " << f.peakBytes << " of " << f.regionBytes << " bytes peak per frame, "
+                  << f.setsAllocated << " transient sets from " << f.poolsCreated << " pools\n";
+    }
+
+    void printPacingSummary() {
+        FramePacingStats s = pacer.stats();
+        if (s.frames == 0) return;
+        std::cout << "Frame pacing over the last " << s.frames << " frames: " << s.meanMs << " ms mean, "
+                  << s.stddevMs << " ms stddev (" << s.minMs << " - " << s.maxMs << "), latency "
+                  << (s.latencyMeasured ? "" : "~") << s.latencyMs << " ms\n";
+    }
+
+    void mainLoop() {
+        if (headless && benchRecordDraws != 0) {
+            runRecordBenchmark();
+            return;
+        }
+        if (headless && benchIndirectObjects != 0) {
+            runIndirectBenchmark();
+            return;
+        }
+        if (headless && benchDispatchDraws != 0) {
+            runDispatchBenchmark();
+            return;
+        }
+        if (headless && benchSceneObjects != 0) {
+            runSceneBenchmark();
+            return;
+        }
+        if (headless && benchStreamingTextures != 0) {
+            runStreamingBenchmark();
+            return;
+        }
+        if (headless && benchDescriptorOps != 0) {
+            runDescriptorBenchmark();
+            return;
+        }
+        if (headless) {
+            uint32_t count = std::max(frameLimit, 1u);
+            for (uint32_t i = 0; i < count; ++i) {
+                drawHeadlessFrame(i + 1 == count && !readbackPath.empty());
+            }
+            vkDeviceWaitIdle(device);
+            if (!readbackPath.empty()) {
+                writeReadback(readbackPath);
+            }
+            return;
+        }
+
+        std::cout << "Frame pacing: " << FramePacer::policyName(pacer.policy()) << ", "
+                  << swapchainImages.size() << " swapchain images"
+                  << (deviceFeatures.presentWait ? ", present wait" : "") << "\n";
+        uint32_t frameCount = 0;
+        while (!glfwWindowShouldClose(window)) {
+            {
+                ProfileZone zone(profiler, "pacing", true);
+                pacer.waitBeforeInput(frames[(currentFrame + frames.size() - 1) % frames.size()].inFlight);
+            }
+            glfwPollEvents();
+            drawFrame();
+            ++frameCount;
+            if (profile && frameCount % PROFILE_SUMMARY_INTERVAL == 0) {
+                printProfileSummary();
+                printPacingSummary();
+            }
+            if (frameLimit != 0 && frameCount >= frameLimit) break;
+        }
+
+        vkDeviceWaitIdle(device);
+        printPacingSummary();
+    }
+
+    void cleanup() {
+        // Destroy Vulkan RAII objects in reverse order of creation
+        debugMessenger.reset();
+        if (debugMessages.enabled()) {
+            debugMessages.destroy();
+            printValidationSummary();
+        }
+        if (device != VK_NULL_HANDLE) {
+            if (profiler.enabled()) {
+                printProfileSummary();
+            }
+            if (!tracePath.empty() && !profiler.writeTrace(tracePath)) {
+                std::cerr << "Failed to write trace " << tracePath << "\n";
+            }
+            // Nothing may be in flight once the deletion queue is flushed
+            vkDeviceWaitIdle(device);
+            profiler.destroy();
+            destroyFrameResources();
+            deletionQueue.flush();
+            frameAllocator.destroy();
+            if (capture.enabled()) {
+                capture.destroy();
+                printCaptureSummary();
+            }
+            cleanupSwapchain();
+            recorder.destroy();
+            jobs.shutdown();
+            if (gpuCullingReady) {
+                gpuCulling.destroy();
+            }
+            destroyUi();
+            if (streamerReady) {
+                streamer.destroy();
+            }
+            if (postEnabled) {
+                post.destroy();
+            }
+            uploads.destroy();
+
+            pipelineCache.save();
+            auto cacheStats = pipelineCache.stats();
+            std::cout << "Pipeline cache: " << cacheStats.pipelinesCreated << " pipelines, "
+                      << cacheStats.cacheHits << " cache hits, " << cacheStats.totalCreateMs << " ms creating"
+                      << (cacheStats.loadedFromDisk ? " (warm)" : " (cold)") << "\n";
+            vkDestroyPipeline(device, graphicsPipeline, nullptr);
+            if (indirectPipeline != VK_NULL_HANDLE) vkDestroyPipeline(device, indirectPipeline, nullptr);
+            pipelineCache.destroy();
+            printAllocatorSummary();
+            layouts.destroy();
+            bindless.destroy();
+            allocator.destroy();
+            vkDestroyDevice(device, nullptr);
+            device = VK_NULL_HANDLE;
+        }
+        instance.reset();
+        context.reset();
+
+        if (window) {
+            glfwDestroyWindow(window);
+            window = nullptr;
+        }
+        if (!headless) {
+            glfwTerminate();
+        }
+    }
+};
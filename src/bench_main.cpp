@@ -0,0 +1,361 @@
+#include "application.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Synthetic workloads for regression tracking: each scenario starts a fresh application,
+// renders a fixed number of frames and reports startup phases, frame-time percentiles,
+// recording time and memory as JSON and/or CSV. Runs headless by default so it works on CI
+// machines with a software driver (lavapipe).
+
+struct BenchConfig {
+    std::vector<std::string> scenarios;
+    // 0 picks the scenario's default
+    uint32_t count = 0;
+    uint32_t frames = 300;
+    bool windowed = false;
+    std::string deviceOverride;
+    std::string jsonPath;
+    std::string csvPath;
+};
+
+struct BenchResult {
+    std::string scenario;
+    uint32_t count = 0;
+    uint32_t frames = 0;
+    double startupMs = 0.0;
+    std::vector<CpuZoneTotal> startupPhases;
+    ProfilerSummary summary;
+    FrameTimePercentiles recordMs;
+    // Device-local heaps, summed
+    VkDeviceSize deviceLocalUsage = 0;
+    VkDeviceSize deviceLocalPeak = 0;
+    VkDeviceSize deviceLocalBudget = 0;
+    GpuAllocatorStats allocator;
+    // uploads
+    VkDeviceSize bytesUploaded = 0;
+    uint64_t ringStalls = 0;
+    // pipelines: creation without and with the driver's in-memory cache warm
+    FrameTimePercentiles pipelineColdMs;
+    FrameTimePercentiles pipelineWarmMs;
+    uint32_t pipelineCacheHits = 0;
+    // resize
+    uint32_t resizes = 0;
+};
+
+class BenchRunner {
+public:
+    // Bytes per upload of the uploads scenario
+    static constexpr VkDeviceSize UPLOAD_BYTES = 4096;
+
+    explicit BenchRunner(const BenchConfig &config) : config(config) {}
+
+    static uint32_t defaultCount(const std::string &scenario) {
+        if (scenario == "draws") return 10000;
+        if (scenario == "uploads") return 256;
+        if (scenario == "pipelines") return 64;
+        if (scenario == "resize") return 30;
+        return 0;
+    }
+
+    BenchResult run(const std::string &scenario) {
+        BenchResult result;
+        result.scenario = scenario;
+        result.count = config.count != 0 ? config.count : defaultCount(scenario);
+        result.frames = std::max(config.frames, 1u);
+
+        auto app = std::make_unique<HelloTriangleApplication>();
+        app->headless = !config.windowed;
+        app->deviceOverride = config.deviceOverride;
+        // Every run starts cold
+        app->pipelineCachePath.clear();
+        if (scenario == "draws") app->drawCount = result.count;
+        app->profiler.setEnabled(true);
+
+        auto start = std::chrono::steady_clock::now();
+        app->initVulkan();
+        result.startupMs = msSince(start);
+        if (deviceName.empty()) {
+            VkPhysicalDeviceProperties props{};
+            vkGetPhysicalDeviceProperties(static_cast<VkPhysicalDevice>(app->physicalDevice), &props);
+            deviceName = props.deviceName;
+        }
+        // Nothing but initialization has been recorded yet
+        result.startupPhases = app->profiler.cpuZoneTotals();
+
+        if (scenario == "pipelines") createPipelines(*app, result);
+        renderFrames(*app, result);
+        app->cleanup();
+        return result;
+    }
+
+    const std::string &device() const { return deviceName; }
+
+private:
+    static double msSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Creates count distinct scene pipelines twice: first against an empty cache, then again
+    // with the VkPipelineCache holding all of them
+    void createPipelines(HelloTriangleApplication &app, BenchResult &result) {
+        std::vector<VkPipeline> pipelines;
+        for (FrameTimePercentiles *out : {&result.pipelineColdMs, &result.pipelineWarmMs}) {
+            std::vector<double> samples;
+            for (uint32_t i = 1; i <= result.count; ++i) {
+                auto start = std::chrono::steady_clock::now();
+                pipelines.push_back(app.createScenePipeline("triangle.vert.spv", VK_FORMAT_UNDEFINED, i));
+                samples.push_back(msSince(start));
+            }
+            *out = Profiler::percentiles(samples);
+            for (VkPipeline pipeline : pipelines) vkDestroyPipeline(app.device, pipeline, nullptr);
+            pipelines.clear();
+        }
+        result.pipelineCacheHits = app.pipelineCache.stats().cacheHits;
+    }
+
+    void renderFrames(HelloTriangleApplication &app, BenchResult &result) {
+        // Sizes the resize scenario cycles through
+        static const VkExtent2D sizes[] = {{1280, 720}, {640, 480}, {1920, 1080}, {800, 600}};
+
+        VkBuffer uploadTarget = VK_NULL_HANDLE;
+        GpuAllocation uploadAllocation;
+        std::vector<uint8_t> uploadData;
+        if (result.scenario == "uploads") {
+            VkBufferCreateInfo bufInfo{};
+            bufInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            bufInfo.size = UPLOAD_BYTES * result.count;
+            bufInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+            bufInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            uploadTarget = app.allocator.createBuffer(bufInfo, MemoryUsage::GpuOnly, uploadAllocation);
+            uploadData.assign(static_cast<size_t>(UPLOAD_BYTES), 0x5a);
+        }
+        uint32_t resizeInterval = result.scenario == "resize" ? std::max(result.frames / (result.count + 1), 1u) : 0;
+
+        std::vector<double> recordSamples;
+        for (uint32_t frame = 0; frame < result.frames; ++frame) {
+            if (resizeInterval != 0 && frame != 0 && frame % resizeInterval == 0 && result.resizes < result.count) {
+                const VkExtent2D &size = sizes[result.resizes % 4];
+                if (app.headless) {
+                    app.resizeOffscreenTargets(size);
+                } else {
+                    glfwSetWindowSize(app.window, static_cast<int>(size.width), static_cast<int>(size.height));
+                }
+                ++result.resizes;
+            }
+            for (uint32_t i = 0; uploadTarget != VK_NULL_HANDLE && i < result.count; ++i) {
+                uploadData[0] = static_cast<uint8_t>(frame);
+                app.uploads.uploadBuffer(uploadTarget, UPLOAD_BYTES * i, uploadData.data(), UPLOAD_BYTES);
+            }
+
+            if (app.headless) {
+                app.drawHeadlessFrame(false);
+            } else {
+                glfwPollEvents();
+                app.drawFrame();
+            }
+            recordSamples.push_back(app.lastRecordMs);
+            result.deviceLocalPeak = std::max(result.deviceLocalPeak, deviceLocalUsage(app));
+        }
+        vkDeviceWaitIdle(app.device);
+
+        result.summary = app.profiler.summary();
+        result.recordMs = Profiler::percentiles(recordSamples);
+        result.deviceLocalUsage = deviceLocalUsage(app);
+        for (const GpuHeapBudget &heap : app.allocator.heapBudgets()) {
+            if (heap.deviceLocal) result.deviceLocalBudget += heap.budget;
+        }
+        result.allocator = app.allocator.stats();
+        UploadServiceStats uploadStats = app.uploads.stats();
+        result.bytesUploaded = uploadStats.bytesUploaded;
+        result.ringStalls = uploadStats.ringStalls;
+
+        if (uploadTarget != VK_NULL_HANDLE) app.allocator.destroyBuffer(uploadTarget, uploadAllocation);
+    }
+
+    static VkDeviceSize deviceLocalUsage(const HelloTriangleApplication &app) {
+        VkDeviceSize usage = 0;
+        for (const GpuHeapBudget &heap : app.allocator.heapBudgets()) {
+            if (heap.deviceLocal) usage += heap.usage;
+        }
+        return usage;
+    }
+
+    BenchConfig config;
+    std::string deviceName;
+};
+
+namespace {
+
+double toMb(VkDeviceSize bytes) {
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+void writeJsonString(std::ostream &out, const std::string &s) {
+    out << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out << ' ';
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+void writeJsonPercentiles(std::ostream &out, const char *key, const FrameTimePercentiles &p) {
+    out << "\"" << key << "\":{\"p50\":" << p.p50 << ",\"p95\":" << p.p95 << ",\"p99\":" << p.p99 << "}";
+}
+
+bool writeJson(const std::string &path, const BenchConfig &config, const std::string &device,
+               const std::vector<BenchResult> &results) {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) return false;
+    out << "{\"device\":";
+    writeJsonString(out, device);
+    out << ",\"mode\":\"" << (config.windowed ? "windowed" : "headless") << "\",\"scenarios\":[";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult &r = results[i];
+        out << (i ? "," : "") << "\n{\"scenario\":\"" << r.scenario << "\",\"count\":" << r.count
+            << ",\"frames\":" << r.frames << ",\"startup\":{\"totalMs\":" << r.startupMs << ",\"phases\":[";
+        for (size_t p = 0; p < r.startupPhases.size(); ++p) {
+            out << (p ? "," : "") << "{\"name\":";
+            writeJsonString(out, r.startupPhases[p].name);
+            out << ",\"ms\":" << r.startupPhases[p].totalMs << ",\"count\":" << r.startupPhases[p].count << "}";
+        }
+        out << "]},";
+        writeJsonPercentiles(out, "frameMs", r.summary.frame);
+        out << ",";
+        writeJsonPercentiles(out, "cpuMs", r.summary.cpu);
+        out << ",";
+        writeJsonPercentiles(out, "gpuMs", r.summary.gpu);
+        out << ",";
+        writeJsonPercentiles(out, "recordMs", r.recordMs);
+        out << ",\"memory\":{\"deviceLocalUsage\":" << r.deviceLocalUsage << ",\"deviceLocalPeak\":"
+            << r.deviceLocalPeak << ",\"deviceLocalBudget\":" << r.deviceLocalBudget << ",\"allocatorReserved\":"
+            << r.allocator.bytesReserved << ",\"allocatorUsed\":" << r.allocator.bytesUsed << ",\"blocks\":"
+            << r.allocator.blockCount << ",\"allocations\":" << r.allocator.allocationCount << "}";
+        if (r.scenario == "uploads") {
+            out << ",\"uploads\":{\"bytes\":" << r.bytesUploaded << ",\"ringStalls\":" << r.ringStalls << "}";
+        } else if (r.scenario == "pipelines") {
+            out << ",\"pipelines\":{";
+            writeJsonPercentiles(out, "coldMs", r.pipelineColdMs);
+            out << ",";
+            writeJsonPercentiles(out, "warmMs", r.pipelineWarmMs);
+            out << ",\"cacheHits\":" << r.pipelineCacheHits << "}";
+        } else if (r.scenario == "resize") {
+            out << ",\"resizes\":" << r.resizes;
+        }
+        out << "}";
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
+
+// One row per scenario; startup phases are only in the JSON
+bool writeCsv(const std::string &path, const std::vector<BenchResult> &results) {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) return false;
+    out << "scenario,count,frames,startup_ms,frame_p50,frame_p95,frame_p99,cpu_p50,cpu_p95,cpu_p99,"
+           "gpu_p50,gpu_p95,gpu_p99,record_p50,record_p95,record_p99,device_local_mb,device_local_peak_mb,"
+           "allocator_reserved_mb,uploaded_mb,ring_stalls,pipeline_cold_p50,pipeline_warm_p50,resizes\n";
+    auto percentiles = [&](const FrameTimePercentiles &p) { out << p.p50 << "," << p.p95 << "," << p.p99 << ","; };
+    for (const BenchResult &r : results) {
+        out << r.scenario << "," << r.count << "," << r.frames << "," << r.startupMs << ",";
+        percentiles(r.summary.frame);
+        percentiles(r.summary.cpu);
+        percentiles(r.summary.gpu);
+        percentiles(r.recordMs);
+        out << toMb(r.deviceLocalUsage) << "," << toMb(r.deviceLocalPeak) << "," << toMb(r.allocator.bytesReserved)
+            << "," << toMb(r.bytesUploaded) << "," << r.ringStalls << "," << r.pipelineColdMs.p50 << ","
+            << r.pipelineWarmMs.p50 << "," << r.resizes << "\n";
+    }
+    return static_cast<bool>(out);
+}
+
+void printResult(const BenchResult &r) {
+    auto line = [](const char *label, const FrameTimePercentiles &p) {
+        std::cout << "  " << label << " " << p.p50 << " / " << p.p95 << " / " << p.p99 << " ms\n";
+    };
+    std::cout << r.scenario << " (" << r.count << ", " << r.frames << " frames): startup " << r.startupMs << " ms\n";
+    std::cout << "  p50 / p95 / p99:\n";
+    line("frame ", r.summary.frame);
+    line("cpu   ", r.summary.cpu);
+    line("gpu   ", r.summary.gpu);
+    line("record", r.recordMs);
+    if (r.scenario == "pipelines") {
+        line("create cold", r.pipelineColdMs);
+        line("create warm", r.pipelineWarmMs);
+    }
+    std::cout << "  device-local " << toMb(r.deviceLocalUsage) << " MB (peak " << toMb(r.deviceLocalPeak)
+              << " MB), allocator reserved " << toMb(r.allocator.bytesReserved) << " MB\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchConfig config;
+    std::string scenario = "all";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--scenario" && i + 1 < argc) {
+            scenario = argv[++i];
+        } else if (arg == "--count" && i + 1 < argc) {
+            config.count = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--frames" && i + 1 < argc) {
+            config.frames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--windowed") {
+            config.windowed = true;
+        } else if (arg == "--device" && i + 1 < argc) {
+            config.deviceOverride = argv[++i];
+        } else if (arg == "--json" && i + 1 < argc) {
+            config.jsonPath = argv[++i];
+        } else if (arg == "--csv" && i + 1 < argc) {
+            config.csvPath = argv[++i];
+        } else {
+            std::cerr << "Unknown argument " << arg << "\n"
+                      << "usage: vuk_bench [--scenario draws|uploads|pipelines|resize|all] [--count N] [--frames N]\n"
+                      << "                 [--windowed] [--device INDEX|NAME] [--json PATH] [--csv PATH]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (scenario == "all") {
+        config.scenarios = {"draws", "uploads", "pipelines", "resize"};
+    } else if (BenchRunner::defaultCount(scenario) != 0) {
+        config.scenarios = {scenario};
+    } else {
+        std::cerr << "Unknown scenario " << scenario << " (draws, uploads, pipelines, resize or all)" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    BenchRunner runner(config);
+    std::vector<BenchResult> results;
+    try {
+        for (const std::string &name : config.scenarios) {
+            results.push_back(runner.run(name));
+            printResult(results.back());
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (!config.jsonPath.empty() && !writeJson(config.jsonPath, config, runner.device(), results)) {
+        std::cerr << "Failed to write " << config.jsonPath << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (!config.csvPath.empty() && !writeCsv(config.csvPath, results)) {
+        std::cerr << "Failed to write " << config.csvPath << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
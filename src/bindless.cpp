@@ -0,0 +1,209 @@
+#include "bindless.hpp"
+
+#include "vk_dispatch.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+constexpr uint32_t TYPE_COUNT = static_cast<uint32_t>(BindlessType::Count);
+
+constexpr VkDescriptorType descriptorTypes[TYPE_COUNT] = {
+    VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+    VK_DESCRIPTOR_TYPE_SAMPLER,
+    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+    VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+};
+
+uint32_t index(BindlessType type) {
+    return static_cast<uint32_t>(type);
+}
+
+} // namespace
+
+void BindlessTable::init(VkPhysicalDevice physicalDevice, VkDevice dev, uint32_t frames,
+                         const BindlessCapacities &capacities) {
+    device = dev;
+    frameCount = std::max(frames, 1u);
+
+    // Every binding is visible to all stages, so the per-stage limits apply as well
+    VkPhysicalDeviceDescriptorIndexingProperties limits{};
+    limits.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+    VkPhysicalDeviceProperties2 props{};
+    props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    props.pNext = &limits;
+    vkGetPhysicalDeviceProperties2(physicalDevice, &props);
+
+    arrays[index(BindlessType::SampledImage)].capacity =
+        std::min({capacities.sampledImages, limits.maxDescriptorSetUpdateAfterBindSampledImages,
+                  limits.maxPerStageDescriptorUpdateAfterBindSampledImages});
+    arrays[index(BindlessType::Sampler)].capacity =
+        std::min({capacities.samplers, limits.maxDescriptorSetUpdateAfterBindSamplers,
+                  limits.maxPerStageDescriptorUpdateAfterBindSamplers});
+    arrays[index(BindlessType::StorageBuffer)].capacity =
+        std::min({capacities.storageBuffers, limits.maxDescriptorSetUpdateAfterBindStorageBuffers,
+                  limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers});
+    arrays[index(BindlessType::StorageImage)].capacity =
+        std::min({capacities.storageImages, limits.maxDescriptorSetUpdateAfterBindStorageImages,
+                  limits.maxPerStageDescriptorUpdateAfterBindStorageImages});
+
+    VkDescriptorSetLayoutBinding bindings[TYPE_COUNT]{};
+    VkDescriptorBindingFlags bindingFlags[TYPE_COUNT]{};
+    VkDescriptorPoolSize poolSizes[TYPE_COUNT]{};
+    for (uint32_t t = 0; t < TYPE_COUNT; ++t) {
+        bindings[t].binding = t;
+        bindings[t].descriptorType = descriptorTypes[t];
+        bindings[t].descriptorCount = std::max(arrays[t].capacity, 1u);
+        bindings[t].stageFlags = VK_SHADER_STAGE_ALL;
+        bindingFlags[t] = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                          VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+        poolSizes[t].type = descriptorTypes[t];
+        poolSizes[t].descriptorCount = bindings[t].descriptorCount;
+    }
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo{};
+    flagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    flagsInfo.bindingCount = TYPE_COUNT;
+    flagsInfo.pBindingFlags = bindingFlags;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.pNext = &flagsInfo;
+    layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    layoutInfo.bindingCount = TYPE_COUNT;
+    layoutInfo.pBindings = bindings;
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &setLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create bindless descriptor set layout!");
+    }
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = TYPE_COUNT;
+    poolInfo.pPoolSizes = poolSizes;
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create bindless descriptor pool!");
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = pool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &setLayout;
+    if (vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to allocate bindless descriptor set!");
+    }
+}
+
+void BindlessTable::destroy() {
+    // Destroying the pool frees the set
+    if (pool != VK_NULL_HANDLE) vkDestroyDescriptorPool(device, pool, nullptr);
+    if (setLayout != VK_NULL_HANDLE) vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+    pool = VK_NULL_HANDLE;
+    setLayout = VK_NULL_HANDLE;
+    descriptorSet = VK_NULL_HANDLE;
+    for (auto &array : arrays) array = Array{};
+    retired.clear();
+}
+
+BindlessHandle BindlessTable::allocateSlot(BindlessType type) {
+    Array &array = arrays[index(type)];
+    BindlessHandle handle = BINDLESS_INVALID;
+    if (!array.freeSlots.empty()) {
+        handle = array.freeSlots.back();
+        array.freeSlots.pop_back();
+    } else if (array.highWater < array.capacity) {
+        handle = array.highWater++;
+    } else {
+        return BINDLESS_INVALID;
+    }
+    ++array.live;
+    return handle;
+}
+
+void BindlessTable::write(BindlessType type, BindlessHandle handle, const VkDescriptorImageInfo *image,
+                          const VkDescriptorBufferInfo *buffer) {
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = descriptorSet;
+    write.dstBinding = index(type);
+    write.dstArrayElement = handle;
+    write.descriptorCount = 1;
+    write.descriptorType = descriptorTypes[index(type)];
+    write.pImageInfo = image;
+    write.pBufferInfo = buffer;
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+}
+
+BindlessHandle BindlessTable::addSampledImage(VkImageView view, VkImageLayout layout) {
+    std::lock_guard<std::mutex> lock(mutex);
+    BindlessHandle handle = allocateSlot(BindlessType::SampledImage);
+    if (handle == BINDLESS_INVALID) return handle;
+    VkDescriptorImageInfo info{VK_NULL_HANDLE, view, layout};
+    write(BindlessType::SampledImage, handle, &info, nullptr);
+    return handle;
+}
+
+BindlessHandle BindlessTable::addSampler(VkSampler sampler) {
+    std::lock_guard<std::mutex> lock(mutex);
+    BindlessHandle handle = allocateSlot(BindlessType::Sampler);
+    if (handle == BINDLESS_INVALID) return handle;
+    VkDescriptorImageInfo info{sampler, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED};
+    write(BindlessType::Sampler, handle, &info, nullptr);
+    return handle;
+}
+
+BindlessHandle BindlessTable::addStorageBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range) {
+    std::lock_guard<std::mutex> lock(mutex);
+    BindlessHandle handle = allocateSlot(BindlessType::StorageBuffer);
+    if (handle == BINDLESS_INVALID) return handle;
+    VkDescriptorBufferInfo info{buffer, offset, range};
+    write(BindlessType::StorageBuffer, handle, nullptr, &info);
+    return handle;
+}
+
+BindlessHandle BindlessTable::addStorageImage(VkImageView view) {
+    std::lock_guard<std::mutex> lock(mutex);
+    BindlessHandle handle = allocateSlot(BindlessType::StorageImage);
+    if (handle == BINDLESS_INVALID) return handle;
+    VkDescriptorImageInfo info{VK_NULL_HANDLE, view, VK_IMAGE_LAYOUT_GENERAL};
+    write(BindlessType::StorageImage, handle, &info, nullptr);
+    return handle;
+}
+
+void BindlessTable::release(BindlessType type, BindlessHandle handle) {
+    if (handle == BINDLESS_INVALID) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    // The frame being recorded may still reference the slot, so it is retired against it
+    retired.push_back({type, handle, currentFrame});
+    --arrays[index(type)].live;
+}
+
+void BindlessTable::beginFrame(uint64_t frameNumber) {
+    std::lock_guard<std::mutex> lock(mutex);
+    currentFrame = frameNumber;
+    // A slot released while frame k was recorded can be reused from frame k + frameCount on
+    auto reusable = [&](const RetiredSlot &slot) { return frameNumber >= slot.retiredAtFrame + frameCount; };
+    for (const RetiredSlot &slot : retired) {
+        if (reusable(slot)) arrays[index(slot.type)].freeSlots.push_back(slot.handle);
+    }
+    retired.erase(std::remove_if(retired.begin(), retired.end(), reusable), retired.end());
+}
+
+void BindlessTable::bind(VkCommandBuffer cmd, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout,
+                         uint32_t setIndex) const {
+    vkd.cmdBindDescriptorSets(cmd, bindPoint, pipelineLayout, setIndex, 1, &descriptorSet, 0, nullptr);
+}
+
+BindlessStats BindlessTable::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    BindlessStats s;
+    for (uint32_t t = 0; t < TYPE_COUNT; ++t) {
+        s.capacity[t] = arrays[t].capacity;
+        s.live[t] = arrays[t].live;
+    }
+    s.retiring = static_cast<uint32_t>(retired.size());
+    return s;
+}
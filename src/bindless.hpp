@@ -0,0 +1,104 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+using BindlessHandle = uint32_t;
+constexpr BindlessHandle BINDLESS_INVALID = UINT32_MAX;
+
+// Each type is one binding of the bindless set, with the binding number equal to the enum value
+enum class BindlessType : uint32_t {
+    SampledImage,
+    Sampler,
+    StorageBuffer,
+    StorageImage,
+    Count,
+};
+
+// Requested array sizes; clamped to the device's update-after-bind limits
+struct BindlessCapacities {
+    uint32_t sampledImages = 16384;
+    uint32_t samplers = 64;
+    uint32_t storageBuffers = 8192;
+    uint32_t storageImages = 1024;
+};
+
+struct BindlessStats {
+    uint32_t capacity[static_cast<uint32_t>(BindlessType::Count)] = {};
+    uint32_t live[static_cast<uint32_t>(BindlessType::Count)] = {};
+    // Released slots waiting for the frames that may still read them
+    uint32_t retiring = 0;
+};
+
+// One update-after-bind descriptor set holding every texture, sampler and storage buffer the
+// engine uses. Resources are registered once and get a stable array index; shaders receive
+// the index through push constants and index the arrays non-uniformly:
+//
+//   layout(set = 0, binding = 0) uniform texture2D textures[];
+//   layout(set = 0, binding = 1) uniform sampler samplers[];
+//   layout(set = 0, binding = 2) readonly buffer Buffers { uint data[]; } buffers[];
+//   layout(set = 0, binding = 3, rgba8) uniform image2D images[];
+//
+// so a frame binds the set once instead of allocating and binding sets per draw. Released
+// slots are only reused after every frame that could have read them has completed; slot
+// writes are legal while the set is bound because the bindings are PARTIALLY_BOUND and
+// UPDATE_UNUSED_WHILE_PENDING. Thread-safe.
+class BindlessTable {
+public:
+    void init(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t frameCount,
+              const BindlessCapacities &capacities = {});
+    void destroy();
+
+    VkDescriptorSetLayout layout() const { return setLayout; }
+    VkDescriptorSet set() const { return descriptorSet; }
+
+    // Return BINDLESS_INVALID when the array is full
+    BindlessHandle addSampledImage(VkImageView view, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    BindlessHandle addSampler(VkSampler sampler);
+    BindlessHandle addStorageBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+    BindlessHandle addStorageImage(VkImageView view);
+
+    // The slot stays valid for frames already recorded and is recycled framesInFlight frames later
+    void release(BindlessType type, BindlessHandle handle);
+
+    // frameNumber is the number of frames submitted so far; call once the current frame's
+    // fence has been waited on, before recording
+    void beginFrame(uint64_t frameNumber);
+
+    void bind(VkCommandBuffer cmd, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout,
+              uint32_t setIndex = 0) const;
+
+    BindlessStats stats() const;
+
+private:
+    struct Array {
+        uint32_t capacity = 0;
+        // Slots below highWater that were never handed out are tracked by highWater alone
+        uint32_t highWater = 0;
+        std::vector<uint32_t> freeSlots;
+        uint32_t live = 0;
+    };
+
+    struct RetiredSlot {
+        BindlessType type;
+        BindlessHandle handle;
+        uint64_t retiredAtFrame;
+    };
+
+    BindlessHandle allocateSlot(BindlessType type);
+    void write(BindlessType type, BindlessHandle handle, const VkDescriptorImageInfo *image,
+               const VkDescriptorBufferInfo *buffer);
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    uint32_t frameCount = 1;
+    uint64_t currentFrame = 0;
+    Array arrays[static_cast<uint32_t>(BindlessType::Count)];
+    std::vector<RetiredSlot> retired;
+    mutable std::mutex mutex;
+};
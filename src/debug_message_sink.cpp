@@ -0,0 +1,206 @@
+#include "debug_message_sink.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+static_assert((DebugMessageSink::RING_SIZE & (DebugMessageSink::RING_SIZE - 1)) == 0, "RING_SIZE must be a power of two");
+static_assert((DebugMessageSink::MAX_IDS & (DebugMessageSink::MAX_IDS - 1)) == 0, "MAX_IDS must be a power of two");
+
+static int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static void copyText(char *dst, size_t size, const char *src) {
+    if (src == nullptr) src = "";
+    size_t length = std::min(std::strlen(src), size - 1);
+    std::memcpy(dst, src, length);
+    dst[length] = '\0';
+}
+
+void DebugMessageSink::init() {
+    cells = std::make_unique<Cell[]>(RING_SIZE);
+    for (uint32_t i = 0; i < RING_SIZE; ++i) cells[i].sequence.store(i, std::memory_order_relaxed);
+    ids = std::make_unique<IdSlot[]>(MAX_IDS);
+    enqueuePos.store(0, std::memory_order_relaxed);
+    dequeuePos = 0;
+    stopping = false;
+    drainer = std::thread([this] { drainLoop(); });
+}
+
+void DebugMessageSink::destroy() {
+    if (!enabled()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    drainer.join();
+}
+
+VKAPI_ATTR VkBool32 VKAPI_CALL DebugMessageSink::callback(VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+                                                          VkDebugUtilsMessageTypeFlagsEXT types,
+                                                          const VkDebugUtilsMessengerCallbackDataEXT *data,
+                                                          void *userData) {
+    if (data != nullptr && userData != nullptr) {
+        static_cast<DebugMessageSink*>(userData)->receive(severity, types, *data);
+    }
+    return VK_FALSE;
+}
+
+void DebugMessageSink::receive(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT types,
+                               const VkDebugUtilsMessengerCallbackDataEXT &data) {
+    messages.fetch_add(1, std::memory_order_relaxed);
+    if (severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT) {
+        errors.fetch_add(1, std::memory_order_relaxed);
+    } else if (severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) {
+        warnings.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (types & VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT) {
+        performance.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    IdSlot *slot = findSlot(data.messageIdNumber);
+    if (slot == nullptr) {
+        untracked.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    slot->count.fetch_add(1, std::memory_order_relaxed);
+    slot->severity.fetch_or(static_cast<uint32_t>(severity), std::memory_order_relaxed);
+    slot->types.fetch_or(types, std::memory_order_relaxed);
+
+    // One thread wins the print for each interval; the others only count
+    int64_t now = nowMs();
+    int64_t next = slot->nextPrintMs.load(std::memory_order_relaxed);
+    if (now < next || !slot->nextPrintMs.compare_exchange_strong(next, now + REPEAT_INTERVAL_MS,
+                                                                  std::memory_order_relaxed)) {
+        slot->suppressed.fetch_add(1, std::memory_order_relaxed);
+        suppressed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    uint64_t repeats = slot->suppressed.exchange(0, std::memory_order_relaxed);
+    if (!push(severity, types, repeats, data)) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+DebugMessageSink::IdSlot *DebugMessageSink::findSlot(int32_t id) {
+    const uint64_t key = static_cast<uint64_t>(static_cast<uint32_t>(id)) + 1;
+    uint32_t index = static_cast<uint32_t>(id) * 2654435761u;
+    for (uint32_t probe = 0; probe < MAX_IDS; ++probe) {
+        IdSlot &slot = ids[(index + probe) & (MAX_IDS - 1)];
+        uint64_t current = slot.key.load(std::memory_order_acquire);
+        if (current == key) return &slot;
+        if (current == 0) {
+            if (slot.key.compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+                return &slot;
+            }
+            // Lost the race; the winner may have claimed it for this very ID
+            if (current == key) return &slot;
+        }
+    }
+    return nullptr;
+}
+
+// Bounded MPSC queue after Vyukov: a cell is free for position p when its sequence is p and
+// holds the message for p once it is p + 1
+bool DebugMessageSink::push(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT types,
+                            uint64_t repeats, const VkDebugUtilsMessengerCallbackDataEXT &data) {
+    uint64_t pos = enqueuePos.load(std::memory_order_relaxed);
+    Cell *cell = nullptr;
+    while (true) {
+        cell = &cells[pos & (RING_SIZE - 1)];
+        uint64_t sequence = cell->sequence.load(std::memory_order_acquire);
+        int64_t diff = static_cast<int64_t>(sequence) - static_cast<int64_t>(pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+    cell->id = data.messageIdNumber;
+    cell->severity = severity;
+    cell->types = types;
+    cell->repeats = repeats;
+    copyText(cell->name, sizeof(cell->name), data.pMessageIdName);
+    copyText(cell->text, sizeof(cell->text), data.pMessage);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool DebugMessageSink::drain() {
+    Cell &cell = cells[dequeuePos & (RING_SIZE - 1)];
+    if (cell.sequence.load(std::memory_order_acquire) != dequeuePos + 1) return false;
+
+    IdSlot *slot = findSlot(cell.id);
+    if (slot != nullptr && !slot->named.load(std::memory_order_acquire)) {
+        // Only this thread names slots, so counts() sees either nothing or the whole name
+        copyText(slot->name, sizeof(slot->name), cell.name);
+        slot->named.store(true, std::memory_order_release);
+    }
+
+    const char *level = cell.severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT ? "error" : "warning";
+    const char *kind = (cell.types & VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT) ? "Performance" : "Validation";
+    std::cerr << kind << " " << level << " [" << (cell.name[0] ? cell.name : "?") << "]: " << cell.text;
+    if (cell.repeats > 0) {
+        std::cerr << " (" << cell.repeats << " repeats suppressed)";
+    }
+    std::cerr << '\n';
+
+    cell.sequence.store(dequeuePos + RING_SIZE, std::memory_order_release);
+    ++dequeuePos;
+    return true;
+}
+
+void DebugMessageSink::drainLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        bool done = stopping;
+        lock.unlock();
+        bool printed = false;
+        while (drain()) printed = true;
+        if (printed) std::cerr.flush();
+        lock.lock();
+        if (done) return;
+        // Producers never signal; the ring is polled
+        wake.wait_for(lock, std::chrono::milliseconds(20), [&] { return stopping; });
+    }
+}
+
+DebugMessageStats DebugMessageSink::stats() const {
+    DebugMessageStats s;
+    s.messages = messages.load(std::memory_order_relaxed);
+    s.errors = errors.load(std::memory_order_relaxed);
+    s.warnings = warnings.load(std::memory_order_relaxed);
+    s.performance = performance.load(std::memory_order_relaxed);
+    s.suppressed = suppressed.load(std::memory_order_relaxed);
+    s.dropped = dropped.load(std::memory_order_relaxed);
+    s.untracked = untracked.load(std::memory_order_relaxed);
+    return s;
+}
+
+std::vector<DebugMessageCount> DebugMessageSink::counts() const {
+    std::vector<DebugMessageCount> result;
+    if (!ids) return result;
+    for (uint32_t i = 0; i < MAX_IDS; ++i) {
+        const IdSlot &slot = ids[i];
+        uint64_t key = slot.key.load(std::memory_order_acquire);
+        if (key == 0) continue;
+        DebugMessageCount c;
+        c.id = static_cast<int32_t>(static_cast<uint32_t>(key - 1));
+        if (slot.named.load(std::memory_order_acquire)) c.name = slot.name;
+        uint32_t severity = slot.severity.load(std::memory_order_relaxed);
+        c.severity = (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT) ? VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT
+                                                                               : VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT;
+        c.types = slot.types.load(std::memory_order_relaxed);
+        c.count = slot.count.load(std::memory_order_relaxed);
+        result.push_back(c);
+    }
+    std::sort(result.begin(), result.end(),
+              [](const DebugMessageCount &a, const DebugMessageCount &b) { return a.count > b.count; });
+    return result;
+}
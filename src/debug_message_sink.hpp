@@ -0,0 +1,117 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Messages of one messageIdNumber
+struct DebugMessageCount {
+    int32_t id = 0;
+    std::string name;
+    VkDebugUtilsMessageSeverityFlagBitsEXT severity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT;
+    VkDebugUtilsMessageTypeFlagsEXT types = 0;
+    uint64_t count = 0;
+};
+
+struct DebugMessageStats {
+    uint64_t messages = 0;
+    uint64_t errors = 0;
+    uint64_t warnings = 0;
+    uint64_t performance = 0;
+    // Repeats counted but not printed because their ID printed less than REPEAT_INTERVAL_MS ago
+    uint64_t suppressed = 0;
+    // Printable messages lost to a full ring
+    uint64_t dropped = 0;
+    // Messages of IDs beyond MAX_IDS; only counted, never printed
+    uint64_t untracked = 0;
+};
+
+// Receives VK_EXT_debug_utils messages without formatting or writing on the thread that
+// triggered them, which is usually inside a driver call. The callback counts the message
+// against its messageIdNumber in a fixed open-addressed table of atomics and, unless the same
+// ID was printed within REPEAT_INTERVAL_MS, copies the text into a bounded lock-free MPSC
+// ring (dropping it when full). A background thread drains the ring and writes to std::cerr.
+// Nothing on the callback path takes a lock or allocates.
+class DebugMessageSink {
+public:
+    static constexpr uint32_t RING_SIZE = 256;
+    static constexpr uint32_t MAX_TEXT = 1024;
+    static constexpr uint32_t MAX_IDS = 1024;
+    static constexpr int64_t REPEAT_INTERVAL_MS = 1000;
+
+    // Starts the drain thread; call before the messenger is created
+    void init();
+    // Prints what is still queued; the messenger must be gone
+    void destroy();
+    bool enabled() const { return drainer.joinable(); }
+
+    // pfnUserCallback; pUserData is the sink
+    static VKAPI_ATTR VkBool32 VKAPI_CALL callback(VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+                                                   VkDebugUtilsMessageTypeFlagsEXT types,
+                                                   const VkDebugUtilsMessengerCallbackDataEXT *data, void *userData);
+
+    DebugMessageStats stats() const;
+    // Every ID seen so far, most frequent first
+    std::vector<DebugMessageCount> counts() const;
+
+private:
+    struct Cell {
+        std::atomic<uint64_t> sequence{0};
+        int32_t id = 0;
+        VkDebugUtilsMessageSeverityFlagBitsEXT severity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT;
+        VkDebugUtilsMessageTypeFlagsEXT types = 0;
+        // Repeats of the ID that were suppressed since it last printed
+        uint64_t repeats = 0;
+        char name[128] = {};
+        char text[MAX_TEXT] = {};
+    };
+
+    struct IdSlot {
+        // id + 1 in the low 32 bits once claimed, so 0 marks a free slot
+        std::atomic<uint64_t> key{0};
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> suppressed{0};
+        std::atomic<int64_t> nextPrintMs{0};
+        std::atomic<uint32_t> severity{0};
+        std::atomic<uint32_t> types{0};
+        // Written once by the drain thread from the first drained message; readable once named is set
+        char name[128] = {};
+        std::atomic<bool> named{false};
+    };
+
+    void receive(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT types,
+                 const VkDebugUtilsMessengerCallbackDataEXT &data);
+    // Claims a slot on first sight; null once the table is full
+    IdSlot *findSlot(int32_t id);
+    bool push(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT types,
+              uint64_t repeats, const VkDebugUtilsMessengerCallbackDataEXT &data);
+    // Drain thread only
+    bool drain();
+    void drainLoop();
+
+    std::unique_ptr<Cell[]> cells;
+    std::unique_ptr<IdSlot[]> ids;
+    std::atomic<uint64_t> enqueuePos{0};
+    uint64_t dequeuePos = 0;
+
+    std::atomic<uint64_t> messages{0};
+    std::atomic<uint64_t> errors{0};
+    std::atomic<uint64_t> warnings{0};
+    std::atomic<uint64_t> performance{0};
+    std::atomic<uint64_t> suppressed{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> untracked{0};
+
+    std::thread drainer;
+    // Only guards the drain thread's sleep; producers never take it
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+};
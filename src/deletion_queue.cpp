@@ -0,0 +1,84 @@
+#include "deletion_queue.hpp"
+
+#include "vk_dispatch.hpp"
+
+#include <algorithm>
+
+void DeletionQueue::init(VkDevice dev, GpuAllocator &gpuAllocator, uint32_t frames) {
+    device = dev;
+    allocator = &gpuAllocator;
+    frameCount = std::max(frames, 1u);
+    currentFrame = 0;
+}
+
+void DeletionQueue::flush() {
+    std::vector<Entry> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ready.swap(entries);
+    }
+    for (Entry &entry : ready) entry.destroy();
+}
+
+void DeletionQueue::destroyImage(VkImage image, GpuAllocation &allocation) {
+    if (image == VK_NULL_HANDLE) return;
+    defer([this, image, allocation]() mutable { allocator->destroyImage(image, allocation); });
+    allocation = {};
+}
+
+void DeletionQueue::destroyBuffer(VkBuffer buffer, GpuAllocation &allocation) {
+    if (buffer == VK_NULL_HANDLE) return;
+    defer([this, buffer, allocation]() mutable { allocator->destroyBuffer(buffer, allocation); });
+    allocation = {};
+}
+
+void DeletionQueue::destroyImageView(VkImageView view) {
+    if (view == VK_NULL_HANDLE) return;
+    defer([this, view] { vkDestroyImageView(device, view, nullptr); });
+}
+
+void DeletionQueue::destroyPipeline(VkPipeline pipeline) {
+    if (pipeline == VK_NULL_HANDLE) return;
+    defer([this, pipeline] { vkDestroyPipeline(device, pipeline, nullptr); });
+}
+
+void DeletionQueue::destroySwapchain(VkSwapchainKHR swapchain) {
+    if (swapchain == VK_NULL_HANDLE) return;
+    defer([this, swapchain] { vkDestroySwapchainKHR(device, swapchain, nullptr); });
+}
+
+void DeletionQueue::defer(std::function<void()> destroy) {
+    deferUntil(VK_NULL_HANDLE, 0, std::move(destroy));
+}
+
+void DeletionQueue::deferUntil(VkSemaphore timeline, uint64_t value, std::function<void()> destroy) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // The frame being recorded may still reference the object, so it is queued against it
+    entries.push_back({std::move(destroy), currentFrame, timeline, value});
+}
+
+void DeletionQueue::beginFrame(uint64_t frameNumber) {
+    std::vector<Entry> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentFrame = frameNumber;
+        // Frame k has completed once frame k + frameCount is being recorded
+        auto done = [&](const Entry &entry) {
+            if (frameNumber < entry.frame + frameCount) return false;
+            if (entry.timeline == VK_NULL_HANDLE) return true;
+            uint64_t reached = 0;
+            vkd.getSemaphoreCounterValue(device, entry.timeline, &reached);
+            return reached >= entry.value;
+        };
+        auto keep = std::stable_partition(entries.begin(), entries.end(), [&](const Entry &e) { return !done(e); });
+        ready.assign(std::make_move_iterator(keep), std::make_move_iterator(entries.end()));
+        entries.erase(keep, entries.end());
+    }
+    // Outside the lock, so destroy callbacks may queue more work
+    for (Entry &entry : ready) entry.destroy();
+}
+
+size_t DeletionQueue::pending() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "gpu_allocator.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Destroys Vulkan objects and their sub-allocations once the GPU is done with them, instead of
+// waiting for the device to go idle. An object queued while frame k is being recorded (or
+// after it was submitted) is destroyed at the beginFrame() of frame k + frameCount, when
+// frame k's fence has been waited on. Objects used outside the frame loop, e.g. by the
+// transfer queue, can wait for a timeline semaphore value as well. Thread-safe.
+class DeletionQueue {
+public:
+    void init(VkDevice device, GpuAllocator &allocator, uint32_t frameCount);
+    // Destroys everything still queued; the GPU must be idle
+    void flush();
+
+    void destroyImage(VkImage image, GpuAllocation &allocation);
+    void destroyBuffer(VkBuffer buffer, GpuAllocation &allocation);
+    void destroyImageView(VkImageView view);
+    void destroyPipeline(VkPipeline pipeline);
+    void destroySwapchain(VkSwapchainKHR swapchain);
+    // Anything else; destroy runs on the thread calling beginFrame() or flush()
+    void defer(std::function<void()> destroy);
+    // Also waits until timeline has reached value
+    void deferUntil(VkSemaphore timeline, uint64_t value, std::function<void()> destroy);
+
+    // Call after waiting on frameNumber's fence; destroys what the completed frames used
+    void beginFrame(uint64_t frameNumber);
+
+    size_t pending() const;
+
+private:
+    struct Entry {
+        std::function<void()> destroy;
+        uint64_t frame = 0;
+        VkSemaphore timeline = VK_NULL_HANDLE;
+        uint64_t value = 0;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    GpuAllocator *allocator = nullptr;
+    uint32_t frameCount = 1;
+    uint64_t currentFrame = 0;
+
+    mutable std::mutex mutex;
+    std::vector<Entry> entries;
+};
@@ -0,0 +1,224 @@
+#include "device_features.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+bool hasExtension(const std::vector<VkExtensionProperties> &available, const char *name) {
+    for (const auto &ext : available) {
+        if (std::strcmp(ext.extensionName, name) == 0) return true;
+    }
+    return false;
+}
+
+std::string lower(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return s;
+}
+
+void append(std::string &list, const char *name) {
+    if (!list.empty()) list += ", ";
+    list += name;
+}
+
+} // namespace
+
+std::string DeviceFeatures::missingRequired() const {
+    std::string missing;
+    if (apiVersion < VK_API_VERSION_1_3) append(missing, "Vulkan 1.3");
+    if (!timelineSemaphore) append(missing, "timelineSemaphore");
+    if (!synchronization2) append(missing, "synchronization2");
+    if (!dynamicRendering) append(missing, "dynamicRendering");
+    return missing;
+}
+
+std::string DeviceFeatures::describeOptional() const {
+    std::string list;
+    if (descriptorIndexing) append(list, "descriptor indexing");
+    if (memoryBudget) append(list, "memory budget");
+    if (samplerAnisotropy) append(list, "anisotropy");
+    if (indirectDraws) append(list, "indirect draws");
+    if (presentWait) append(list, "present wait");
+    return list.empty() ? "none" : list;
+}
+
+DeviceFeatures queryDeviceFeatures(VkPhysicalDevice physicalDevice) {
+    DeviceFeatures result;
+
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &props);
+    result.apiVersion = props.apiVersion;
+    // The 1.2/1.3 feature structs can't be chained on older devices
+    if (props.apiVersion < VK_API_VERSION_1_3) return result;
+
+    VkPhysicalDeviceVulkan13Features features13{};
+    features13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+    VkPhysicalDeviceVulkan12Features features12{};
+    features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    features12.pNext = &features13;
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &features12;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    result.timelineSemaphore = features12.timelineSemaphore == VK_TRUE;
+    result.synchronization2 = features13.synchronization2 == VK_TRUE;
+    result.dynamicRendering = features13.dynamicRendering == VK_TRUE;
+    result.descriptorIndexing = features12.runtimeDescriptorArray && features12.shaderSampledImageArrayNonUniformIndexing &&
+                                features12.shaderStorageBufferArrayNonUniformIndexing &&
+                                features12.shaderStorageImageArrayNonUniformIndexing &&
+                                features12.descriptorBindingPartiallyBound &&
+                                features12.descriptorBindingSampledImageUpdateAfterBind &&
+                                features12.descriptorBindingStorageBufferUpdateAfterBind &&
+                                features12.descriptorBindingStorageImageUpdateAfterBind &&
+                                features12.descriptorBindingUpdateUnusedWhilePending &&
+                                features12.descriptorBindingVariableDescriptorCount;
+    result.samplerAnisotropy = features.features.samplerAnisotropy == VK_TRUE;
+    result.indirectDraws = features.features.multiDrawIndirect && features.features.drawIndirectFirstInstance &&
+                           features12.drawIndirectCount;
+
+    uint32_t extCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extCount, nullptr);
+    std::vector<VkExtensionProperties> available(extCount);
+    if (extCount > 0) {
+        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extCount, available.data());
+    }
+    result.memoryBudget = hasExtension(available, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    result.swapchain = hasExtension(available, VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+
+    // The feature structs may only be chained when the extensions exist
+    if (result.swapchain && hasExtension(available, VK_KHR_PRESENT_ID_EXTENSION_NAME) &&
+        hasExtension(available, VK_KHR_PRESENT_WAIT_EXTENSION_NAME)) {
+        VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{};
+        presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+        VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures{};
+        presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+        presentIdFeatures.pNext = &presentWaitFeatures;
+        VkPhysicalDeviceFeatures2 presentFeatures{};
+        presentFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        presentFeatures.pNext = &presentIdFeatures;
+        vkGetPhysicalDeviceFeatures2(physicalDevice, &presentFeatures);
+        result.presentWait = presentIdFeatures.presentId && presentWaitFeatures.presentWait;
+    }
+    return result;
+}
+
+int64_t scorePhysicalDevice(VkPhysicalDevice physicalDevice, const DeviceFeatures &supported) {
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &props);
+
+    int64_t score = 0;
+    switch (props.deviceType) {
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: score += 100000; break;
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: score += 50000; break;
+    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: score += 20000; break;
+    case VK_PHYSICAL_DEVICE_TYPE_CPU: break;
+    default: score += 1000; break;
+    }
+
+    // Integrated GPUs report shared system memory as device-local, which is why the type
+    // weight has to dominate: 64 GiB only adds 4096
+    VkPhysicalDeviceMemoryProperties memProps{};
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProps);
+    VkDeviceSize largestLocalHeap = 0;
+    for (uint32_t i = 0; i < memProps.memoryHeapCount; ++i) {
+        if (memProps.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+            largestLocalHeap = std::max(largestLocalHeap, memProps.memoryHeaps[i].size);
+        }
+    }
+    score += static_cast<int64_t>(largestLocalHeap / (16ull * 1024 * 1024));
+
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+    bool dedicatedTransfer = false;
+    bool asyncCompute = false;
+    for (const auto &qf : families) {
+        bool graphics = qf.queueFlags & VK_QUEUE_GRAPHICS_BIT;
+        bool compute = qf.queueFlags & VK_QUEUE_COMPUTE_BIT;
+        if (!graphics && !compute && (qf.queueFlags & VK_QUEUE_TRANSFER_BIT)) dedicatedTransfer = true;
+        if (!graphics && compute) asyncCompute = true;
+    }
+    if (dedicatedTransfer) score += 500;
+    if (asyncCompute) score += 500;
+
+    if (supported.descriptorIndexing) score += 1000;
+    if (supported.memoryBudget) score += 200;
+    if (supported.samplerAnisotropy) score += 100;
+    if (supported.indirectDraws) score += 100;
+    return score;
+}
+
+bool matchesDeviceOverride(const std::string &override, uint32_t index, const char *deviceName) {
+    if (override.empty()) return false;
+    char *end = nullptr;
+    unsigned long asIndex = std::strtoul(override.c_str(), &end, 10);
+    if (end && *end == '\0') return asIndex == index;
+    return lower(deviceName).find(lower(override)) != std::string::npos;
+}
+
+void DeviceFeatureChain::build(const DeviceFeatures &supported, bool wantSwapchain) {
+    features13 = VkPhysicalDeviceVulkan13Features{};
+    features13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+    features13.synchronization2 = VK_TRUE;
+    features13.dynamicRendering = VK_TRUE;
+
+    features12 = VkPhysicalDeviceVulkan12Features{};
+    features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    features12.pNext = &features13;
+    features12.timelineSemaphore = VK_TRUE;
+    if (supported.descriptorIndexing) {
+        features12.runtimeDescriptorArray = VK_TRUE;
+        features12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+        features12.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+        features12.shaderStorageImageArrayNonUniformIndexing = VK_TRUE;
+        features12.descriptorBindingPartiallyBound = VK_TRUE;
+        features12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        features12.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+        features12.descriptorBindingStorageImageUpdateAfterBind = VK_TRUE;
+        features12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+        features12.descriptorBindingVariableDescriptorCount = VK_TRUE;
+    }
+    features12.drawIndirectCount = supported.indirectDraws ? VK_TRUE : VK_FALSE;
+
+    features2 = VkPhysicalDeviceFeatures2{};
+    features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features2.pNext = &features12;
+    features2.features.samplerAnisotropy = supported.samplerAnisotropy ? VK_TRUE : VK_FALSE;
+    features2.features.multiDrawIndirect = supported.indirectDraws ? VK_TRUE : VK_FALSE;
+    features2.features.drawIndirectFirstInstance = supported.indirectDraws ? VK_TRUE : VK_FALSE;
+
+    bool presentWait = wantSwapchain && supported.presentWait;
+    presentWaitFeatures = VkPhysicalDevicePresentWaitFeaturesKHR{};
+    presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+    presentWaitFeatures.presentWait = VK_TRUE;
+    presentIdFeatures = VkPhysicalDevicePresentIdFeaturesKHR{};
+    presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+    presentIdFeatures.pNext = &presentWaitFeatures;
+    presentIdFeatures.presentId = VK_TRUE;
+    if (presentWait) features13.pNext = &presentIdFeatures;
+
+    extensions.clear();
+    if (wantSwapchain) extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    if (supported.memoryBudget) extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    if (presentWait) {
+        extensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+        extensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+    }
+
+    enabledFeatures = supported;
+    enabledFeatures.swapchain = wantSwapchain;
+    enabledFeatures.presentWait = presentWait;
+}
+
+void DeviceFeatureChain::apply(VkDeviceCreateInfo &info) const {
+    // Core features travel in features2, so pEnabledFeatures must stay null
+    info.pNext = &features2;
+    info.pEnabledFeatures = nullptr;
+    info.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    info.ppEnabledExtensionNames = extensions.empty() ? nullptr : extensions.data();
+}
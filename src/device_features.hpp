@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Device capabilities the engine knows how to use. The required ones gate device selection;
+// optional ones are enabled whenever supported. After device creation the engine keeps the
+// enabled set, so subsystems branch on what was actually turned on instead of re-querying.
+struct DeviceFeatures {
+    uint32_t apiVersion = 0;
+
+    // Required (all core in 1.3)
+    bool timelineSemaphore = false;
+    bool synchronization2 = false;
+    bool dynamicRendering = false;
+
+    // Optional
+    // Runtime-sized, partially bound, update-after-bind arrays of sampled images, samplers,
+    // storage buffers and storage images, indexed non-uniformly (what BindlessTable needs)
+    bool descriptorIndexing = false;
+    // VK_EXT_memory_budget
+    bool memoryBudget = false;
+    bool samplerAnisotropy = false;
+    // multiDrawIndirect, drawIndirectFirstInstance and drawIndirectCount (what GpuCulling needs)
+    bool indirectDraws = false;
+
+    // VK_KHR_swapchain; only enabled for windowed devices
+    bool swapchain = false;
+    // VK_KHR_present_id plus VK_KHR_present_wait; only enabled alongside the swapchain
+    bool presentWait = false;
+
+    // Names of the missing required features, empty if the device qualifies
+    std::string missingRequired() const;
+    // Comma-separated list of the optional features that are set
+    std::string describeOptional() const;
+};
+
+DeviceFeatures queryDeviceFeatures(VkPhysicalDevice physicalDevice);
+
+// Higher is better. Device type dominates, then the size of the largest device-local heap,
+// then dedicated transfer/async compute queues and optional features as tie-breakers.
+int64_t scorePhysicalDevice(VkPhysicalDevice physicalDevice, const DeviceFeatures &supported);
+
+// An override is either an index into the enumeration order or a case-insensitive
+// substring of the device name
+bool matchesDeviceOverride(const std::string &override, uint32_t index, const char *deviceName);
+
+// Owns the feature structs and extension list vkCreateDevice points at, so it must outlive
+// the call. Enables the required features plus every optional one in supported.
+class DeviceFeatureChain {
+public:
+    DeviceFeatureChain() = default;
+    DeviceFeatureChain(const DeviceFeatureChain &) = delete;
+    DeviceFeatureChain &operator=(const DeviceFeatureChain &) = delete;
+
+    void build(const DeviceFeatures &supported, bool wantSwapchain);
+    // Sets pNext, pEnabledFeatures and the extension list of info
+    void apply(VkDeviceCreateInfo &info) const;
+
+    const DeviceFeatures &enabled() const { return enabledFeatures; }
+
+private:
+    VkPhysicalDeviceFeatures2 features2{};
+    VkPhysicalDeviceVulkan12Features features12{};
+    VkPhysicalDeviceVulkan13Features features13{};
+    VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures{};
+    VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{};
+    std::vector<const char *> extensions;
+    DeviceFeatures enabledFeatures;
+};
@@ -0,0 +1,162 @@
+#include "frame_allocator.hpp"
+
+#include "vk_dispatch.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+void FrameAllocator::init(VkPhysicalDevice physicalDevice, VkDevice dev, GpuAllocator &gpuAllocator,
+                          LayoutCache &layouts, uint32_t frameCount, VkDeviceSize region) {
+    device = dev;
+    frames.assign(std::max(frameCount, 1u), Frame{});
+    currentFrame = 0;
+
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &props);
+    alignment = std::max(props.limits.minUniformBufferOffsetAlignment, props.limits.minStorageBufferOffsetAlignment);
+    range = std::min({MAX_DYNAMIC_RANGE, props.limits.maxUniformBufferRange, props.limits.maxStorageBufferRange});
+    // Aligned regions keep every allocation's absolute offset aligned too; the padding keeps
+    // offset + range inside the buffer for every offset
+    arena.init(gpuAllocator, (region + alignment - 1) / alignment * alignment, static_cast<uint32_t>(frames.size()),
+               VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, range);
+
+    VkDescriptorSetLayoutBinding bindings[2]{};
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+    bindings[1] = bindings[0];
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 2;
+    layoutInfo.pBindings = bindings;
+    dynamicSetLayout = layouts.descriptorSetLayout(layoutInfo);
+
+    // The dynamic set lives as long as the buffer, so it gets a pool of its own
+    VkDescriptorPoolSize poolSizes[2] = {
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1},
+    };
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = 2;
+    poolInfo.pPoolSizes = poolSizes;
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &dynamicPool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create frame allocator descriptor pool!");
+    }
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = dynamicPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &dynamicSetLayout;
+    if (vkAllocateDescriptorSets(device, &allocInfo, &dynamicDescriptorSet) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to allocate frame allocator descriptor set!");
+    }
+
+    VkDescriptorBufferInfo bufferInfo{arena.getBuffer(), 0, range};
+    VkWriteDescriptorSet writes[2]{};
+    for (uint32_t i = 0; i < 2; ++i) {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = dynamicDescriptorSet;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = bindings[i].descriptorType;
+        writes[i].pBufferInfo = &bufferInfo;
+    }
+    vkUpdateDescriptorSets(device, 2, writes, 0, nullptr);
+}
+
+void FrameAllocator::destroy() {
+    for (Frame &frame : frames) {
+        for (VkDescriptorPool pool : frame.pools) vkDestroyDescriptorPool(device, pool, nullptr);
+    }
+    frames.clear();
+    // Destroying the pool frees the dynamic set; the layout belongs to the layout cache
+    if (dynamicPool != VK_NULL_HANDLE) vkDestroyDescriptorPool(device, dynamicPool, nullptr);
+    arena.destroy();
+    dynamicPool = VK_NULL_HANDLE;
+    dynamicDescriptorSet = VK_NULL_HANDLE;
+    dynamicSetLayout = VK_NULL_HANDLE;
+}
+
+void FrameAllocator::beginFrame(uint32_t frameIndex) {
+    currentFrame = frameIndex;
+    Frame &frame = frames[frameIndex];
+    for (uint32_t i = 0; i < frame.usedPools; ++i) vkd.resetDescriptorPool(device, frame.pools[i], 0);
+    frame.usedPools = 0;
+    arena.reset(frameIndex);
+}
+
+FrameAllocation FrameAllocator::allocate(VkDeviceSize size) {
+    LinearFrameArena::Slice slice = arena.allocate(size, alignment);
+    if (slice.buffer == VK_NULL_HANDLE) {
+        throw std::runtime_error("Frame allocator is out of space; raise its region size!");
+    }
+    peakBytes = std::max(peakBytes, arena.bytesUsed());
+
+    FrameAllocation result;
+    result.buffer = slice.buffer;
+    result.offset = static_cast<uint32_t>(slice.offset);
+    result.mapped = slice.mapped;
+    return result;
+}
+
+VkDescriptorSet FrameAllocator::allocateSet(VkDescriptorSetLayout layout) {
+    Frame &frame = frames[currentFrame];
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+    // At most two tries: the pool in use, then a fresh one
+    for (uint32_t attempt = 0; attempt < 2; ++attempt) {
+        if (frame.usedPools == 0 || attempt == 1) {
+            if (frame.usedPools == frame.pools.size()) frame.pools.push_back(createPool());
+            ++frame.usedPools;
+        }
+        allocInfo.descriptorPool = frame.pools[frame.usedPools - 1];
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        VkResult result = vkd.allocateDescriptorSets(device, &allocInfo, &set);
+        if (result == VK_SUCCESS) {
+            ++setsAllocated;
+            return set;
+        }
+        if (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) break;
+    }
+    throw std::runtime_error("Failed to allocate a transient descriptor set!");
+}
+
+VkDescriptorPool FrameAllocator::createPool() {
+    // A mix that covers a few descriptors of each common type per set
+    const VkDescriptorType types[] = {
+        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,         VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC,
+        VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+        VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,          VK_DESCRIPTOR_TYPE_SAMPLER,
+    };
+    std::vector<VkDescriptorPoolSize> sizes;
+    for (VkDescriptorType type : types) sizes.push_back({type, SETS_PER_POOL * 4});
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = SETS_PER_POOL;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(sizes.size());
+    poolInfo.pPoolSizes = sizes.data();
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create frame descriptor pool!");
+    }
+    ++poolsCreated;
+    return pool;
+}
+
+FrameAllocatorStats FrameAllocator::stats() const {
+    FrameAllocatorStats s;
+    s.peakBytes = peakBytes;
+    s.regionBytes = arena.capacityPerFrame();
+    s.setsAllocated = setsAllocated;
+    s.poolsCreated = poolsCreated;
+    return s;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "gpu_allocator.hpp"
+#include "layout_cache.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Bump allocation in the current frame's region of the transient buffer
+struct FrameAllocation {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    // Byte offset into buffer, and the dynamic offset to bind dynamicSet() with
+    uint32_t offset = 0;
+    void *mapped = nullptr;
+};
+
+struct FrameAllocatorStats {
+    // Largest amount a single frame used, and the capacity per frame
+    VkDeviceSize peakBytes = 0;
+    VkDeviceSize regionBytes = 0;
+    // Sets handed out by allocateSet() over the allocator's lifetime
+    uint64_t setsAllocated = 0;
+    uint32_t poolsCreated = 0;
+};
+
+// Short-lived per-frame data. Each frame in flight owns a region of a LinearFrameArena that
+// allocate() bumps through, and a list of descriptor pools that
+// allocateSet() draws from; beginFrame() rewinds the region and resets the pools wholesale
+// once the slot's fence has signalled, so nothing is ever freed individually.
+//
+// Small uniform or storage data is bound through dynamicSet(): binding 0 is a
+// UNIFORM_BUFFER_DYNAMIC and binding 1 a STORAGE_BUFFER_DYNAMIC over the buffer, each
+// dynamicRange() bytes wide, so one set serves every frame with the allocation's offset as
+// the dynamic offset. Render thread only.
+class FrameAllocator {
+public:
+    static constexpr VkDeviceSize DEFAULT_REGION_SIZE = 4ull * 1024 * 1024;
+    // Upper bound of dynamicRange(); devices may only allow 16 KiB of uniform range
+    static constexpr uint32_t MAX_DYNAMIC_RANGE = 64 * 1024;
+    static constexpr uint32_t SETS_PER_POOL = 256;
+
+    void init(VkPhysicalDevice physicalDevice, VkDevice device, GpuAllocator &allocator, LayoutCache &layouts,
+              uint32_t frameCount, VkDeviceSize regionSize = DEFAULT_REGION_SIZE);
+    // The GPU must be done with every frame
+    void destroy();
+
+    // Call after waiting on frameIndex's fence
+    void beginFrame(uint32_t frameIndex);
+
+    // Aligned for both uniform and storage buffer offsets; throws when the frame's region is full
+    FrameAllocation allocate(VkDeviceSize size);
+    template <typename T>
+    FrameAllocation push(const T &value) {
+        FrameAllocation allocation = allocate(sizeof(T));
+        std::memcpy(allocation.mapped, &value, sizeof(T));
+        return allocation;
+    }
+
+    VkDescriptorSetLayout dynamicLayout() const { return dynamicSetLayout; }
+    VkDescriptorSet dynamicSet() const { return dynamicDescriptorSet; }
+    // Bytes the shader can see past a dynamic offset
+    uint32_t dynamicRange() const { return range; }
+
+    // Valid until this frame slot is begun again
+    VkDescriptorSet allocateSet(VkDescriptorSetLayout layout);
+
+    FrameAllocatorStats stats() const;
+
+private:
+    struct Frame {
+        std::vector<VkDescriptorPool> pools;
+        // Pools [0, usedPools) have handed out sets this frame
+        uint32_t usedPools = 0;
+    };
+
+    VkDescriptorPool createPool();
+
+    VkDevice device = VK_NULL_HANDLE;
+    LinearFrameArena arena;
+    VkDeviceSize alignment = 1;
+    uint32_t range = 0;
+    std::vector<Frame> frames;
+    uint32_t currentFrame = 0;
+
+    VkDescriptorSetLayout dynamicSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool dynamicPool = VK_NULL_HANDLE;
+    VkDescriptorSet dynamicDescriptorSet = VK_NULL_HANDLE;
+
+    VkDeviceSize peakBytes = 0;
+    uint64_t setsAllocated = 0;
+    uint32_t poolsCreated = 0;
+};
@@ -0,0 +1,233 @@
+#include "frame_capture.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+void FrameCapture::init(VkDevice dev, GpuAllocator &gpuAllocator, uint32_t frames, const std::string &path) {
+    device = dev;
+    allocator = &gpuAllocator;
+    frameCount = std::max(frames, 1u);
+    outputPath = path;
+    format = formatForPath(path);
+    if (format == CaptureFormat::Y4m) {
+        stream.open(path, std::ios::binary);
+        if (!stream) {
+            throw std::runtime_error("Failed to open capture output: " + path);
+        }
+    }
+    // One slot per frame in flight plus the one being recorded can never all be busy on the
+    // GPU at once, so acquire() only ever waits for the encoder
+    slots.assign(frameCount + 1 + ENCODER_SLOTS, Slot{});
+    stopping = false;
+    writeFailed = false;
+    counters = {};
+    encoder = std::thread([this] { encoderLoop(); });
+}
+
+void FrameCapture::destroy() {
+    if (!enabled()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // The GPU is idle, so every copy still in flight has landed
+        std::vector<uint32_t> done;
+        for (uint32_t i = 0; i < slots.size(); ++i) {
+            if (slots[i].state == SlotState::InFlight) done.push_back(i);
+        }
+        std::sort(done.begin(), done.end(), [&](uint32_t a, uint32_t b) { return slots[a].frame < slots[b].frame; });
+        for (uint32_t i : done) {
+            allocator->invalidate(slots[i].allocation);
+            slots[i].state = SlotState::Encoding;
+            queue.push_back(i);
+        }
+        stopping = true;
+    }
+    work.notify_one();
+    encoder.join();
+
+    for (Slot &slot : slots) {
+        if (slot.buffer != VK_NULL_HANDLE) allocator->destroyBuffer(slot.buffer, slot.allocation);
+    }
+    slots.clear();
+    if (stream.is_open()) stream.close();
+}
+
+CaptureFormat FrameCapture::formatForPath(const std::string &path) {
+    const std::string ext = ".y4m";
+    if (path.size() >= ext.size() && path.compare(path.size() - ext.size(), ext.size(), ext) == 0) {
+        return CaptureFormat::Y4m;
+    }
+    return CaptureFormat::PpmSequence;
+}
+
+bool FrameCapture::isSupportedFormat(VkFormat fmt) {
+    switch (fmt) {
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SRGB:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void FrameCapture::beginFrame(uint64_t frameNumber) {
+    std::vector<uint32_t> done;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (uint32_t i = 0; i < slots.size(); ++i) {
+            const Slot &slot = slots[i];
+            if (slot.state == SlotState::InFlight && frameNumber >= slot.frame + frameCount) done.push_back(i);
+        }
+        if (done.empty()) return;
+        std::sort(done.begin(), done.end(), [&](uint32_t a, uint32_t b) { return slots[a].frame < slots[b].frame; });
+        for (uint32_t i : done) {
+            // Non-coherent readback memory must be invalidated before the host reads it
+            allocator->invalidate(slots[i].allocation);
+            slots[i].state = SlotState::Encoding;
+            queue.push_back(i);
+        }
+    }
+    work.notify_one();
+}
+
+VkBuffer FrameCapture::acquire(uint64_t frameNumber, VkExtent2D extent, VkFormat fmt) {
+    if (!isSupportedFormat(fmt)) {
+        throw std::runtime_error("Frame capture needs an 8-bit RGBA or BGRA target!");
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    auto freeSlot = [&] {
+        return std::find_if(slots.begin(), slots.end(), [](const Slot &s) { return s.state == SlotState::Free; });
+    };
+    auto it = freeSlot();
+    if (it == slots.end()) {
+        auto start = std::chrono::steady_clock::now();
+        slotFreed.wait(lock, [&] { return (it = freeSlot()) != slots.end(); });
+        ++counters.encoderStalls;
+        counters.stallMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    Slot &slot = *it;
+    if (slot.buffer == VK_NULL_HANDLE || slot.extent.width != extent.width || slot.extent.height != extent.height) {
+        // A free slot is idle on both the GPU and the encoder, so it can be replaced right away
+        if (slot.buffer != VK_NULL_HANDLE) allocator->destroyBuffer(slot.buffer, slot.allocation);
+        VkBufferCreateInfo bufInfo{};
+        bufInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufInfo.size = frameBytes(extent);
+        bufInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        bufInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        slot.buffer = allocator->createBuffer(bufInfo, MemoryUsage::GpuToCpu, slot.allocation);
+        slot.extent = extent;
+    }
+    slot.format = fmt;
+    slot.frame = frameNumber;
+    slot.state = SlotState::InFlight;
+    ++counters.framesCaptured;
+    return slot.buffer;
+}
+
+FrameCaptureStats FrameCapture::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
+
+void FrameCapture::encoderLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        work.wait(lock, [&] { return stopping || !queue.empty(); });
+        if (queue.empty()) return;
+        uint32_t index = queue.front();
+        queue.pop_front();
+        // The slot is ours until it is marked free again; acquire() never touches it meanwhile
+        const Slot &slot = slots[index];
+        lock.unlock();
+
+        auto start = std::chrono::steady_clock::now();
+        bool written = encode(slot);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        lock.lock();
+        slots[index].state = SlotState::Free;
+        counters.encodeMs += ms;
+        ++(written ? counters.framesWritten : counters.framesDropped);
+        slotFreed.notify_one();
+    }
+}
+
+bool FrameCapture::encode(const Slot &slot) {
+    if (writeFailed) return false;
+    bool ok = format == CaptureFormat::Y4m ? writeY4m(slot) : writePpm(slot);
+    if (!ok && writeFailed) {
+        std::cerr << "Frame capture stopped: failed to write " << outputPath << "\n";
+    }
+    return ok;
+}
+
+bool FrameCapture::writePpm(const Slot &slot) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%06llu.ppm", static_cast<unsigned long long>(slot.frame));
+    std::ofstream out(outputPath + name, std::ios::binary);
+    if (!out) {
+        writeFailed = true;
+        return false;
+    }
+    out << "P6\n" << slot.extent.width << " " << slot.extent.height << "\n255\n";
+
+    bool bgra = slot.format == VK_FORMAT_B8G8R8A8_UNORM || slot.format == VK_FORMAT_B8G8R8A8_SRGB;
+    uint32_t r = bgra ? 2 : 0;
+    uint32_t b = bgra ? 0 : 2;
+    const uint8_t *pixels = static_cast<const uint8_t*>(slot.allocation.mapped);
+    std::vector<uint8_t> row(static_cast<size_t>(slot.extent.width) * 3);
+    for (uint32_t y = 0; y < slot.extent.height; ++y) {
+        const uint8_t *src = pixels + static_cast<size_t>(y) * slot.extent.width * 4;
+        for (uint32_t x = 0; x < slot.extent.width; ++x) {
+            row[x * 3 + 0] = src[x * 4 + r];
+            row[x * 3 + 1] = src[x * 4 + 1];
+            row[x * 3 + 2] = src[x * 4 + b];
+        }
+        out.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size()));
+    }
+    if (!out) writeFailed = true;
+    return !writeFailed;
+}
+
+bool FrameCapture::writeY4m(const Slot &slot) {
+    if (streamExtent.width == 0) {
+        streamExtent = slot.extent;
+        stream << "YUV4MPEG2 W" << streamExtent.width << " H" << streamExtent.height << " F60:1 Ip A1:1 C444\n";
+    } else if (slot.extent.width != streamExtent.width || slot.extent.height != streamExtent.height) {
+        return false;
+    }
+    stream << "FRAME\n";
+
+    bool bgra = slot.format == VK_FORMAT_B8G8R8A8_UNORM || slot.format == VK_FORMAT_B8G8R8A8_SRGB;
+    uint32_t r = bgra ? 2 : 0;
+    uint32_t b = bgra ? 0 : 2;
+    const uint8_t *pixels = static_cast<const uint8_t*>(slot.allocation.mapped);
+    std::vector<uint8_t> row(slot.extent.width);
+    // Planar Y, U, V in BT.601 studio range, each plane converted row by row from the mapping
+    for (uint32_t plane = 0; plane < 3; ++plane) {
+        for (uint32_t y = 0; y < slot.extent.height; ++y) {
+            const uint8_t *src = pixels + static_cast<size_t>(y) * slot.extent.width * 4;
+            for (uint32_t x = 0; x < slot.extent.width; ++x) {
+                int R = src[x * 4 + r];
+                int G = src[x * 4 + 1];
+                int B = src[x * 4 + b];
+                int value;
+                if (plane == 0) {
+                    value = ((66 * R + 129 * G + 25 * B + 128) >> 8) + 16;
+                } else if (plane == 1) {
+                    value = ((-38 * R - 74 * G + 112 * B + 128) >> 8) + 128;
+                } else {
+                    value = ((112 * R - 94 * G - 18 * B + 128) >> 8) + 128;
+                }
+                row[x] = static_cast<uint8_t>(value);
+            }
+            stream.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size()));
+        }
+    }
+    if (!stream) writeFailed = true;
+    return !writeFailed;
+}
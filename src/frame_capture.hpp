@@ -0,0 +1,101 @@
+#pragma once
+
+#include "gpu_allocator.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class CaptureFormat {
+    // One binary PPM per frame, named <path>NNNNNN.ppm
+    PpmSequence,
+    // A single 4:4:4 YUV4MPEG2 stream; frames whose size differs from the first are dropped
+    Y4m,
+};
+
+struct FrameCaptureStats {
+    uint64_t framesCaptured = 0;
+    uint64_t framesWritten = 0;
+    // Resized frames a Y4M stream can't hold, and frames after a write error
+    uint64_t framesDropped = 0;
+    // Captures that had to wait for the encoder because every ring slot was busy
+    uint64_t encoderStalls = 0;
+    double stallMs = 0.0;
+    double encodeMs = 0.0;
+};
+
+// Streams rendered frames to disk without stalling the GPU. Each captured frame is copied
+// into one of a ring of persistently mapped readback buffers while the frame is recorded.
+// Like DeletionQueue, frame k's copy is known to be done once frame k + frameCount begins
+// (its fence has been waited on), so completion is polled in beginFrame() and the slot is
+// handed to an encoder thread, which converts rows straight out of the mapping into the
+// output file. The render thread only blocks when the encoder falls a whole ring behind.
+class FrameCapture {
+public:
+    // Slots beyond the frames in flight; the encoder may lag this many frames before captures wait
+    static constexpr uint32_t ENCODER_SLOTS = 4;
+
+    // path ending in .y4m selects a Y4M stream, anything else is a PPM file prefix
+    void init(VkDevice device, GpuAllocator &allocator, uint32_t frameCount, const std::string &path);
+    // Encodes every captured frame still queued; the GPU must be idle
+    void destroy();
+    bool enabled() const { return encoder.joinable(); }
+
+    static CaptureFormat formatForPath(const std::string &path);
+    // Tightly packed 4-byte texels
+    static VkDeviceSize frameBytes(VkExtent2D extent) { return static_cast<VkDeviceSize>(extent.width) * extent.height * 4; }
+    // 8-bit RGBA and BGRA formats, UNORM or SRGB
+    static bool isSupportedFormat(VkFormat format);
+
+    // Call after waiting on frameNumber's fence; queues the completed captures for encoding
+    void beginFrame(uint64_t frameNumber);
+    // Reserves a slot for the frame being recorded and returns the buffer its image must be
+    // copied into (frameBytes(extent), TRANSFER_DST). Reallocates the slot on a size change.
+    VkBuffer acquire(uint64_t frameNumber, VkExtent2D extent, VkFormat format);
+
+    FrameCaptureStats stats() const;
+    const std::string &path() const { return outputPath; }
+
+private:
+    enum class SlotState { Free, InFlight, Encoding };
+
+    struct Slot {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        GpuAllocation allocation;
+        VkExtent2D extent{};
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        uint64_t frame = 0;
+        SlotState state = SlotState::Free;
+    };
+
+    void encoderLoop();
+    bool encode(const Slot &slot);
+    bool writePpm(const Slot &slot);
+    bool writeY4m(const Slot &slot);
+
+    VkDevice device = VK_NULL_HANDLE;
+    GpuAllocator *allocator = nullptr;
+    uint32_t frameCount = 1;
+    CaptureFormat format = CaptureFormat::PpmSequence;
+    std::string outputPath;
+    // Y4M only; written by the encoder thread
+    std::ofstream stream;
+    VkExtent2D streamExtent{};
+    bool writeFailed = false;
+
+    std::vector<Slot> slots;
+    std::thread encoder;
+    mutable std::mutex mutex;
+    std::condition_variable work;
+    std::condition_variable slotFreed;
+    std::deque<uint32_t> queue;
+    bool stopping = false;
+    FrameCaptureStats counters;
+};
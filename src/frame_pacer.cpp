@@ -0,0 +1,190 @@
+#include "frame_pacer.hpp"
+
+#include "vk_dispatch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace {
+
+constexpr uint32_t SAMPLE_WINDOW = 240;
+// Presents the latency measurement may have outstanding; older ones are dropped unmeasured
+constexpr size_t MAX_PENDING_PRESENTS = 16;
+// Bounds the low-latency wait so a present that never completes (e.g. a hidden window) can't hang the loop
+constexpr uint64_t PRESENT_WAIT_TIMEOUT_NS = 100ull * 1000 * 1000;
+// The limiter sleeps until this close to the deadline and spins the rest; sleeps overshoot by about this much
+constexpr std::chrono::microseconds SPIN_WINDOW{1000};
+
+double mean(const std::vector<double> &samples) {
+    if (samples.empty()) return 0.0;
+    double sum = 0.0;
+    for (double s : samples) sum += s;
+    return sum / static_cast<double>(samples.size());
+}
+
+} // namespace
+
+void FramePacer::init(VkDevice dev, const FramePacerConfig &pacerConfig, bool presentWait) {
+    device = dev;
+    config = pacerConfig;
+    config.targetFps = std::max(config.targetFps, 1.0);
+    waitForPresent = nullptr;
+    if (presentWait) {
+        waitForPresent = reinterpret_cast<PFN_vkWaitForPresentKHR>(vkGetDeviceProcAddr(device, "vkWaitForPresentKHR"));
+    }
+    frameMs.clear();
+    latencyMs.clear();
+    nextFrame = 0;
+    nextLatency = 0;
+    havePresent = false;
+    nextDeadline = Clock::time_point{};
+}
+
+VkPresentModeKHR FramePacer::choosePresentMode(const std::vector<VkPresentModeKHR> &available) const {
+    auto has = [&](VkPresentModeKHR mode) { return std::find(available.begin(), available.end(), mode) != available.end(); };
+    if (config.policy == PacingPolicy::Throughput) {
+        if (has(VK_PRESENT_MODE_MAILBOX_KHR)) return VK_PRESENT_MODE_MAILBOX_KHR;
+        if (has(VK_PRESENT_MODE_IMMEDIATE_KHR)) return VK_PRESENT_MODE_IMMEDIATE_KHR;
+    }
+    return VK_PRESENT_MODE_FIFO_KHR; // guaranteed
+}
+
+uint32_t FramePacer::chooseImageCount(const VkSurfaceCapabilitiesKHR &capabilities) const {
+    uint32_t count = config.swapchainImages;
+    if (count == 0) {
+        // Double buffering keeps the FIFO queue one frame deep
+        count = config.policy == PacingPolicy::LowLatency ? 2 : capabilities.minImageCount + 1;
+    }
+    count = std::max(count, capabilities.minImageCount);
+    if (capabilities.maxImageCount > 0) count = std::min(count, capabilities.maxImageCount);
+    return count;
+}
+
+void FramePacer::swapchainCreated(VkSwapchainKHR newSwapchain, VkPresentModeKHR mode, uint32_t images) {
+    swapchain = newSwapchain;
+    presentMode = mode;
+    imageCount = images;
+    pendingPresents.clear();
+    presentId = 0;
+    // The resize gap is not a frame time
+    havePresent = false;
+}
+
+void FramePacer::waitBeforeInput(VkFence previousFrameFence) {
+    if (config.policy == PacingPolicy::LowLatency) {
+        // Nothing new is queued until the previous frame is on screen, so the input polled next
+        // is at most one frame old when its frame is displayed
+        if (waitForPresent != nullptr && presentId != 0) {
+            waitForPresent(device, swapchain, presentId, PRESENT_WAIT_TIMEOUT_NS);
+        } else if (previousFrameFence != VK_NULL_HANDLE) {
+            vkd.waitForFences(device, 1, &previousFrameFence, VK_TRUE, UINT64_MAX);
+        }
+    } else if (config.policy == PacingPolicy::FixedRate) {
+        auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / config.targetFps));
+        if (nextDeadline != Clock::time_point{}) sleepUntil(nextDeadline);
+        Clock::time_point now = Clock::now();
+        // After a long stall start a new schedule instead of rushing to catch up
+        nextDeadline = nextDeadline == Clock::time_point{} || now - nextDeadline > period ? now + period
+                                                                                            : nextDeadline + period;
+    }
+    pollPresents();
+    inputTime = Clock::now();
+}
+
+void FramePacer::preparePresent(VkPresentInfoKHR &presentInfo) {
+    if (waitForPresent == nullptr) return;
+    presentId = nextPresentId++;
+    presentIdInfo = VkPresentIdKHR{};
+    presentIdInfo.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+    presentIdInfo.pNext = presentInfo.pNext;
+    presentIdInfo.swapchainCount = 1;
+    presentIdInfo.pPresentIds = &presentId;
+    presentInfo.pNext = &presentIdInfo;
+}
+
+void FramePacer::framePresented() {
+    Clock::time_point now = Clock::now();
+    if (havePresent) {
+        addSample(frameMs, nextFrame, std::chrono::duration<double, std::milli>(now - lastPresent).count());
+    }
+    lastPresent = now;
+    havePresent = true;
+
+    if (waitForPresent != nullptr) {
+        pendingPresents.push_back({presentId, inputTime});
+        if (pendingPresents.size() > MAX_PENDING_PRESENTS) pendingPresents.pop_front();
+        return;
+    }
+    // FIFO shows images in order, so a full queue delays the frame by one refresh per image
+    // ahead of it; mailbox and immediate show the newest image next
+    bool fifo = presentMode == VK_PRESENT_MODE_FIFO_KHR || presentMode == VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+    uint32_t queued = fifo && config.policy != PacingPolicy::LowLatency ? std::max(imageCount, 2u) - 1 : 1;
+    double inputToPresent = std::chrono::duration<double, std::milli>(now - inputTime).count();
+    addSample(latencyMs, nextLatency, inputToPresent + mean(frameMs) * queued);
+}
+
+// Present ids complete in order, so the oldest pending one is always checked first
+void FramePacer::pollPresents() {
+    while (!pendingPresents.empty()) {
+        VkResult result = waitForPresent(device, swapchain, pendingPresents.front().id, 0);
+        if (result == VK_TIMEOUT) break;
+        if (result != VK_SUCCESS) {
+            // Out of date or surface lost; the swapchain is about to be recreated
+            pendingPresents.clear();
+            break;
+        }
+        addSample(latencyMs, nextLatency,
+                  std::chrono::duration<double, std::milli>(Clock::now() - pendingPresents.front().inputTime).count());
+        pendingPresents.pop_front();
+    }
+}
+
+void FramePacer::sleepUntil(Clock::time_point deadline) const {
+    if (deadline - Clock::now() > SPIN_WINDOW) std::this_thread::sleep_until(deadline - SPIN_WINDOW);
+    while (Clock::now() < deadline) std::this_thread::yield();
+}
+
+void FramePacer::addSample(std::vector<double> &samples, uint32_t &next, double value) {
+    if (samples.size() < SAMPLE_WINDOW) {
+        samples.push_back(value);
+    } else {
+        samples[next] = value;
+    }
+    next = (next + 1) % SAMPLE_WINDOW;
+}
+
+FramePacingStats FramePacer::stats() const {
+    FramePacingStats s;
+    s.frames = static_cast<uint32_t>(frameMs.size());
+    s.latencyMeasured = waitForPresent != nullptr;
+    s.latencyMs = mean(latencyMs);
+    if (frameMs.empty()) return s;
+    s.meanMs = mean(frameMs);
+    double variance = 0.0;
+    for (double ms : frameMs) variance += (ms - s.meanMs) * (ms - s.meanMs);
+    s.stddevMs = std::sqrt(variance / static_cast<double>(frameMs.size()));
+    auto [minIt, maxIt] = std::minmax_element(frameMs.begin(), frameMs.end());
+    s.minMs = *minIt;
+    s.maxMs = *maxIt;
+    return s;
+}
+
+const char *FramePacer::policyName(PacingPolicy policy) {
+    switch (policy) {
+    case PacingPolicy::Throughput: return "throughput";
+    case PacingPolicy::LowLatency: return "low-latency";
+    case PacingPolicy::FixedRate: return "fixed";
+    }
+    return "unknown";
+}
+
+bool FramePacer::parsePolicy(const std::string &name, PacingPolicy &out) {
+    for (PacingPolicy policy : {PacingPolicy::Throughput, PacingPolicy::LowLatency, PacingPolicy::FixedRate}) {
+        if (name == policyName(policy)) {
+            out = policy;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+enum class PacingPolicy {
+    // Mailbox (or immediate) with a spare image: as many frames as the GPU can render
+    Throughput,
+    // FIFO with the fewest images the surface allows; the CPU waits for the previous frame to
+    // be presented before polling input, so input is sampled as late as possible
+    LowLatency,
+    // FIFO plus a CPU frame limiter at targetFps, for even frame times below the refresh rate
+    FixedRate,
+};
+
+struct FramePacerConfig {
+    PacingPolicy policy = PacingPolicy::Throughput;
+    // 0 picks the policy's default; clamped to what the surface supports
+    uint32_t swapchainImages = 0;
+    double targetFps = 60.0;
+};
+
+// Over the most recent frames, in milliseconds. Frame times are present-to-present on the
+// CPU. Latency runs from the input poll to the frame reaching the display when present wait
+// is enabled (accurate to the polling granularity of one frame); otherwise it is estimated as
+// input-to-present plus one frame time per image queued ahead in the swapchain.
+struct FramePacingStats {
+    uint32_t frames = 0;
+    double meanMs = 0.0;
+    double stddevMs = 0.0;
+    double minMs = 0.0;
+    double maxMs = 0.0;
+    double latencyMs = 0.0;
+    bool latencyMeasured = false;
+};
+
+// Frame pacing policy: picks the present mode and swapchain image count, waits before input
+// is polled (low latency) or before the frame starts (fixed rate), tags presents with
+// VK_KHR_present_id when available and measures frame-time variance and latency.
+class FramePacer {
+public:
+    // presentWait: VK_KHR_present_id and VK_KHR_present_wait are enabled on the device
+    void init(VkDevice device, const FramePacerConfig &config, bool presentWait);
+
+    VkPresentModeKHR choosePresentMode(const std::vector<VkPresentModeKHR> &available) const;
+    uint32_t chooseImageCount(const VkSurfaceCapabilitiesKHR &capabilities) const;
+    // Pending present waits refer to the previous swapchain, so they are dropped
+    void swapchainCreated(VkSwapchainKHR swapchain, VkPresentModeKHR presentMode, uint32_t imageCount);
+
+    // Call right before polling input. previousFrameFence is the fence of the last frame
+    // submitted; low latency waits on it when present wait is unavailable.
+    void waitBeforeInput(VkFence previousFrameFence);
+    // Chains a VkPresentIdKHR in front of presentInfo.pNext when present wait is enabled
+    void preparePresent(VkPresentInfoKHR &presentInfo);
+    // Call after vkQueuePresentKHR returned
+    void framePresented();
+
+    FramePacingStats stats() const;
+    PacingPolicy policy() const { return config.policy; }
+    static const char *policyName(PacingPolicy policy);
+    // Accepts "throughput", "low-latency" and "fixed"; returns false otherwise
+    static bool parsePolicy(const std::string &name, PacingPolicy &out);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct PendingPresent {
+        uint64_t id;
+        Clock::time_point inputTime;
+    };
+
+    void pollPresents();
+    void sleepUntil(Clock::time_point deadline) const;
+    void addSample(std::vector<double> &samples, uint32_t &next, double value);
+
+    VkDevice device = VK_NULL_HANDLE;
+    FramePacerConfig config;
+    PFN_vkWaitForPresentKHR waitForPresent = nullptr;
+
+    VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+    VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    uint32_t imageCount = 0;
+
+    uint64_t nextPresentId = 1;
+    uint64_t presentId = 0;
+    VkPresentIdKHR presentIdInfo{};
+    std::deque<PendingPresent> pendingPresents;
+
+    Clock::time_point inputTime{};
+    Clock::time_point lastPresent{};
+    Clock::time_point nextDeadline{};
+    bool havePresent = false;
+
+    std::vector<double> frameMs;
+    uint32_t nextFrame = 0;
+    std::vector<double> latencyMs;
+    uint32_t nextLatency = 0;
+};
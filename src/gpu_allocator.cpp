@@ -0,0 +1,704 @@
+#include "gpu_allocator.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+
+uint32_t highestBit(uint64_t v) {
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanReverse64(&idx, v);
+    return static_cast<uint32_t>(idx);
+#else
+    return 63u - static_cast<uint32_t>(__builtin_clzll(v));
+#endif
+}
+
+uint32_t lowestBit(uint64_t v) {
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward64(&idx, v);
+    return static_cast<uint32_t>(idx);
+#else
+    return static_cast<uint32_t>(__builtin_ctzll(v));
+#endif
+}
+
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+VkDeviceSize alignDown(VkDeviceSize value, VkDeviceSize alignment) {
+    return value / alignment * alignment;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------------------
+// TlsfAllocator
+
+TlsfAllocator::TlsfAllocator(VkDeviceSize size) : totalSize(size) {
+    for (auto &row : heads) {
+        for (auto &head : row) head = INVALID_NODE;
+    }
+    uint32_t n = newNode();
+    nodes[n].offset = 0;
+    nodes[n].size = size;
+    firstPhysical = n;
+    insertFree(n);
+}
+
+void TlsfAllocator::mapping(VkDeviceSize size, uint32_t &fl, uint32_t &sl) {
+    if (size < SMALL_SIZE) {
+        fl = 0;
+        sl = static_cast<uint32_t>(size / (SMALL_SIZE / SL_COUNT));
+    } else {
+        uint32_t f = highestBit(size);
+        sl = static_cast<uint32_t>((size >> (f - SL_LOG2)) ^ SL_COUNT);
+        fl = f - SMALL_LOG2 + 1;
+    }
+}
+
+uint32_t TlsfAllocator::newNode() {
+    if (!unusedNodes.empty()) {
+        uint32_t n = unusedNodes.back();
+        unusedNodes.pop_back();
+        nodes[n] = Node{};
+        return n;
+    }
+    nodes.emplace_back();
+    return static_cast<uint32_t>(nodes.size() - 1);
+}
+
+void TlsfAllocator::releaseNode(uint32_t n) {
+    unusedNodes.push_back(n);
+}
+
+void TlsfAllocator::insertFree(uint32_t n) {
+    uint32_t fl, sl;
+    mapping(nodes[n].size, fl, sl);
+    nodes[n].free = true;
+    nodes[n].prevFree = INVALID_NODE;
+    nodes[n].nextFree = heads[fl][sl];
+    if (heads[fl][sl] != INVALID_NODE) nodes[heads[fl][sl]].prevFree = n;
+    heads[fl][sl] = n;
+    flBitmap |= uint64_t(1) << fl;
+    slBitmap[fl] |= 1u << sl;
+}
+
+void TlsfAllocator::removeFree(uint32_t n) {
+    uint32_t fl, sl;
+    mapping(nodes[n].size, fl, sl);
+    Node &node = nodes[n];
+    if (node.prevFree != INVALID_NODE) nodes[node.prevFree].nextFree = node.nextFree;
+    if (node.nextFree != INVALID_NODE) nodes[node.nextFree].prevFree = node.prevFree;
+    if (heads[fl][sl] == n) {
+        heads[fl][sl] = node.nextFree;
+        if (heads[fl][sl] == INVALID_NODE) {
+            slBitmap[fl] &= ~(1u << sl);
+            if (slBitmap[fl] == 0) flBitmap &= ~(uint64_t(1) << fl);
+        }
+    }
+    node.prevFree = node.nextFree = INVALID_NODE;
+}
+
+// Returns the head of the first non-empty size class whose every member is >= size
+uint32_t TlsfAllocator::findFree(VkDeviceSize size) const {
+    if (size < SMALL_SIZE) {
+        size += (SMALL_SIZE / SL_COUNT) - 1;
+    } else {
+        size += (VkDeviceSize(1) << (highestBit(size) - SL_LOG2)) - 1;
+    }
+
+    uint32_t fl, sl;
+    mapping(size, fl, sl);
+    if (fl >= FL_COUNT) return INVALID_NODE;
+
+    uint32_t slMap = slBitmap[fl] & (~0u << sl);
+    if (slMap == 0) {
+        uint64_t flMap = (fl + 1 < 64) ? (flBitmap & (~uint64_t(0) << (fl + 1))) : 0;
+        if (flMap == 0) return INVALID_NODE;
+        fl = lowestBit(flMap);
+        slMap = slBitmap[fl];
+    }
+    sl = lowestBit(slMap);
+    return heads[fl][sl];
+}
+
+uint32_t TlsfAllocator::allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &outOffset, void *userData) {
+    if (size == 0) size = 1;
+    if (alignment == 0) alignment = 1;
+
+    // Searching for the worst-case padded size keeps the lookup O(1)
+    uint32_t n = findFree(size + alignment - 1);
+    if (n == INVALID_NODE) return INVALID_NODE;
+    removeFree(n);
+
+    VkDeviceSize aligned = alignUp(nodes[n].offset, alignment);
+    VkDeviceSize padding = aligned - nodes[n].offset;
+    if (padding >= MIN_SPLIT) {
+        uint32_t f = newNode();
+        nodes[f].offset = nodes[n].offset;
+        nodes[f].size = padding;
+        nodes[f].prevPhysical = nodes[n].prevPhysical;
+        nodes[f].nextPhysical = n;
+        if (nodes[f].prevPhysical != INVALID_NODE) nodes[nodes[f].prevPhysical].nextPhysical = f;
+        else firstPhysical = f;
+        nodes[n].prevPhysical = f;
+        nodes[n].offset += padding;
+        nodes[n].size -= padding;
+        insertFree(f);
+    }
+
+    VkDeviceSize used = (aligned - nodes[n].offset) + size;
+    VkDeviceSize remainder = nodes[n].size - used;
+    if (remainder >= MIN_SPLIT) {
+        uint32_t t = newNode();
+        nodes[t].offset = nodes[n].offset + used;
+        nodes[t].size = remainder;
+        nodes[t].prevPhysical = n;
+        nodes[t].nextPhysical = nodes[n].nextPhysical;
+        if (nodes[t].nextPhysical != INVALID_NODE) nodes[nodes[t].nextPhysical].prevPhysical = t;
+        nodes[n].nextPhysical = t;
+        nodes[n].size = used;
+        insertFree(t);
+    }
+
+    Node &node = nodes[n];
+    node.free = false;
+    node.alignedOffset = aligned;
+    node.requested = size;
+    node.alignment = alignment;
+    node.userData = userData;
+    reservedBytes += node.size;
+    requestedBytes += size;
+    ++liveAllocations;
+
+    outOffset = aligned;
+    return n;
+}
+
+void TlsfAllocator::free(uint32_t n) {
+    if (n == INVALID_NODE || nodes[n].free) return;
+
+    reservedBytes -= nodes[n].size;
+    requestedBytes -= nodes[n].requested;
+    --liveAllocations;
+    nodes[n].userData = nullptr;
+
+    // Coalesce with free physical neighbours so free ranges never sit next to each other
+    uint32_t prev = nodes[n].prevPhysical;
+    if (prev != INVALID_NODE && nodes[prev].free) {
+        removeFree(prev);
+        nodes[prev].size += nodes[n].size;
+        nodes[prev].nextPhysical = nodes[n].nextPhysical;
+        if (nodes[n].nextPhysical != INVALID_NODE) nodes[nodes[n].nextPhysical].prevPhysical = prev;
+        releaseNode(n);
+        n = prev;
+    }
+
+    uint32_t next = nodes[n].nextPhysical;
+    if (next != INVALID_NODE && nodes[next].free) {
+        removeFree(next);
+        nodes[n].size += nodes[next].size;
+        nodes[n].nextPhysical = nodes[next].nextPhysical;
+        if (nodes[next].nextPhysical != INVALID_NODE) nodes[nodes[next].nextPhysical].prevPhysical = n;
+        releaseNode(next);
+    }
+
+    insertFree(n);
+}
+
+VkDeviceSize TlsfAllocator::largestFreeRange() const {
+    if (flBitmap == 0) return 0;
+    uint32_t fl = highestBit(flBitmap);
+    uint32_t sl = highestBit(slBitmap[fl]);
+    VkDeviceSize largest = 0;
+    for (uint32_t n = heads[fl][sl]; n != INVALID_NODE; n = nodes[n].nextFree) {
+        largest = std::max(largest, nodes[n].size);
+    }
+    return largest;
+}
+
+// ---------------------------------------------------------------------------------------
+// GpuAllocator
+
+void GpuAllocator::init(VkPhysicalDevice pd, VkDevice dev, VkDeviceSize preferredBlockSize, bool memoryBudget) {
+    physicalDevice = pd;
+    device = dev;
+    budgetSupported = memoryBudget;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProps);
+
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties(physicalDevice, &props);
+    bufferImageGranularity = std::max<VkDeviceSize>(props.limits.bufferImageGranularity, 1);
+    nonCoherentAtomSize = std::max<VkDeviceSize>(props.limits.nonCoherentAtomSize, 1);
+
+    // Keeping buffers and optimal images in different blocks satisfies the granularity
+    // rule without padding every neighbour out to a page boundary.
+    separateLinearPools = bufferImageGranularity > 1;
+
+    uint32_t poolsPerType = separateLinearPools ? 2 : 1;
+    pools.resize(memProps.memoryTypeCount * poolsPerType);
+    for (uint32_t type = 0; type < memProps.memoryTypeCount; ++type) {
+        VkDeviceSize heapSize = memProps.memoryHeaps[memProps.memoryTypes[type].heapIndex].size;
+        // Small heaps (e.g. 256 MiB BAR windows) get proportionally smaller blocks
+        VkDeviceSize blockSize = heapSize <= 1024ull * 1024 * 1024 ? heapSize / 8 : preferredBlockSize;
+        blockSize = std::min(blockSize, preferredBlockSize);
+        for (uint32_t i = 0; i < poolsPerType; ++i) {
+            Pool &pool = pools[type * poolsPerType + i];
+            pool.memoryTypeIndex = type;
+            pool.blockSize = blockSize;
+        }
+    }
+}
+
+void GpuAllocator::destroy() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &pool : pools) {
+        for (auto &block : pool.blocks) {
+            vkFreeMemory(device, block->memory, nullptr);
+        }
+        pool.blocks.clear();
+    }
+    pools.clear();
+    device = VK_NULL_HANDLE;
+}
+
+uint32_t GpuAllocator::poolIndex(uint32_t memoryTypeIndex, bool linear) const {
+    return separateLinearPools ? memoryTypeIndex * 2 + (linear ? 0 : 1) : memoryTypeIndex;
+}
+
+std::vector<uint32_t> GpuAllocator::candidateMemoryTypes(uint32_t typeBits, MemoryUsage usage) const {
+    VkMemoryPropertyFlags required = 0;
+    VkMemoryPropertyFlags preferred = 0;
+    switch (usage) {
+    case MemoryUsage::GpuOnly:
+        preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        break;
+    case MemoryUsage::CpuToGpu:
+        required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        break;
+    case MemoryUsage::GpuToCpu:
+        required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+        preferred = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+        break;
+    }
+
+    std::vector<uint32_t> types;
+    for (uint32_t i = 0; i < memProps.memoryTypeCount; ++i) {
+        VkMemoryPropertyFlags flags = memProps.memoryTypes[i].propertyFlags;
+        if (!(typeBits & (1u << i))) continue;
+        if ((flags & required) != required) continue;
+        if (flags & VK_MEMORY_PROPERTY_PROTECTED_BIT) continue;
+        types.push_back(i);
+    }
+
+    // Drivers list types best-first, so a stable sort keeps their order within a score
+    std::stable_sort(types.begin(), types.end(), [&](uint32_t a, uint32_t b) {
+        bool pa = (memProps.memoryTypes[a].propertyFlags & preferred) == preferred;
+        bool pb = (memProps.memoryTypes[b].propertyFlags & preferred) == preferred;
+        return pa && !pb;
+    });
+    return types;
+}
+
+GpuAllocation GpuAllocator::allocate(const VkMemoryRequirements &reqs, MemoryUsage usage, bool linear,
+                                     bool dedicated, void *userData) {
+    return allocateFor(reqs, usage, linear, dedicated, userData, nullptr);
+}
+
+GpuAllocation GpuAllocator::allocateFor(const VkMemoryRequirements &reqs, MemoryUsage usage, bool linear,
+                                        bool dedicated, void *userData, const VkMemoryDedicatedAllocateInfo *resource) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto types = candidateMemoryTypes(reqs.memoryTypeBits, usage);
+    if (types.empty()) {
+        throw std::runtime_error("No memory type satisfies the allocation request!");
+    }
+
+    GpuAllocation out;
+    for (uint32_t type : types) {
+        uint32_t pool = poolIndex(type, linear);
+        // Anything larger than half a block would mostly waste the block it lands in
+        if (dedicated || reqs.size > pools[pool].blockSize / 2) {
+            if (allocateDedicated(type, reqs.size, resource, out)) return out;
+            continue;
+        }
+        if (allocateFromPool(pool, reqs, userData, out)) return out;
+    }
+    throw std::runtime_error("Failed to allocate device memory!");
+}
+
+bool GpuAllocator::allocateFromPool(uint32_t poolIdx, const VkMemoryRequirements &reqs, void *userData, GpuAllocation &out) {
+    Pool &pool = pools[poolIdx];
+    bool hostVisible = (memProps.memoryTypes[pool.memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+
+    auto tryBlock = [&](Block &block) {
+        VkDeviceSize offset = 0;
+        uint32_t node = block.tlsf->allocate(reqs.size, reqs.alignment, offset, userData);
+        if (node == TlsfAllocator::INVALID_NODE) return false;
+        out.memory = block.memory;
+        out.offset = offset;
+        out.size = reqs.size;
+        out.mapped = block.mapped ? static_cast<char*>(block.mapped) + offset : nullptr;
+        out.memoryTypeIndex = pool.memoryTypeIndex;
+        out.block = &block;
+        out.node = node;
+        return true;
+    };
+
+    for (auto &block : pool.blocks) {
+        if (tryBlock(*block)) return true;
+    }
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = pool.blockSize;
+    allocInfo.memoryTypeIndex = pool.memoryTypeIndex;
+
+    auto block = std::make_unique<Block>();
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &block->memory) != VK_SUCCESS) {
+        return false;
+    }
+    if (hostVisible && vkMapMemory(device, block->memory, 0, VK_WHOLE_SIZE, 0, &block->mapped) != VK_SUCCESS) {
+        vkFreeMemory(device, block->memory, nullptr);
+        return false;
+    }
+    block->pool = poolIdx;
+    block->tlsf = std::make_unique<TlsfAllocator>(pool.blockSize);
+    pool.blocks.push_back(std::move(block));
+    return tryBlock(*pool.blocks.back());
+}
+
+bool GpuAllocator::allocateDedicated(uint32_t memoryTypeIndex, VkDeviceSize size,
+                                     const VkMemoryDedicatedAllocateInfo *resource, GpuAllocation &out) {
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    // Required when the resource reports requiresDedicatedAllocation
+    allocInfo.pNext = resource;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+        return false;
+    }
+
+    void *mapped = nullptr;
+    if (memProps.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        if (vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS) {
+            vkFreeMemory(device, memory, nullptr);
+            return false;
+        }
+    }
+
+    out.memory = memory;
+    out.offset = 0;
+    out.size = size;
+    out.mapped = mapped;
+    out.memoryTypeIndex = memoryTypeIndex;
+    out.block = nullptr;
+    out.node = TlsfAllocator::INVALID_NODE;
+    ++dedicatedCount;
+    dedicatedBytes += size;
+    return true;
+}
+
+void GpuAllocator::free(GpuAllocation &allocation) {
+    std::lock_guard<std::mutex> lock(mutex);
+    freeLocked(allocation);
+}
+
+void GpuAllocator::freeLocked(GpuAllocation &allocation) {
+    if (!allocation) return;
+
+    if (allocation.block == nullptr) {
+        // Freeing implicitly unmaps
+        vkFreeMemory(device, allocation.memory, nullptr);
+        --dedicatedCount;
+        dedicatedBytes -= allocation.size;
+        allocation = GpuAllocation{};
+        return;
+    }
+
+    Block *block = static_cast<Block*>(allocation.block);
+    block->tlsf->free(allocation.node);
+    allocation = GpuAllocation{};
+
+    if (!block->tlsf->empty()) return;
+
+    // Keep one empty block per pool around so alloc/free churn doesn't hit the driver
+    Pool &pool = pools[block->pool];
+    size_t emptyBlocks = 0;
+    for (auto &b : pool.blocks) {
+        if (b->tlsf->empty()) ++emptyBlocks;
+    }
+    if (emptyBlocks > 1) {
+        auto it = std::find_if(pool.blocks.begin(), pool.blocks.end(),
+                               [block](const std::unique_ptr<Block> &b) { return b.get() == block; });
+        vkFreeMemory(device, block->memory, nullptr);
+        pool.blocks.erase(it);
+    }
+}
+
+VkBuffer GpuAllocator::createBuffer(const VkBufferCreateInfo &info, MemoryUsage usage, GpuAllocation &outAllocation, void *userData) {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    if (vkCreateBuffer(device, &info, nullptr, &buffer) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create buffer!");
+    }
+
+    VkBufferMemoryRequirementsInfo2 reqInfo{};
+    reqInfo.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2;
+    reqInfo.buffer = buffer;
+    VkMemoryDedicatedRequirements dedicatedReqs{};
+    dedicatedReqs.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+    VkMemoryRequirements2 reqs{};
+    reqs.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+    reqs.pNext = &dedicatedReqs;
+    vkGetBufferMemoryRequirements2(device, &reqInfo, &reqs);
+
+    VkMemoryDedicatedAllocateInfo resource{};
+    resource.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+    resource.buffer = buffer;
+    try {
+        bool dedicated = dedicatedReqs.requiresDedicatedAllocation || dedicatedReqs.prefersDedicatedAllocation;
+        outAllocation = allocateFor(reqs.memoryRequirements, usage, true, dedicated, userData, &resource);
+    } catch (...) {
+        vkDestroyBuffer(device, buffer, nullptr);
+        throw;
+    }
+    if (vkBindBufferMemory(device, buffer, outAllocation.memory, outAllocation.offset) != VK_SUCCESS) {
+        free(outAllocation);
+        vkDestroyBuffer(device, buffer, nullptr);
+        throw std::runtime_error("Failed to bind buffer memory!");
+    }
+    return buffer;
+}
+
+VkImage GpuAllocator::createImage(const VkImageCreateInfo &info, MemoryUsage usage, GpuAllocation &outAllocation, void *userData) {
+    VkImage image = VK_NULL_HANDLE;
+    if (vkCreateImage(device, &info, nullptr, &image) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create image!");
+    }
+
+    VkImageMemoryRequirementsInfo2 reqInfo{};
+    reqInfo.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+    reqInfo.image = image;
+    VkMemoryDedicatedRequirements dedicatedReqs{};
+    dedicatedReqs.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+    VkMemoryRequirements2 reqs{};
+    reqs.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+    reqs.pNext = &dedicatedReqs;
+    vkGetImageMemoryRequirements2(device, &reqInfo, &reqs);
+
+    VkMemoryDedicatedAllocateInfo resource{};
+    resource.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+    resource.image = image;
+    try {
+        bool dedicated = dedicatedReqs.requiresDedicatedAllocation || dedicatedReqs.prefersDedicatedAllocation;
+        outAllocation = allocateFor(reqs.memoryRequirements, usage, info.tiling == VK_IMAGE_TILING_LINEAR, dedicated,
+                                    userData, &resource);
+    } catch (...) {
+        vkDestroyImage(device, image, nullptr);
+        throw;
+    }
+    if (vkBindImageMemory(device, image, outAllocation.memory, outAllocation.offset) != VK_SUCCESS) {
+        free(outAllocation);
+        vkDestroyImage(device, image, nullptr);
+        throw std::runtime_error("Failed to bind image memory!");
+    }
+    return image;
+}
+
+void GpuAllocator::destroyBuffer(VkBuffer buffer, GpuAllocation &allocation) {
+    if (buffer != VK_NULL_HANDLE) vkDestroyBuffer(device, buffer, nullptr);
+    free(allocation);
+}
+
+void GpuAllocator::destroyImage(VkImage image, GpuAllocation &allocation) {
+    if (image != VK_NULL_HANDLE) vkDestroyImage(device, image, nullptr);
+    free(allocation);
+}
+
+void GpuAllocator::mappedRange(const GpuAllocation &allocation, VkDeviceSize offset, VkDeviceSize size, VkMappedMemoryRange &range) const {
+    VkDeviceSize memorySize = allocation.block ? static_cast<Block*>(allocation.block)->tlsf->size() : allocation.size;
+    if (size == VK_WHOLE_SIZE) size = allocation.size - offset;
+
+    VkDeviceSize begin = alignDown(allocation.offset + offset, nonCoherentAtomSize);
+    VkDeviceSize end = alignUp(allocation.offset + offset + size, nonCoherentAtomSize);
+
+    range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    range.pNext = nullptr;
+    range.memory = allocation.memory;
+    range.offset = begin;
+    range.size = end >= memorySize ? VK_WHOLE_SIZE : end - begin;
+}
+
+void GpuAllocator::flush(const GpuAllocation &allocation, VkDeviceSize offset, VkDeviceSize size) {
+    if (!allocation || !allocation.mapped) return;
+    if (memProps.memoryTypes[allocation.memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) return;
+    VkMappedMemoryRange range;
+    mappedRange(allocation, offset, size, range);
+    vkFlushMappedMemoryRanges(device, 1, &range);
+}
+
+void GpuAllocator::invalidate(const GpuAllocation &allocation, VkDeviceSize offset, VkDeviceSize size) {
+    if (!allocation || !allocation.mapped) return;
+    if (memProps.memoryTypes[allocation.memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) return;
+    VkMappedMemoryRange range;
+    mappedRange(allocation, offset, size, range);
+    vkInvalidateMappedMemoryRanges(device, 1, &range);
+}
+
+std::vector<DefragmentationMove> GpuAllocator::beginDefragmentation(uint32_t maxMoves) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<DefragmentationMove> moves;
+
+    for (auto &pool : pools) {
+        if (pool.blocks.size() < 2 || moves.size() >= maxMoves) continue;
+
+        // Evacuate the least-used block so it can be released once the moves complete
+        Block *source = nullptr;
+        for (auto &block : pool.blocks) {
+            if (block->tlsf->empty()) continue;
+            if (!source || block->tlsf->usedBytes() < source->tlsf->usedBytes()) source = block.get();
+        }
+        if (!source) continue;
+
+        struct Live { uint32_t node; VkDeviceSize offset, size, alignment; void *userData; };
+        std::vector<Live> live;
+        source->tlsf->forEachAllocation([&](uint32_t node, VkDeviceSize offset, VkDeviceSize size, VkDeviceSize alignment, void *userData) {
+            live.push_back({node, offset, size, alignment, userData});
+        });
+
+        for (const Live &a : live) {
+            if (moves.size() >= maxMoves) break;
+            for (auto &block : pool.blocks) {
+                if (block.get() == source) continue;
+                VkDeviceSize offset = 0;
+                uint32_t node = block->tlsf->allocate(a.size, a.alignment, offset, a.userData);
+                if (node == TlsfAllocator::INVALID_NODE) continue;
+
+                DefragmentationMove move;
+                move.src.memory = source->memory;
+                move.src.offset = a.offset;
+                move.src.size = a.size;
+                move.src.mapped = source->mapped ? static_cast<char*>(source->mapped) + a.offset : nullptr;
+                move.src.memoryTypeIndex = pool.memoryTypeIndex;
+                move.src.block = source;
+                move.src.node = a.node;
+                move.dst.memory = block->memory;
+                move.dst.offset = offset;
+                move.dst.size = a.size;
+                move.dst.mapped = block->mapped ? static_cast<char*>(block->mapped) + offset : nullptr;
+                move.dst.memoryTypeIndex = pool.memoryTypeIndex;
+                move.dst.block = block.get();
+                move.dst.node = node;
+                move.userData = a.userData;
+                moves.push_back(move);
+                break;
+            }
+        }
+    }
+    return moves;
+}
+
+void GpuAllocator::endDefragmentation(std::vector<DefragmentationMove> &moves) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &move : moves) {
+        freeLocked(move.cancel ? move.dst : move.src);
+    }
+    moves.clear();
+}
+
+GpuAllocatorStats GpuAllocator::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    GpuAllocatorStats s;
+    for (auto &pool : pools) {
+        for (auto &block : pool.blocks) {
+            const TlsfAllocator &tlsf = *block->tlsf;
+            s.bytesReserved += tlsf.size();
+            s.bytesUsed += tlsf.usedBytes();
+            s.bytesFree += tlsf.freeBytes();
+            s.bytesWasted += tlsf.paddingBytes() + (tlsf.freeBytes() - tlsf.largestFreeRange());
+            s.allocationCount += tlsf.allocationCount();
+            ++s.blockCount;
+        }
+    }
+    s.bytesReserved += dedicatedBytes;
+    s.bytesUsed += dedicatedBytes;
+    s.allocationCount += dedicatedCount;
+    s.dedicatedAllocationCount = dedicatedCount;
+    return s;
+}
+
+std::vector<GpuHeapBudget> GpuAllocator::heapBudgets() const {
+    std::vector<GpuHeapBudget> heaps(memProps.memoryHeapCount);
+    for (uint32_t i = 0; i < memProps.memoryHeapCount; ++i) {
+        heaps[i].budget = memProps.memoryHeaps[i].size;
+        heaps[i].deviceLocal = (memProps.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+    }
+
+    if (budgetSupported) {
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budget{};
+        budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+        VkPhysicalDeviceMemoryProperties2 props2{};
+        props2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        props2.pNext = &budget;
+        vkGetPhysicalDeviceMemoryProperties2(physicalDevice, &props2);
+        for (uint32_t i = 0; i < memProps.memoryHeapCount; ++i) {
+            heaps[i].budget = budget.heapBudget[i];
+            heaps[i].usage = budget.heapUsage[i];
+        }
+        return heaps;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &pool : pools) {
+        uint32_t heap = memProps.memoryTypes[pool.memoryTypeIndex].heapIndex;
+        for (auto &block : pool.blocks) {
+            heaps[heap].usage += block->tlsf->size();
+        }
+    }
+    return heaps;
+}
+
+// ---------------------------------------------------------------------------------------
+// LinearFrameArena
+
+void LinearFrameArena::init(GpuAllocator &alloc, VkDeviceSize bytesPerFrame, uint32_t frameCount, VkBufferUsageFlags usage,
+                            VkDeviceSize tailPadding) {
+    allocator = &alloc;
+    perFrame = bytesPerFrame;
+
+    VkBufferCreateInfo bufInfo{};
+    bufInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufInfo.size = bytesPerFrame * frameCount + tailPadding;
+    bufInfo.usage = usage;
+    bufInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    buffer = allocator->createBuffer(bufInfo, MemoryUsage::CpuToGpu, allocation);
+    frameBase = head = 0;
+}
+
+void LinearFrameArena::destroy() {
+    if (allocator) allocator->destroyBuffer(buffer, allocation);
+    buffer = VK_NULL_HANDLE;
+    allocator = nullptr;
+}
+
+void LinearFrameArena::reset(uint32_t frameIndex) {
+    frameBase = head = perFrame * frameIndex;
+}
+
+LinearFrameArena::Slice LinearFrameArena::allocate(VkDeviceSize size, VkDeviceSize alignment) {
+    VkDeviceSize offset = alignUp(head, std::max<VkDeviceSize>(alignment, 1));
+    if (offset + size > frameBase + perFrame) return {};
+    head = offset + size;
+    return {buffer, offset, static_cast<char*>(allocation.mapped) + offset};
+}
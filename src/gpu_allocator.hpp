@@ -0,0 +1,240 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Two-level segregated fit allocator over a single [0, size) range. It only does the
+// bookkeeping; GpuAllocator maps the returned offsets onto VkDeviceMemory blocks.
+// Allocation and free are O(1): free ranges are bucketed by size class and the buckets
+// are found with two bitmap scans.
+class TlsfAllocator {
+public:
+    static constexpr uint32_t INVALID_NODE = UINT32_MAX;
+
+    explicit TlsfAllocator(VkDeviceSize size);
+
+    // Returns the node backing the allocation (INVALID_NODE on failure) and its aligned offset
+    uint32_t allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &outOffset, void *userData = nullptr);
+    void free(uint32_t node);
+
+    VkDeviceSize size() const { return totalSize; }
+    VkDeviceSize freeBytes() const { return totalSize - reservedBytes; }
+    VkDeviceSize usedBytes() const { return requestedBytes; }
+    // Bytes held by live allocations beyond what they asked for (alignment and tail padding)
+    VkDeviceSize paddingBytes() const { return reservedBytes - requestedBytes; }
+    VkDeviceSize largestFreeRange() const;
+    uint32_t allocationCount() const { return liveAllocations; }
+    bool empty() const { return liveAllocations == 0; }
+
+    // Visits every live allocation in address order as (node, offset, size, alignment, userData)
+    template <typename Fn>
+    void forEachAllocation(Fn &&fn) const {
+        for (uint32_t n = firstPhysical; n != INVALID_NODE; n = nodes[n].nextPhysical) {
+            const Node &node = nodes[n];
+            if (!node.free) fn(n, node.alignedOffset, node.requested, node.alignment, node.userData);
+        }
+    }
+
+private:
+    static constexpr uint32_t SL_LOG2 = 5;
+    static constexpr uint32_t SL_COUNT = 1u << SL_LOG2;
+    static constexpr uint32_t SMALL_LOG2 = 8;
+    static constexpr VkDeviceSize SMALL_SIZE = VkDeviceSize(1) << SMALL_LOG2;
+    static constexpr uint32_t FL_COUNT = 64 - SMALL_LOG2 + 1;
+    // Leftovers smaller than this stay inside the allocation instead of becoming free nodes
+    static constexpr VkDeviceSize MIN_SPLIT = 64;
+
+    struct Node {
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        VkDeviceSize alignedOffset = 0;
+        VkDeviceSize requested = 0;
+        VkDeviceSize alignment = 1;
+        void *userData = nullptr;
+        uint32_t prevPhysical = INVALID_NODE;
+        uint32_t nextPhysical = INVALID_NODE;
+        uint32_t prevFree = INVALID_NODE;
+        uint32_t nextFree = INVALID_NODE;
+        bool free = true;
+    };
+
+    static void mapping(VkDeviceSize size, uint32_t &fl, uint32_t &sl);
+    uint32_t newNode();
+    void releaseNode(uint32_t n);
+    void insertFree(uint32_t n);
+    void removeFree(uint32_t n);
+    uint32_t findFree(VkDeviceSize size) const;
+
+    std::vector<Node> nodes;
+    std::vector<uint32_t> unusedNodes;
+    uint32_t heads[FL_COUNT][SL_COUNT];
+    uint64_t flBitmap = 0;
+    uint32_t slBitmap[FL_COUNT] = {};
+    uint32_t firstPhysical = INVALID_NODE;
+    VkDeviceSize totalSize = 0;
+    VkDeviceSize reservedBytes = 0;
+    VkDeviceSize requestedBytes = 0;
+    uint32_t liveAllocations = 0;
+};
+
+enum class MemoryUsage {
+    GpuOnly,   // device-local, never mapped
+    CpuToGpu,  // host-visible, persistently mapped upload memory
+    GpuToCpu,  // host-visible and preferably cached, for readback
+};
+
+struct GpuAllocation {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    // Persistent mapping of offset, or nullptr for non-host-visible memory
+    void *mapped = nullptr;
+    uint32_t memoryTypeIndex = UINT32_MAX;
+
+    // Owning block (nullptr for dedicated allocations) and TLSF node inside it
+    void *block = nullptr;
+    uint32_t node = TlsfAllocator::INVALID_NODE;
+
+    explicit operator bool() const { return memory != VK_NULL_HANDLE; }
+};
+
+// Per memory heap. With VK_EXT_memory_budget these are the driver's figures for the whole
+// process; without it budget is the heap size and usage only counts this allocator's blocks.
+struct GpuHeapBudget {
+    VkDeviceSize budget = 0;
+    VkDeviceSize usage = 0;
+    bool deviceLocal = false;
+};
+
+struct GpuAllocatorStats {
+    VkDeviceSize bytesReserved = 0;     // device memory held in blocks and dedicated allocations
+    VkDeviceSize bytesUsed = 0;         // bytes requested by live allocations
+    VkDeviceSize bytesWasted = 0;       // alignment/tail padding plus free space outside each block's largest hole
+    VkDeviceSize bytesFree = 0;         // unallocated bytes inside blocks
+    uint32_t blockCount = 0;
+    uint32_t allocationCount = 0;
+    uint32_t dedicatedAllocationCount = 0;
+};
+
+// A planned relocation produced by beginDefragmentation(). The caller recreates or rebinds
+// the resource identified by userData at dst, records the copy and replaces its handle; set
+// cancel to keep the resource at src instead.
+struct DefragmentationMove {
+    GpuAllocation src;
+    GpuAllocation dst;
+    void *userData = nullptr;
+    bool cancel = false;
+};
+
+// Sub-allocates buffers and images out of large per-memory-type blocks instead of
+// calling vkAllocateMemory per resource. Buffers (linear) and optimal-tiling images are kept
+// in separate pools when bufferImageGranularity requires it, so neighbours never alias a page.
+class GpuAllocator {
+public:
+    static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+    // memoryBudget: VK_EXT_memory_budget was enabled on the device
+    void init(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize preferredBlockSize = DEFAULT_BLOCK_SIZE,
+              bool memoryBudget = false);
+    void destroy();
+
+    // userData is reported back by defragmentation to identify the owning resource
+    GpuAllocation allocate(const VkMemoryRequirements &reqs, MemoryUsage usage, bool linear,
+                           bool dedicated = false, void *userData = nullptr);
+    void free(GpuAllocation &allocation);
+
+    // Create a resource, allocate memory for it and bind it
+    VkBuffer createBuffer(const VkBufferCreateInfo &info, MemoryUsage usage, GpuAllocation &outAllocation, void *userData = nullptr);
+    VkImage createImage(const VkImageCreateInfo &info, MemoryUsage usage, GpuAllocation &outAllocation, void *userData = nullptr);
+    void destroyBuffer(VkBuffer buffer, GpuAllocation &allocation);
+    void destroyImage(VkImage image, GpuAllocation &allocation);
+
+    // Needed only for memory types without HOST_COHERENT
+    void flush(const GpuAllocation &allocation, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+    void invalidate(const GpuAllocation &allocation, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+
+    // Plans up to maxMoves relocations out of the emptiest block of each pool. dst memory is
+    // allocated but src stays valid until endDefragmentation(), which must only be called once
+    // the GPU copies recorded by the caller have completed.
+    std::vector<DefragmentationMove> beginDefragmentation(uint32_t maxMoves);
+    void endDefragmentation(std::vector<DefragmentationMove> &moves);
+
+    GpuAllocatorStats stats() const;
+    std::vector<GpuHeapBudget> heapBudgets() const;
+    const VkPhysicalDeviceMemoryProperties &memoryProperties() const { return memProps; }
+    VkDevice getDevice() const { return device; }
+
+private:
+    struct Block {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        void *mapped = nullptr;
+        uint32_t pool = 0;
+        std::unique_ptr<TlsfAllocator> tlsf;
+    };
+
+    struct Pool {
+        uint32_t memoryTypeIndex = 0;
+        VkDeviceSize blockSize = 0;
+        std::vector<std::unique_ptr<Block>> blocks;
+    };
+
+    uint32_t poolIndex(uint32_t memoryTypeIndex, bool linear) const;
+    std::vector<uint32_t> candidateMemoryTypes(uint32_t typeBits, MemoryUsage usage) const;
+    bool allocateFromPool(uint32_t pool, const VkMemoryRequirements &reqs, void *userData, GpuAllocation &out);
+    // resource names the buffer or image the memory is dedicated to, or is null
+    GpuAllocation allocateFor(const VkMemoryRequirements &reqs, MemoryUsage usage, bool linear, bool dedicated,
+                              void *userData, const VkMemoryDedicatedAllocateInfo *resource);
+    bool allocateDedicated(uint32_t memoryTypeIndex, VkDeviceSize size, const VkMemoryDedicatedAllocateInfo *resource,
+                           GpuAllocation &out);
+    void freeLocked(GpuAllocation &allocation);
+    void mappedRange(const GpuAllocation &allocation, VkDeviceSize offset, VkDeviceSize size, VkMappedMemoryRange &range) const;
+
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    VkDevice device = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties memProps{};
+    bool budgetSupported = false;
+    VkDeviceSize bufferImageGranularity = 1;
+    VkDeviceSize nonCoherentAtomSize = 1;
+    bool separateLinearPools = false;
+    std::vector<Pool> pools;
+    uint32_t dedicatedCount = 0;
+    VkDeviceSize dedicatedBytes = 0;
+    mutable std::mutex mutex;
+};
+
+// Bump allocator over one persistently mapped buffer, split into a region per frame in
+// flight. reset() rewinds a frame's region once its fence has signalled; nothing is freed
+// individually. tailPadding bytes after the last region let a fixed-size descriptor range
+// start at any offset.
+class LinearFrameArena {
+public:
+    struct Slice {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        void *mapped = nullptr;
+    };
+
+    void init(GpuAllocator &allocator, VkDeviceSize bytesPerFrame, uint32_t frameCount, VkBufferUsageFlags usage,
+              VkDeviceSize tailPadding = 0);
+    void destroy();
+
+    void reset(uint32_t frameIndex);
+    // Returns an empty slice when the frame's region is exhausted
+    Slice allocate(VkDeviceSize size, VkDeviceSize alignment);
+
+    VkBuffer getBuffer() const { return buffer; }
+    VkDeviceSize bytesUsed() const { return head - frameBase; }
+    VkDeviceSize capacityPerFrame() const { return perFrame; }
+
+private:
+    GpuAllocator *allocator = nullptr;
+    VkBuffer buffer = VK_NULL_HANDLE;
+    GpuAllocation allocation;
+    VkDeviceSize perFrame = 0;
+    VkDeviceSize frameBase = 0;
+    VkDeviceSize head = 0;
+};
@@ -0,0 +1,414 @@
+#include "gpu_culling.hpp"
+
+#include "vk_dispatch.hpp"
+#include "vk_utils.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+// Must match the push_constant block in shaders/cull.comp
+struct CullPushConstants {
+    float viewCenter[2];
+    float zoom;
+    uint32_t objectCount;
+    float pyramidSize[2];
+    uint32_t pyramidLevels;
+    uint32_t objects;
+    uint32_t commands;
+    uint32_t drawCount;
+    uint32_t pyramid;
+    uint32_t pad;
+};
+
+// Must match the push_constant block in shaders/hiz.comp
+struct HiZPushConstants {
+    int32_t srcSize[2];
+    int32_t dstSize[2];
+    uint32_t src;
+    uint32_t dst;
+    uint32_t fromDepth;
+};
+
+// Must match the push_constant block in shaders/triangle_indirect.vert
+struct DrawPushConstants {
+    float viewCenter[2];
+    float zoom;
+    uint32_t objects;
+};
+static_assert(sizeof(DrawPushConstants) == GpuCulling::DRAW_PUSH_CONSTANTS_SIZE, "push constant size mismatch");
+
+constexpr uint32_t CULL_GROUP_SIZE = 64;
+constexpr uint32_t HIZ_GROUP_SIZE = 8;
+
+uint32_t groups(uint32_t n, uint32_t size) {
+    return (n + size - 1) / size;
+}
+
+// Largest power of two not above v, so every pyramid level halves the one before it
+uint32_t previousPow2(uint32_t v) {
+    uint32_t r = 1;
+    while (r * 2 <= v) r *= 2;
+    return r;
+}
+
+VkBuffer createBuffer(GpuAllocator &allocator, VkDeviceSize size, VkBufferUsageFlags usage, GpuAllocation &allocation) {
+    VkBufferCreateInfo info{};
+    info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    info.size = size;
+    info.usage = usage;
+    info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    return allocator.createBuffer(info, MemoryUsage::GpuOnly, allocation);
+}
+
+} // namespace
+
+void GpuCulling::init(VkPhysicalDevice physicalDevice, VkDevice dev, GpuAllocator &gpuAllocator,
+                      PipelineCache &pipelineCache, LayoutCache &layouts, BindlessTable &table, DeletionQueue &deletion) {
+    device = dev;
+    allocator = &gpuAllocator;
+    bindless = &table;
+    deletionQueue = &deletion;
+
+    VkFormatProperties formatProps{};
+    vkGetPhysicalDeviceFormatProperties(physicalDevice, DEPTH_FORMAT, &formatProps);
+    VkFormatFeatureFlags needed = VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+    if ((formatProps.optimalTilingFeatures & needed) != needed) {
+        throw std::runtime_error("Depth format for GPU culling can't be sampled!");
+    }
+
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &props);
+    maxDrawCount = props.limits.maxDrawIndirectCount;
+
+    VkPushConstantRange pushRange{};
+    pushRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushRange.offset = 0;
+    pushRange.size = static_cast<uint32_t>(std::max(sizeof(CullPushConstants), sizeof(HiZPushConstants)));
+
+    VkDescriptorSetLayout setLayout = bindless->layout();
+    VkPipelineLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &setLayout;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &pushRange;
+    computeLayout = layouts.pipelineLayout(layoutInfo);
+
+    auto createPipeline = [&](const char *shader) {
+        VkShaderModule module = loadShaderModule(device, shader);
+        VkComputePipelineCreateInfo info{};
+        info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        info.stage.module = module;
+        info.stage.pName = "main";
+        info.layout = computeLayout;
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        try {
+            pipeline = pipelineCache.createComputePipeline(info);
+        } catch (...) {
+            vkDestroyShaderModule(device, module, nullptr);
+            throw;
+        }
+        vkDestroyShaderModule(device, module, nullptr);
+        return pipeline;
+    };
+    cullPipeline = createPipeline("cull.comp.spv");
+    hizPipeline = createPipeline("hiz.comp.spv");
+}
+
+void GpuCulling::destroy() {
+    destroyPyramid(pyramid);
+    destroyObjects();
+    if (indexBuffer != VK_NULL_HANDLE) allocator->destroyBuffer(indexBuffer, indexAllocation);
+    indexBuffer = VK_NULL_HANDLE;
+    if (depthHandle != BINDLESS_INVALID) bindless->release(BindlessType::SampledImage, depthHandle);
+    depthHandle = BINDLESS_INVALID;
+
+    if (hizPipeline != VK_NULL_HANDLE) vkDestroyPipeline(device, hizPipeline, nullptr);
+    if (cullPipeline != VK_NULL_HANDLE) vkDestroyPipeline(device, cullPipeline, nullptr);
+    hizPipeline = VK_NULL_HANDLE;
+    cullPipeline = VK_NULL_HANDLE;
+    computeLayout = VK_NULL_HANDLE;
+}
+
+void GpuCulling::destroyObjects() {
+    bindless->release(BindlessType::StorageBuffer, objectHandle);
+    bindless->release(BindlessType::StorageBuffer, commandHandle);
+    bindless->release(BindlessType::StorageBuffer, countHandle);
+    objectHandle = commandHandle = countHandle = BINDLESS_INVALID;
+    if (objectBuffer != VK_NULL_HANDLE) allocator->destroyBuffer(objectBuffer, objectAllocation);
+    if (commandBuffer != VK_NULL_HANDLE) allocator->destroyBuffer(commandBuffer, commandAllocation);
+    if (countBuffer != VK_NULL_HANDLE) allocator->destroyBuffer(countBuffer, countAllocation);
+    objectBuffer = commandBuffer = countBuffer = VK_NULL_HANDLE;
+    count = 0;
+}
+
+void GpuCulling::setObjects(UploadService &uploads, const std::vector<GpuObject> &objects) {
+    destroyObjects();
+    count = static_cast<uint32_t>(objects.size());
+    // Zero-sized buffers are invalid; an empty scene keeps one unused slot
+    VkDeviceSize slots = std::max(count, 1u);
+
+    objectBuffer = createBuffer(*allocator, slots * sizeof(GpuObject),
+                                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                objectAllocation);
+    commandBuffer = createBuffer(*allocator, slots * sizeof(VkDrawIndexedIndirectCommand),
+                                 VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                                 commandAllocation);
+    countBuffer = createBuffer(*allocator, sizeof(uint32_t),
+                               VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                                   VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                               countAllocation);
+    objectHandle = bindless->addStorageBuffer(objectBuffer);
+    commandHandle = bindless->addStorageBuffer(commandBuffer);
+    countHandle = bindless->addStorageBuffer(countBuffer);
+    if (objectHandle == BINDLESS_INVALID || commandHandle == BINDLESS_INVALID || countHandle == BINDLESS_INVALID) {
+        throw std::runtime_error("Bindless table is out of storage buffer slots!");
+    }
+
+    UploadToken token = 0;
+    if (indexBuffer == VK_NULL_HANDLE) {
+        // Every object is the same triangle; the vertex shader generates its corners
+        const uint32_t indices[3] = {0, 1, 2};
+        indexBuffer = createBuffer(*allocator, sizeof(indices),
+                                   VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, indexAllocation);
+        token = uploads.uploadBuffer(indexBuffer, 0, indices, sizeof(indices), VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                                     VK_ACCESS_INDEX_READ_BIT);
+    }
+    if (count > 0) {
+        token = uploads.uploadBuffer(objectBuffer, 0, objects.data(), count * sizeof(GpuObject),
+                                     VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                                     VK_ACCESS_SHADER_READ_BIT);
+    }
+    if (token != 0) uploads.wait(token);
+}
+
+void GpuCulling::setView(float centerX, float centerY, float zoom) {
+    viewCenter[0] = centerX;
+    viewCenter[1] = centerY;
+    viewZoom = zoom;
+}
+
+void GpuCulling::createPyramid(VkExtent2D extent) {
+    if (pyramid.image != VK_NULL_HANDLE) {
+        bindless->release(BindlessType::SampledImage, pyramid.sampled);
+        for (BindlessHandle h : pyramid.levelHandles) bindless->release(BindlessType::StorageImage, h);
+        for (VkImageView v : pyramid.levelViews) deletionQueue->destroyImageView(v);
+        deletionQueue->destroyImageView(pyramid.view);
+        deletionQueue->destroyImage(pyramid.image, pyramid.allocation);
+        pyramid = Pyramid{};
+    }
+
+    // Level 0 is at most half the depth resolution; the cull shader picks the level at which
+    // an object's bounds cover no more than 2x2 texels
+    pyramid.extent = {std::max(previousPow2(extent.width) / 2, 1u), std::max(previousPow2(extent.height) / 2, 1u)};
+    pyramid.levels = 1;
+    while ((std::max(pyramid.extent.width, pyramid.extent.height) >> pyramid.levels) > 0) ++pyramid.levels;
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = VK_FORMAT_R32_SFLOAT;
+    imageInfo.extent = {pyramid.extent.width, pyramid.extent.height, 1};
+    imageInfo.mipLevels = pyramid.levels;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    pyramid.image = allocator->createImage(imageInfo, MemoryUsage::GpuOnly, pyramid.allocation);
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = pyramid.image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = VK_FORMAT_R32_SFLOAT;
+    viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, pyramid.levels, 0, 1};
+    if (vkCreateImageView(device, &viewInfo, nullptr, &pyramid.view) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create Hi-Z pyramid view!");
+    }
+    // The cull pass reads every level through one sampled view; the build writes one level at a time
+    pyramid.sampled = bindless->addSampledImage(pyramid.view);
+    pyramid.levelViews.resize(pyramid.levels);
+    pyramid.levelHandles.resize(pyramid.levels);
+    for (uint32_t level = 0; level < pyramid.levels; ++level) {
+        viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1};
+        if (vkCreateImageView(device, &viewInfo, nullptr, &pyramid.levelViews[level]) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create Hi-Z pyramid view!");
+        }
+        pyramid.levelHandles[level] = bindless->addStorageImage(pyramid.levelViews[level]);
+    }
+    if (pyramid.sampled == BINDLESS_INVALID ||
+        std::find(pyramid.levelHandles.begin(), pyramid.levelHandles.end(), BINDLESS_INVALID) != pyramid.levelHandles.end()) {
+        throw std::runtime_error("Bindless table is out of image slots!");
+    }
+    pyramidNeedsInit = true;
+}
+
+void GpuCulling::destroyPyramid(Pyramid &p) {
+    for (VkImageView v : p.levelViews) vkDestroyImageView(device, v, nullptr);
+    if (p.view != VK_NULL_HANDLE) vkDestroyImageView(device, p.view, nullptr);
+    if (p.image != VK_NULL_HANDLE) allocator->destroyImage(p.image, p.allocation);
+    p = Pyramid{};
+}
+
+void GpuCulling::addCullPasses(RenderGraph &graph, VkExtent2D extent) {
+    if (pyramid.image == VK_NULL_HANDLE || extent.width != depthExtent.width || extent.height != depthExtent.height) {
+        createPyramid(extent);
+    }
+    depthExtent = extent;
+
+    // The previous frame's indirect draw may still be reading both buffers
+    RGState indirectRead{VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_NONE};
+    commandsRes = graph.importBuffer("draw commands", commandBuffer, commandAllocation.size, indirectRead);
+    countRes = graph.importBuffer("draw count", countBuffer, countAllocation.size, indirectRead);
+    // Left by the previous frame's hiz pass (or recordPendingInit())
+    RGState built{VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT};
+    pyramidRes = graph.importImage("hi-z pyramid", pyramid.image, pyramid.view, VK_FORMAT_R32_SFLOAT, pyramid.extent,
+                                   built, built);
+
+    graph.addPass("clear draw count",
+        [&](RenderGraph::PassBuilder &pass) {
+            pass.write(countRes, RGUsage::TransferDst);
+        },
+        [this](RGPassContext &ctx) {
+            vkd.cmdFillBuffer(ctx.cmd, countBuffer, 0, sizeof(uint32_t), 0);
+        });
+
+    graph.addPass("cull",
+        [&](RenderGraph::PassBuilder &pass) {
+            pass.read(pyramidRes, RGUsage::SampledCompute);
+            pass.write(countRes, RGUsage::StorageReadWriteCompute);
+            pass.write(commandsRes, RGUsage::StorageWriteCompute);
+        },
+        [this](RGPassContext &ctx) {
+            if (count == 0) return;
+            CullPushConstants push{};
+            push.viewCenter[0] = viewCenter[0];
+            push.viewCenter[1] = viewCenter[1];
+            push.zoom = viewZoom;
+            push.objectCount = std::min(count, maxDrawCount);
+            push.pyramidSize[0] = static_cast<float>(pyramid.extent.width);
+            push.pyramidSize[1] = static_cast<float>(pyramid.extent.height);
+            push.pyramidLevels = pyramid.levels;
+            push.objects = objectHandle;
+            push.commands = commandHandle;
+            push.drawCount = countHandle;
+            push.pyramid = pyramid.sampled;
+            vkd.cmdBindPipeline(ctx.cmd, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline);
+            bindless->bind(ctx.cmd, VK_PIPELINE_BIND_POINT_COMPUTE, computeLayout);
+            vkd.cmdPushConstants(ctx.cmd, computeLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), &push);
+            vkd.cmdDispatch(ctx.cmd, groups(push.objectCount, CULL_GROUP_SIZE), 1, 1);
+        });
+}
+
+void GpuCulling::readDrawCommands(RenderGraph::PassBuilder &pass) const {
+    pass.read(commandsRes, RGUsage::IndirectRead);
+    pass.read(countRes, RGUsage::IndirectRead);
+}
+
+void GpuCulling::recordDraw(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout) const {
+    if (count == 0) return;
+    DrawPushConstants push{};
+    push.viewCenter[0] = viewCenter[0];
+    push.viewCenter[1] = viewCenter[1];
+    push.zoom = viewZoom;
+    push.objects = objectHandle;
+    vkd.cmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(push), &push);
+    vkd.cmdBindIndexBuffer(cmd, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+    vkd.cmdDrawIndexedIndirectCount(cmd, commandBuffer, 0, countBuffer, 0, std::min(count, maxDrawCount),
+                                  sizeof(VkDrawIndexedIndirectCommand));
+}
+
+void GpuCulling::addHiZPass(RenderGraph &graph, RGHandle depth) {
+    depthRes = depth;
+    graph.addPass("hiz",
+        [&](RenderGraph::PassBuilder &pass) {
+            pass.read(depth, RGUsage::SampledCompute);
+            pass.write(pyramidRes, RGUsage::StorageReadWriteCompute);
+        },
+        [this](RGPassContext &ctx) {
+            vkd.cmdBindPipeline(ctx.cmd, VK_PIPELINE_BIND_POINT_COMPUTE, hizPipeline);
+            bindless->bind(ctx.cmd, VK_PIPELINE_BIND_POINT_COMPUTE, computeLayout);
+
+            // Each level reads the one written by the previous dispatch
+            VkMemoryBarrier2 levelBarrier{};
+            levelBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+            levelBarrier.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+            levelBarrier.srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+            levelBarrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+            levelBarrier.dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT;
+            VkDependencyInfo dep{};
+            dep.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+            dep.memoryBarrierCount = 1;
+            dep.pMemoryBarriers = &levelBarrier;
+
+            HiZPushConstants push{};
+            push.srcSize[0] = static_cast<int32_t>(depthExtent.width);
+            push.srcSize[1] = static_cast<int32_t>(depthExtent.height);
+            push.src = depthHandle;
+            push.fromDepth = 1;
+            for (uint32_t level = 0; level < pyramid.levels; ++level) {
+                push.dstSize[0] = static_cast<int32_t>(std::max(pyramid.extent.width >> level, 1u));
+                push.dstSize[1] = static_cast<int32_t>(std::max(pyramid.extent.height >> level, 1u));
+                push.dst = pyramid.levelHandles[level];
+                if (level > 0) vkd.cmdPipelineBarrier2(ctx.cmd, &dep);
+                vkd.cmdPushConstants(ctx.cmd, computeLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), &push);
+                vkd.cmdDispatch(ctx.cmd, groups(static_cast<uint32_t>(push.dstSize[0]), HIZ_GROUP_SIZE),
+                              groups(static_cast<uint32_t>(push.dstSize[1]), HIZ_GROUP_SIZE), 1);
+
+                push.srcSize[0] = push.dstSize[0];
+                push.srcSize[1] = push.dstSize[1];
+                push.src = push.dst;
+                push.fromDepth = 0;
+            }
+        });
+}
+
+void GpuCulling::graphCompiled(const RenderGraph &graph) {
+    // A retired graph may still be reading the old view; the slot is recycled frames later
+    if (depthHandle != BINDLESS_INVALID) bindless->release(BindlessType::SampledImage, depthHandle);
+    depthHandle = bindless->addSampledImage(graph.view(depthRes));
+    if (depthHandle == BINDLESS_INVALID) {
+        throw std::runtime_error("Bindless table is out of image slots!");
+    }
+}
+
+void GpuCulling::recordPendingInit(VkCommandBuffer cmd) {
+    if (!pyramidNeedsInit) return;
+    pyramidNeedsInit = false;
+
+    VkImageMemoryBarrier2 barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+    barrier.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+    barrier.srcAccessMask = VK_ACCESS_2_NONE;
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_CLEAR_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = pyramid.image;
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_REMAINING_MIP_LEVELS, 0, 1};
+    VkDependencyInfo dep{};
+    dep.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    dep.imageMemoryBarrierCount = 1;
+    dep.pImageMemoryBarriers = &barrier;
+    vkd.cmdPipelineBarrier2(cmd, &dep);
+
+    // Far plane: nothing is behind it, so nothing is culled by occlusion
+    VkClearColorValue far{{1.0f, 0.0f, 0.0f, 0.0f}};
+    vkd.cmdClearColorImage(cmd, pyramid.image, VK_IMAGE_LAYOUT_GENERAL, &far, 1, &barrier.subresourceRange);
+
+    // Hand over in the state the graph imports the pyramid in
+    barrier.srcStageMask = VK_PIPELINE_STAGE_2_CLEAR_BIT;
+    barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    vkd.cmdPipelineBarrier2(cmd, &dep);
+}
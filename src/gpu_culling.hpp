@@ -0,0 +1,128 @@
+#pragma once
+
+#include "bindless.hpp"
+#include "deletion_queue.hpp"
+#include "gpu_allocator.hpp"
+#include "layout_cache.hpp"
+#include "pipeline_cache.hpp"
+#include "render_graph.hpp"
+#include "upload_service.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+// One drawable, as read by shaders/cull.comp and shaders/triangle_indirect.vert (std430).
+// Positions are in world units; the camera maps them to NDC as (offset - center) * zoom.
+struct GpuObject {
+    float offset[2];
+    float scale;
+    float hue;
+    // Depth the object is rasterized at, and the value tested against the Hi-Z pyramid
+    float depth;
+    // Bounding circle around offset
+    float radius;
+    float pad[2];
+};
+
+// GPU-driven path for the scene: every frame a compute pass tests each object's bounding
+// circle against the view and against a Hi-Z (max depth) pyramid built from the previous
+// frame's depth buffer, and appends a VkDrawIndexedIndirectCommand for each survivor. The
+// scene pass then issues a single vkCmdDrawIndexedIndirectCount, so the CPU cost of a frame
+// no longer depends on the object count.
+//
+// The passes are added to the caller's render graph, which synchronizes them:
+//   clear draw count -> cull -> [caller's scene pass, draws via recordDraw()] -> hiz
+// Needs BindlessTable (all buffers and images are passed to shaders as bindless handles)
+// and DeviceFeatures::indirectDraws.
+class GpuCulling {
+public:
+    static constexpr VkFormat DEPTH_FORMAT = VK_FORMAT_D32_SFLOAT;
+    // Vertex push constants pushed by recordDraw(); the pipeline layout's range must cover them
+    static constexpr uint32_t DRAW_PUSH_CONSTANTS_SIZE = 16;
+
+    // Throws if DEPTH_FORMAT can't be both rendered to and sampled
+    void init(VkPhysicalDevice physicalDevice, VkDevice device, GpuAllocator &allocator,
+              PipelineCache &pipelineCache, LayoutCache &layouts, BindlessTable &bindless, DeletionQueue &deletionQueue);
+    // The GPU must be idle
+    void destroy();
+
+    // Replaces the object list and blocks until the upload has completed. The GPU must no
+    // longer be using the previous list.
+    void setObjects(UploadService &uploads, const std::vector<GpuObject> &objects);
+    uint32_t objectCount() const { return count; }
+
+    void setView(float centerX, float centerY, float zoom);
+
+    // Adds the "clear draw count" and "cull" passes. The pyramid follows extent and is
+    // recreated (the old one handed to the DeletionQueue) when it changes.
+    void addCullPasses(RenderGraph &graph, VkExtent2D extent);
+    // Declares the scene pass's reads of the draw commands and count
+    void readDrawCommands(RenderGraph::PassBuilder &pass) const;
+    // Binds the index buffer and issues the indirect draw; the caller binds the pipeline,
+    // the bindless set and dynamic state
+    void recordDraw(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout) const;
+    // Adds the "hiz" pass, which reduces depth (DEPTH_FORMAT, extent as above) into the pyramid
+    void addHiZPass(RenderGraph &graph, RGHandle depth);
+    // Call after graph.compile(), once the transient depth image exists
+    void graphCompiled(const RenderGraph &graph);
+
+    // Before executing the graph: clears a newly created pyramid to the far plane, so the
+    // first frame after a resize culls against nothing
+    void recordPendingInit(VkCommandBuffer cmd);
+
+private:
+    struct Pyramid {
+        VkImage image = VK_NULL_HANDLE;
+        GpuAllocation allocation;
+        VkImageView view = VK_NULL_HANDLE;
+        std::vector<VkImageView> levelViews;
+        BindlessHandle sampled = BINDLESS_INVALID;
+        std::vector<BindlessHandle> levelHandles;
+        VkExtent2D extent{};
+        uint32_t levels = 0;
+    };
+
+    void createPyramid(VkExtent2D depthExtent);
+    void destroyPyramid(Pyramid &p);
+    void destroyObjects();
+
+    VkDevice device = VK_NULL_HANDLE;
+    GpuAllocator *allocator = nullptr;
+    BindlessTable *bindless = nullptr;
+    DeletionQueue *deletionQueue = nullptr;
+    uint32_t maxDrawCount = 0;
+
+    // Owned by the layout cache
+    VkPipelineLayout computeLayout = VK_NULL_HANDLE;
+    VkPipeline cullPipeline = VK_NULL_HANDLE;
+    VkPipeline hizPipeline = VK_NULL_HANDLE;
+
+    VkBuffer indexBuffer = VK_NULL_HANDLE;
+    GpuAllocation indexAllocation;
+    VkBuffer objectBuffer = VK_NULL_HANDLE;
+    GpuAllocation objectAllocation;
+    VkBuffer commandBuffer = VK_NULL_HANDLE;
+    GpuAllocation commandAllocation;
+    VkBuffer countBuffer = VK_NULL_HANDLE;
+    GpuAllocation countAllocation;
+    BindlessHandle objectHandle = BINDLESS_INVALID;
+    BindlessHandle commandHandle = BINDLESS_INVALID;
+    BindlessHandle countHandle = BINDLESS_INVALID;
+    uint32_t count = 0;
+
+    Pyramid pyramid;
+    bool pyramidNeedsInit = false;
+
+    float viewCenter[2] = {0.0f, 0.0f};
+    float viewZoom = 1.0f;
+
+    // Handles into the graph the passes were last added to
+    RGHandle commandsRes = RG_INVALID;
+    RGHandle countRes = RG_INVALID;
+    RGHandle pyramidRes = RG_INVALID;
+    RGHandle depthRes = RG_INVALID;
+    VkExtent2D depthExtent{};
+    BindlessHandle depthHandle = BINDLESS_INVALID;
+};
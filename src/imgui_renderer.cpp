@@ -0,0 +1,435 @@
+#include "imgui_renderer.hpp"
+
+#include "vk_dispatch.hpp"
+#include "vk_utils.hpp"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+// Must match the push_constant blocks in shaders/imgui.vert and shaders/imgui.frag
+struct ImGuiPushConstants {
+    float scale[2];
+    float translate[2];
+    uint32_t textureIndex;
+    uint32_t samplerIndex;
+    // ImGui colors are sRGB; an sRGB target would encode them a second time
+    uint32_t linearizeColors;
+    uint32_t pad;
+};
+
+constexpr VkDeviceSize INITIAL_REGION_SIZE = 256 * 1024;
+
+bool isSrgb(VkFormat format) {
+    return format == VK_FORMAT_B8G8R8A8_SRGB || format == VK_FORMAT_R8G8B8A8_SRGB ||
+           format == VK_FORMAT_A8B8G8R8_SRGB_PACK32;
+}
+
+VkDeviceSize alignUp(VkDeviceSize v, VkDeviceSize alignment) {
+    return (v + alignment - 1) / alignment * alignment;
+}
+
+BindlessHandle textureHandle(ImTextureID id) {
+    return static_cast<BindlessHandle>(reinterpret_cast<uintptr_t>(reinterpret_cast<void *>(id)) - 1);
+}
+
+} // namespace
+
+void ImGuiRenderer::init(VkPhysicalDevice physicalDevice, VkDevice dev, GpuAllocator &gpuAllocator,
+                         PipelineCache &cache, LayoutCache &layouts, BindlessTable &table, UploadService &uploads,
+                         DeletionQueue &deletion, VkFormat format, uint32_t frames) {
+    device = dev;
+    allocator = &gpuAllocator;
+    pipelineCache = &cache;
+    bindless = &table;
+    deletionQueue = &deletion;
+    frameCount = std::max(frames, 1u);
+
+    ImGuiIO &io = ImGui::GetIO();
+    io.BackendRendererName = "vuk";
+    // Draw lists over 64k vertices with 16-bit indices are split with a vertex offset
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasVtxOffset;
+
+    VkPushConstantRange pushRange{};
+    pushRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    pushRange.offset = 0;
+    pushRange.size = sizeof(ImGuiPushConstants);
+
+    VkDescriptorSetLayout setLayout = bindless->layout();
+    VkPipelineLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &setLayout;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &pushRange;
+    pipelineLayout = layouts.pipelineLayout(layoutInfo);
+    colorFormat = format;
+    pipeline = createPipeline(format);
+
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.maxLod = 1.0f;
+    sampler = layouts.sampler(samplerInfo);
+    samplerHandle = bindless->addSampler(sampler);
+
+    // The atlas is uploaded once and stays resident; ImGui's CPU copy is dropped afterwards
+    unsigned char *pixels = nullptr;
+    int width = 0;
+    int height = 0;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+    imageInfo.extent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    fontImage = allocator->createImage(imageInfo, MemoryUsage::GpuOnly, fontAllocation);
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = fontImage;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+    viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    if (vkCreateImageView(device, &viewInfo, nullptr, &fontView) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create ImGui font view!");
+    }
+
+    ImageUpload upload{};
+    upload.image = fontImage;
+    upload.extent = imageInfo.extent;
+    uploads.wait(uploads.uploadImage(upload, pixels, static_cast<VkDeviceSize>(width) * height * 4));
+
+    fontHandle = bindless->addSampledImage(fontView);
+    if (fontHandle == BINDLESS_INVALID || samplerHandle == BINDLESS_INVALID) {
+        throw std::runtime_error("Bindless table is out of slots for the ImGui font atlas!");
+    }
+    // ImTextureID is a pointer or a 64-bit integer depending on the ImGui version
+    io.Fonts->SetTexID((ImTextureID)(uintptr_t)(fontHandle + 1));
+    io.Fonts->ClearTexData();
+
+    reserve(INITIAL_REGION_SIZE);
+}
+
+void ImGuiRenderer::destroy() {
+    if (ring != VK_NULL_HANDLE) allocator->destroyBuffer(ring, ringAllocation);
+    ring = VK_NULL_HANDLE;
+    regionSize = 0;
+
+    bindless->release(BindlessType::SampledImage, fontHandle);
+    bindless->release(BindlessType::Sampler, samplerHandle);
+    fontHandle = BINDLESS_INVALID;
+    samplerHandle = BINDLESS_INVALID;
+    if (fontView != VK_NULL_HANDLE) vkDestroyImageView(device, fontView, nullptr);
+    if (fontImage != VK_NULL_HANDLE) allocator->destroyImage(fontImage, fontAllocation);
+    fontView = VK_NULL_HANDLE;
+    fontImage = VK_NULL_HANDLE;
+    sampler = VK_NULL_HANDLE;
+
+    if (pipeline != VK_NULL_HANDLE) vkDestroyPipeline(device, pipeline, nullptr);
+    pipeline = VK_NULL_HANDLE;
+    pipelineLayout = VK_NULL_HANDLE;
+}
+
+VkPipeline ImGuiRenderer::createPipeline(VkFormat format) {
+    VkShaderModule vertModule = loadShaderModule(device, "imgui.vert.spv");
+    VkShaderModule fragModule = loadShaderModule(device, "imgui.frag.spv");
+
+    VkPipelineShaderStageCreateInfo stages[2]{};
+    stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    stages[0].module = vertModule;
+    stages[0].pName = "main";
+    stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[1].module = fragModule;
+    stages[1].pName = "main";
+
+    VkVertexInputBindingDescription binding{};
+    binding.binding = 0;
+    binding.stride = sizeof(ImDrawVert);
+    binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+    VkVertexInputAttributeDescription attributes[3]{};
+    attributes[0] = {0, 0, VK_FORMAT_R32G32_SFLOAT, static_cast<uint32_t>(offsetof(ImDrawVert, pos))};
+    attributes[1] = {1, 0, VK_FORMAT_R32G32_SFLOAT, static_cast<uint32_t>(offsetof(ImDrawVert, uv))};
+    attributes[2] = {2, 0, VK_FORMAT_R8G8B8A8_UNORM, static_cast<uint32_t>(offsetof(ImDrawVert, col))};
+
+    VkPipelineVertexInputStateCreateInfo vertexInput{};
+    vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInput.vertexBindingDescriptionCount = 1;
+    vertexInput.pVertexBindingDescriptions = &binding;
+    vertexInput.vertexAttributeDescriptionCount = 3;
+    vertexInput.pVertexAttributeDescriptions = attributes;
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkPipelineViewportStateCreateInfo viewportState{};
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount = 1;
+
+    VkPipelineRasterizationStateCreateInfo rasterizer{};
+    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterizer.cullMode = VK_CULL_MODE_NONE;
+    rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterizer.lineWidth = 1.0f;
+
+    VkPipelineMultisampleStateCreateInfo multisampling{};
+    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    // Premultiplied by the source alpha, as ImGui expects
+    VkPipelineColorBlendAttachmentState blendAttachment{};
+    blendAttachment.blendEnable = VK_TRUE;
+    blendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    blendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    blendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+    blendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    blendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    blendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    blendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                                     VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+    VkPipelineColorBlendStateCreateInfo colorBlending{};
+    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlending.attachmentCount = 1;
+    colorBlending.pAttachments = &blendAttachment;
+
+    VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    VkPipelineDynamicStateCreateInfo dynamicState{};
+    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = 2;
+    dynamicState.pDynamicStates = dynamicStates;
+
+    VkPipelineRenderingCreateInfo renderingInfo{};
+    renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+    renderingInfo.colorAttachmentCount = 1;
+    renderingInfo.pColorAttachmentFormats = &format;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.pNext = &renderingInfo;
+    pipelineInfo.stageCount = 2;
+    pipelineInfo.pStages = stages;
+    pipelineInfo.pVertexInputState = &vertexInput;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterizer;
+    pipelineInfo.pMultisampleState = &multisampling;
+    pipelineInfo.pColorBlendState = &colorBlending;
+    pipelineInfo.pDynamicState = &dynamicState;
+    pipelineInfo.layout = pipelineLayout;
+
+    VkPipeline result = VK_NULL_HANDLE;
+    try {
+        result = pipelineCache->createGraphicsPipeline(pipelineInfo);
+    } catch (...) {
+        vkDestroyShaderModule(device, fragModule, nullptr);
+        vkDestroyShaderModule(device, vertModule, nullptr);
+        throw;
+    }
+    vkDestroyShaderModule(device, fragModule, nullptr);
+    vkDestroyShaderModule(device, vertModule, nullptr);
+    return result;
+}
+
+void ImGuiRenderer::setColorFormat(VkFormat format) {
+    if (format == colorFormat) return;
+    deletionQueue->destroyPipeline(pipeline);
+    colorFormat = format;
+    pipeline = createPipeline(format);
+}
+
+void ImGuiRenderer::reserve(VkDeviceSize bytesPerFrame) {
+    if (bytesPerFrame <= regionSize) return;
+
+    VkDeviceSize newRegion = std::max(regionSize, INITIAL_REGION_SIZE);
+    while (newRegion < bytesPerFrame) newRegion *= 2;
+
+    // Frames in flight may still be reading their region of the old ring
+    if (ring != VK_NULL_HANDLE) {
+        deletionQueue->destroyBuffer(ring, ringAllocation);
+        ++frameStats.ringGrowths;
+    }
+
+    VkBufferCreateInfo info{};
+    info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    info.size = newRegion * frameCount;
+    info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+    info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    ringAllocation = GpuAllocation{};
+    ring = allocator->createBuffer(info, MemoryUsage::CpuToGpu, ringAllocation);
+    regionSize = newRegion;
+    frameStats.ringBytes = info.size;
+}
+
+void ImGuiRenderer::bindState(VkCommandBuffer cmd, const ImDrawData *drawData, VkDeviceSize regionOffset,
+                              VkDeviceSize indexOffset) {
+    float fbWidth = drawData->DisplaySize.x * drawData->FramebufferScale.x;
+    float fbHeight = drawData->DisplaySize.y * drawData->FramebufferScale.y;
+
+    vkd.cmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    bindless->bind(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout);
+    vkd.cmdBindVertexBuffers(cmd, 0, 1, &ring, &regionOffset);
+    vkd.cmdBindIndexBuffer(cmd, ring, regionOffset + indexOffset,
+                         sizeof(ImDrawIdx) == 2 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32);
+
+    VkViewport viewport{0.0f, 0.0f, fbWidth, fbHeight, 0.0f, 1.0f};
+    vkd.cmdSetViewport(cmd, 0, 1, &viewport);
+}
+
+void ImGuiRenderer::record(VkCommandBuffer cmd, const ImDrawData *drawData, uint32_t frameIndex) {
+    uint32_t growths = frameStats.ringGrowths;
+    VkDeviceSize ringBytes = frameStats.ringBytes;
+    frameStats = ImGuiRendererStats{};
+    frameStats.ringGrowths = growths;
+    frameStats.ringBytes = ringBytes;
+    if (drawData == nullptr || drawData->TotalVtxCount == 0) return;
+
+    float fbWidth = drawData->DisplaySize.x * drawData->FramebufferScale.x;
+    float fbHeight = drawData->DisplaySize.y * drawData->FramebufferScale.y;
+    if (fbWidth <= 0.0f || fbHeight <= 0.0f) return;
+
+    VkDeviceSize vertexBytes = static_cast<VkDeviceSize>(drawData->TotalVtxCount) * sizeof(ImDrawVert);
+    VkDeviceSize indexOffset = alignUp(vertexBytes, 4);
+    VkDeviceSize indexBytes = static_cast<VkDeviceSize>(drawData->TotalIdxCount) * sizeof(ImDrawIdx);
+    reserve(indexOffset + indexBytes);
+
+    // With 32-bit indices every list's indices are rebased while copying, so commands from
+    // different lists share vertex offset 0 and can be merged
+    constexpr bool rebase = sizeof(ImDrawIdx) == 4;
+    VkDeviceSize regionOffset = static_cast<VkDeviceSize>(frameIndex) * regionSize;
+    char *region = static_cast<char *>(ringAllocation.mapped) + regionOffset;
+    ImDrawVert *vertexDst = reinterpret_cast<ImDrawVert *>(region);
+    ImDrawIdx *indexDst = reinterpret_cast<ImDrawIdx *>(region + indexOffset);
+    uint32_t vertexBase = 0;
+    for (int n = 0; n < drawData->CmdListsCount; ++n) {
+        const ImDrawList *list = drawData->CmdLists[n];
+        std::memcpy(vertexDst, list->VtxBuffer.Data, list->VtxBuffer.Size * sizeof(ImDrawVert));
+        if (rebase) {
+            for (int i = 0; i < list->IdxBuffer.Size; ++i) {
+                indexDst[i] = static_cast<ImDrawIdx>(list->IdxBuffer.Data[i] + vertexBase);
+            }
+        } else {
+            std::memcpy(indexDst, list->IdxBuffer.Data, list->IdxBuffer.Size * sizeof(ImDrawIdx));
+        }
+        vertexDst += list->VtxBuffer.Size;
+        indexDst += list->IdxBuffer.Size;
+        vertexBase += static_cast<uint32_t>(list->VtxBuffer.Size);
+    }
+    allocator->flush(ringAllocation, regionOffset, indexOffset + indexBytes);
+
+    bindState(cmd, drawData, regionOffset, indexOffset);
+
+    ImGuiPushConstants push{};
+    push.scale[0] = 2.0f / drawData->DisplaySize.x;
+    push.scale[1] = 2.0f / drawData->DisplaySize.y;
+    push.translate[0] = -1.0f - drawData->DisplayPos.x * push.scale[0];
+    push.translate[1] = -1.0f - drawData->DisplayPos.y * push.scale[1];
+    push.textureIndex = BINDLESS_INVALID;
+    push.samplerIndex = samplerHandle;
+    push.linearizeColors = isSrgb(colorFormat) ? 1 : 0;
+
+    struct Batch {
+        BindlessHandle texture = BINDLESS_INVALID;
+        VkRect2D scissor{};
+        uint32_t firstIndex = 0;
+        uint32_t indexCount = 0;
+        int32_t vertexOffset = 0;
+    };
+    Batch pending;
+    BindlessHandle boundTexture = BINDLESS_INVALID;
+    VkRect2D boundScissor{{-1, -1}, {0, 0}};
+
+    auto flushBatch = [&]() {
+        if (pending.indexCount == 0) return;
+        if (pending.texture != boundTexture) {
+            push.textureIndex = pending.texture;
+            vkd.cmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0,
+                               sizeof(push), &push);
+            boundTexture = pending.texture;
+        }
+        if (std::memcmp(&pending.scissor, &boundScissor, sizeof(VkRect2D)) != 0) {
+            vkd.cmdSetScissor(cmd, 0, 1, &pending.scissor);
+            boundScissor = pending.scissor;
+        }
+        vkd.cmdDrawIndexed(cmd, pending.indexCount, 1, pending.firstIndex, pending.vertexOffset, 0);
+        ++frameStats.drawCalls;
+        pending.indexCount = 0;
+    };
+
+    ImVec2 clipOffset = drawData->DisplayPos;
+    ImVec2 clipScale = drawData->FramebufferScale;
+    uint32_t globalIndex = 0;
+    int32_t globalVertex = 0;
+    for (int n = 0; n < drawData->CmdListsCount; ++n) {
+        const ImDrawList *list = drawData->CmdLists[n];
+        for (int c = 0; c < list->CmdBuffer.Size; ++c) {
+            const ImDrawCmd *pcmd = &list->CmdBuffer[c];
+            ++frameStats.commands;
+            if (pcmd->UserCallback != nullptr) {
+                flushBatch();
+                if (pcmd->UserCallback == ImDrawCallback_ResetRenderState) {
+                    bindState(cmd, drawData, regionOffset, indexOffset);
+                    boundTexture = BINDLESS_INVALID;
+                    boundScissor = VkRect2D{{-1, -1}, {0, 0}};
+                } else {
+                    pcmd->UserCallback(list, pcmd);
+                }
+                continue;
+            }
+
+            float minX = std::max((pcmd->ClipRect.x - clipOffset.x) * clipScale.x, 0.0f);
+            float minY = std::max((pcmd->ClipRect.y - clipOffset.y) * clipScale.y, 0.0f);
+            float maxX = std::min((pcmd->ClipRect.z - clipOffset.x) * clipScale.x, fbWidth);
+            float maxY = std::min((pcmd->ClipRect.w - clipOffset.y) * clipScale.y, fbHeight);
+            if (maxX <= minX || maxY <= minY) continue;
+
+            Batch next;
+            next.texture = textureHandle(pcmd->GetTexID());
+            next.scissor.offset = {static_cast<int32_t>(minX), static_cast<int32_t>(minY)};
+            next.scissor.extent = {static_cast<uint32_t>(maxX - minX), static_cast<uint32_t>(maxY - minY)};
+            next.firstIndex = globalIndex + pcmd->IdxOffset;
+            next.indexCount = pcmd->ElemCount;
+            next.vertexOffset = (rebase ? 0 : globalVertex) + static_cast<int32_t>(pcmd->VtxOffset);
+
+            bool contiguous = pending.indexCount != 0 && pending.firstIndex + pending.indexCount == next.firstIndex &&
+                              pending.vertexOffset == next.vertexOffset && pending.texture == next.texture &&
+                              std::memcmp(&pending.scissor, &next.scissor, sizeof(VkRect2D)) == 0;
+            if (contiguous) {
+                pending.indexCount += next.indexCount;
+            } else {
+                flushBatch();
+                pending = next;
+            }
+        }
+        globalIndex += static_cast<uint32_t>(list->IdxBuffer.Size);
+        globalVertex += list->VtxBuffer.Size;
+    }
+    flushBatch();
+
+    frameStats.vertices = static_cast<uint32_t>(drawData->TotalVtxCount);
+    frameStats.indices = static_cast<uint32_t>(drawData->TotalIdxCount);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "bindless.hpp"
+#include "deletion_queue.hpp"
+#include "gpu_allocator.hpp"
+#include "layout_cache.hpp"
+#include "pipeline_cache.hpp"
+#include "upload_service.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+struct ImDrawData;
+
+struct ImGuiRendererStats {
+    uint32_t vertices = 0;
+    uint32_t indices = 0;
+    // ImDrawCmds submitted by ImGui, and the draws they were batched into
+    uint32_t commands = 0;
+    uint32_t drawCalls = 0;
+    // Size of the whole ring (every frame's region) and how often it had to grow
+    VkDeviceSize ringBytes = 0;
+    uint32_t ringGrowths = 0;
+};
+
+// Dear ImGui renderer backend. Vertex and index data go into one persistently mapped ring
+// with a region per frame in flight, so nothing is allocated per frame; when a frame outgrows
+// its region the ring is replaced by one at least twice the size and the old one is handed to
+// the DeletionQueue. The font atlas lives in the bindless table for the lifetime of the
+// renderer and texture IDs are bindless handles, so a frame binds the pipeline and descriptor
+// set once; consecutive commands with the same texture and clip rect are merged into one
+// draw, and only changed state is re-recorded.
+//
+// Texture IDs are BindlessHandle + 1, since ImGui reserves 0 as "no texture".
+class ImGuiRenderer {
+public:
+    // The ImGui context must exist. Builds the font atlas and uploads it (blocking).
+    void init(VkPhysicalDevice physicalDevice, VkDevice device, GpuAllocator &allocator,
+              PipelineCache &pipelineCache, LayoutCache &layouts, BindlessTable &bindless, UploadService &uploads,
+              DeletionQueue &deletionQueue, VkFormat colorFormat, uint32_t frameCount);
+    // The GPU must be idle
+    void destroy();
+
+    // Rebuilds the pipeline for another color attachment format; the old one goes to the deletion queue
+    void setColorFormat(VkFormat format);
+
+    // Records drawData inside dynamic rendering on a color attachment of the current format.
+    // frameIndex selects the ring region and must belong to a frame whose fence has signalled.
+    void record(VkCommandBuffer cmd, const ImDrawData *drawData, uint32_t frameIndex);
+
+    const ImGuiRendererStats &stats() const { return frameStats; }
+
+private:
+    VkPipeline createPipeline(VkFormat format);
+    void reserve(VkDeviceSize bytesPerFrame);
+    void bindState(VkCommandBuffer cmd, const ImDrawData *drawData, VkDeviceSize regionOffset,
+                   VkDeviceSize indexOffset);
+
+    VkDevice device = VK_NULL_HANDLE;
+    GpuAllocator *allocator = nullptr;
+    PipelineCache *pipelineCache = nullptr;
+    BindlessTable *bindless = nullptr;
+    DeletionQueue *deletionQueue = nullptr;
+    uint32_t frameCount = 1;
+
+    // Owned by the layout cache, like sampler
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkFormat colorFormat = VK_FORMAT_UNDEFINED;
+
+    VkImage fontImage = VK_NULL_HANDLE;
+    GpuAllocation fontAllocation;
+    VkImageView fontView = VK_NULL_HANDLE;
+    VkSampler sampler = VK_NULL_HANDLE;
+    BindlessHandle fontHandle = BINDLESS_INVALID;
+    BindlessHandle samplerHandle = BINDLESS_INVALID;
+
+    VkBuffer ring = VK_NULL_HANDLE;
+    GpuAllocation ringAllocation;
+    VkDeviceSize regionSize = 0;
+
+    ImGuiRendererStats frameStats;
+};
@@ -0,0 +1,112 @@
+#include "init_graph.hpp"
+
+#include <stdexcept>
+
+InitGraph::Task InitGraph::add(const char *name, std::function<void()> fn, const std::vector<Task> &dependencies,
+                               bool mainThread) {
+    Task task = static_cast<Task>(nodes.size());
+    Node node;
+    node.name = name;
+    node.fn = std::move(fn);
+    node.mainThread = mainThread;
+    for (Task dependency : dependencies) {
+        if (dependency >= task) {
+            throw std::runtime_error("Init task dependencies must be added first!");
+        }
+        nodes[dependency].dependents.push_back(task);
+        ++node.waitingOn;
+    }
+    nodes.push_back(std::move(node));
+    return task;
+}
+
+void InitGraph::run(JobSystem &jobSystem, Profiler &prof) {
+    jobs = &jobSystem;
+    profiler = &prof;
+    start = std::chrono::steady_clock::now();
+    results.assign(nodes.size(), Timing{});
+    remaining = static_cast<uint32_t>(nodes.size());
+
+    for (Task task = 0; task < nodes.size(); ++task) {
+        if (nodes[task].waitingOn == 0) schedule(task);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (remaining > 0) {
+        if (!mainReady.empty()) {
+            Task task = mainReady.front();
+            mainReady.pop_front();
+            lock.unlock();
+            execute(task);
+            lock.lock();
+        } else if (jobs->workerCount() > 1) {
+            wake.wait(lock);
+        } else {
+            // No background workers: this thread runs the queued jobs itself
+            lock.unlock();
+            jobs->wait(counter);
+            lock.lock();
+        }
+    }
+    lock.unlock();
+    // The last job may still be returning from execute()
+    jobs->wait(counter);
+    wallMs = elapsedMs();
+
+    if (error) std::rethrow_exception(error);
+}
+
+void InitGraph::schedule(Task task) {
+    if (nodes[task].mainThread) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            mainReady.push_back(task);
+        }
+        wake.notify_all();
+        return;
+    }
+    jobs->submit([this, task](uint32_t) { execute(task); }, counter);
+}
+
+void InitGraph::execute(Task task) {
+    Node &node = nodes[task];
+    Timing &timing = results[task];
+    timing.name = node.name;
+    timing.worker = jobs->currentWorker();
+    timing.startMs = elapsedMs();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        timing.skipped = error != nullptr;
+    }
+    if (!timing.skipped) {
+        try {
+            ProfileZone zone(*profiler, node.name);
+            node.fn();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) error = std::current_exception();
+        }
+    }
+    timing.endMs = elapsedMs();
+
+    std::vector<Task> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (Task dependent : node.dependents) {
+            if (--nodes[dependent].waitingOn == 0) ready.push_back(dependent);
+        }
+        --remaining;
+    }
+    for (Task dependent : ready) schedule(dependent);
+    wake.notify_all();
+}
+
+double InitGraph::elapsedMs() const {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+double InitGraph::workMs() const {
+    double sum = 0.0;
+    for (const Timing &timing : results) sum += timing.endMs - timing.startMs;
+    return sum;
+}
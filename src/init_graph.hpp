@@ -0,0 +1,72 @@
+#pragma once
+
+#include "job_system.hpp"
+#include "profiler.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Startup work as a dependency graph. A task runs on a JobSystem worker as soon as every task
+// it depends on has finished; tasks marked mainThread (windowing, which GLFW only allows on
+// the main thread) run on the thread calling run(). Each task is timed and recorded as a
+// profiler zone. If a task throws, tasks that have not started yet are skipped and run()
+// rethrows the first exception once the running ones have finished.
+class InitGraph {
+public:
+    using Task = uint32_t;
+
+    struct Timing {
+        const char *name = nullptr;
+        // Since run() started
+        double startMs = 0.0;
+        double endMs = 0.0;
+        uint32_t worker = 0;
+        bool skipped = false;
+    };
+
+    // name must outlive the profiler (a literal). Dependencies must have been added before,
+    // which keeps the graph acyclic.
+    Task add(const char *name, std::function<void()> fn, const std::vector<Task> &dependencies = {},
+             bool mainThread = false);
+
+    // jobs must be initialized; run() may only be called once
+    void run(JobSystem &jobs, Profiler &profiler);
+
+    const std::vector<Timing> &timings() const { return results; }
+    double totalMs() const { return wallMs; }
+    // Sum of the task durations; above totalMs() when tasks overlapped
+    double workMs() const;
+
+private:
+    struct Node {
+        const char *name = nullptr;
+        std::function<void()> fn;
+        std::vector<Task> dependents;
+        uint32_t waitingOn = 0;
+        bool mainThread = false;
+    };
+
+    void schedule(Task task);
+    void execute(Task task);
+    double elapsedMs() const;
+
+    std::vector<Node> nodes;
+    std::vector<Timing> results;
+    double wallMs = 0.0;
+
+    JobSystem *jobs = nullptr;
+    Profiler *profiler = nullptr;
+    std::chrono::steady_clock::time_point start;
+    JobCounter counter;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Task> mainReady;
+    uint32_t remaining = 0;
+    std::exception_ptr error;
+};
@@ -0,0 +1,144 @@
+#include "job_system.hpp"
+
+#include <algorithm>
+
+namespace {
+
+// Set for threads owned by a JobSystem (and its init() thread)
+thread_local const void *tlsOwner = nullptr;
+thread_local uint32_t tlsWorker = 0;
+
+} // namespace
+
+void JobSystem::init(uint32_t count) {
+    if (count == 0) {
+        count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    queues.clear();
+    for (uint32_t i = 0; i < count; ++i) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+
+    tlsOwner = this;
+    tlsWorker = 0;
+    running = true;
+    for (uint32_t i = 1; i < count; ++i) {
+        threads.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+void JobSystem::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        running = false;
+    }
+    wakeCondition.notify_all();
+    for (auto &t : threads) t.join();
+    threads.clear();
+    queues.clear();
+    if (tlsOwner == this) tlsOwner = nullptr;
+}
+
+uint32_t JobSystem::currentWorker() const {
+    return tlsOwner == this ? tlsWorker : 0;
+}
+
+void JobSystem::submit(Job job, JobCounter &counter) {
+    counter.pending.fetch_add(1, std::memory_order_relaxed);
+
+    WorkerQueue &queue = *queues[currentWorker()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back({std::move(job), &counter});
+    }
+    {
+        // Incremented under the sleep mutex so a worker can't miss the wakeup between
+        // checking the count and going to sleep
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queuedTasks.fetch_add(1, std::memory_order_release);
+    }
+    wakeCondition.notify_one();
+}
+
+bool JobSystem::popOrSteal(uint32_t worker, Task &out) {
+    {
+        WorkerQueue &own = *queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            out = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Start at the next worker so victims are spread instead of everyone hammering worker 0
+    uint32_t count = workerCount();
+    for (uint32_t i = 1; i < count; ++i) {
+        WorkerQueue &victim = *queues[(worker + i) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            out = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool JobSystem::runOne(uint32_t worker) {
+    Task task;
+    if (!popOrSteal(worker, task)) return false;
+    queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+
+    // An escaping exception would terminate a worker thread or leave the counter pending forever
+    try {
+        task.job(worker);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(task.counter->errorMutex);
+        if (!task.counter->error) task.counter->error = std::current_exception();
+    }
+    task.counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+}
+
+void JobSystem::workerLoop(uint32_t worker) {
+    tlsOwner = this;
+    tlsWorker = worker;
+
+    while (running) {
+        if (runOne(worker)) continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeCondition.wait(lock, [this] {
+            return !running || queuedTasks.load(std::memory_order_acquire) > 0;
+        });
+    }
+}
+
+void JobSystem::wait(JobCounter &counter) {
+    uint32_t worker = currentWorker();
+    while (counter.pending.load(std::memory_order_acquire) > 0) {
+        // Help out instead of blocking; the remaining jobs may be running elsewhere
+        if (!runOne(worker)) std::this_thread::yield();
+    }
+
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(counter.errorMutex);
+        std::swap(error, counter.error);
+    }
+    if (error) std::rethrow_exception(error);
+}
+
+void JobSystem::parallelFor(uint32_t count, uint32_t grain, const std::function<void(uint32_t, uint32_t, uint32_t)> &fn) {
+    if (count == 0) return;
+    grain = std::max(grain, 1u);
+
+    JobCounter counter;
+    for (uint32_t begin = 0; begin < count; begin += grain) {
+        uint32_t end = std::min(count, begin + grain);
+        submit([&fn, begin, end](uint32_t worker) { fn(begin, end, worker); }, counter);
+    }
+    wait(counter);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Tracks a group of submitted jobs; wait() returns once all of them have run, rethrowing the
+// first exception any of them threw
+struct JobCounter {
+    std::atomic<uint32_t> pending{0};
+    std::mutex errorMutex;
+    std::exception_ptr error;
+};
+
+// Work-stealing job scheduler. Worker 0 is the thread that called init() and only runs jobs
+// while it is inside wait(); workers 1..N-1 are background threads. Each worker pushes and
+// pops at the back of its own deque and steals from the front of the others', so jobs a
+// worker spawns stay hot in its cache while idle workers pick up the oldest work.
+//
+// Jobs receive the index of the worker running them, which callers use to pick per-worker
+// resources (e.g. command pools) without locking.
+class JobSystem {
+public:
+    using Job = std::function<void(uint32_t worker)>;
+
+    // workerCount includes the calling thread; 0 uses one worker per hardware thread
+    void init(uint32_t workerCount = 0);
+    void shutdown();
+
+    uint32_t workerCount() const { return static_cast<uint32_t>(queues.size()); }
+    // Index of the calling thread, or 0 for threads the system does not own
+    uint32_t currentWorker() const;
+
+    void submit(Job job, JobCounter &counter);
+    // Runs queued jobs on the calling thread until counter drains, then rethrows the first
+    // exception a job of counter threw (clearing it, so the counter can be reused)
+    void wait(JobCounter &counter);
+
+    // Splits [0, count) into ranges of at most grain items, runs fn(begin, end, worker) for
+    // each and waits for all of them
+    void parallelFor(uint32_t count, uint32_t grain, const std::function<void(uint32_t, uint32_t, uint32_t)> &fn);
+
+private:
+    struct Task {
+        Job job;
+        JobCounter *counter = nullptr;
+    };
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(uint32_t worker);
+    bool runOne(uint32_t worker);
+    bool popOrSteal(uint32_t worker, Task &out);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> threads;
+    std::atomic<uint32_t> queuedTasks{0};
+    std::atomic<bool> running{false};
+    std::mutex sleepMutex;
+    std::condition_variable wakeCondition;
+};
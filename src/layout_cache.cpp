@@ -0,0 +1,166 @@
+#include "layout_cache.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// Appends fields one by one, so struct padding never ends up in a key
+struct KeyWriter {
+    std::string bytes;
+
+    template <typename T>
+    void put(const T &value) {
+        bytes.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+};
+
+const VkBaseInStructure *next(const void *pNext) {
+    return static_cast<const VkBaseInStructure*>(pNext);
+}
+
+} // namespace
+
+void LayoutCache::init(VkDevice dev) {
+    device = dev;
+}
+
+void LayoutCache::destroy() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &entry : pipelineLayouts) vkDestroyPipelineLayout(device, entry.second, nullptr);
+    for (auto &entry : setLayouts) vkDestroyDescriptorSetLayout(device, entry.second, nullptr);
+    for (auto &entry : samplers) vkDestroySampler(device, entry.second, nullptr);
+    pipelineLayouts.clear();
+    setLayouts.clear();
+    samplers.clear();
+}
+
+VkDescriptorSetLayout LayoutCache::descriptorSetLayout(const VkDescriptorSetLayoutCreateInfo &info) {
+    const VkDescriptorBindingFlags *bindingFlags = nullptr;
+    for (const VkBaseInStructure *s = next(info.pNext); s != nullptr; s = s->pNext) {
+        if (s->sType != VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO) {
+            throw std::runtime_error("Layout cache can't key this descriptor set layout's pNext chain!");
+        }
+        auto flags = reinterpret_cast<const VkDescriptorSetLayoutBindingFlagsCreateInfo*>(s);
+        if (flags->bindingCount != 0) bindingFlags = flags->pBindingFlags;
+    }
+
+    std::vector<uint32_t> order(info.bindingCount);
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(),
+              [&](uint32_t a, uint32_t b) { return info.pBindings[a].binding < info.pBindings[b].binding; });
+
+    KeyWriter key;
+    key.put(info.flags);
+    key.put(info.bindingCount);
+    for (uint32_t i : order) {
+        const VkDescriptorSetLayoutBinding &b = info.pBindings[i];
+        key.put(b.binding);
+        key.put(b.descriptorType);
+        key.put(b.descriptorCount);
+        key.put(b.stageFlags);
+        key.put(bindingFlags != nullptr ? bindingFlags[i] : VkDescriptorBindingFlags(0));
+        bool immutable = b.pImmutableSamplers != nullptr &&
+                         (b.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER ||
+                          b.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+        key.put(immutable);
+        for (uint32_t s = 0; immutable && s < b.descriptorCount; ++s) key.put(b.pImmutableSamplers[s]);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = setLayouts.find(key.bytes);
+    if (it != setLayouts.end()) {
+        ++hits;
+        return it->second;
+    }
+    VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+    if (vkCreateDescriptorSetLayout(device, &info, nullptr, &layout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create descriptor set layout!");
+    }
+    setLayouts.emplace(std::move(key.bytes), layout);
+    return layout;
+}
+
+VkPipelineLayout LayoutCache::pipelineLayout(const VkPipelineLayoutCreateInfo &info) {
+    if (info.pNext != nullptr) {
+        throw std::runtime_error("Layout cache can't key this pipeline layout's pNext chain!");
+    }
+    KeyWriter key;
+    key.put(info.flags);
+    key.put(info.setLayoutCount);
+    for (uint32_t i = 0; i < info.setLayoutCount; ++i) key.put(info.pSetLayouts[i]);
+    key.put(info.pushConstantRangeCount);
+    for (uint32_t i = 0; i < info.pushConstantRangeCount; ++i) {
+        const VkPushConstantRange &range = info.pPushConstantRanges[i];
+        key.put(range.stageFlags);
+        key.put(range.offset);
+        key.put(range.size);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = pipelineLayouts.find(key.bytes);
+    if (it != pipelineLayouts.end()) {
+        ++hits;
+        return it->second;
+    }
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    if (vkCreatePipelineLayout(device, &info, nullptr, &layout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create pipeline layout!");
+    }
+    pipelineLayouts.emplace(std::move(key.bytes), layout);
+    return layout;
+}
+
+VkSampler LayoutCache::sampler(const VkSamplerCreateInfo &info) {
+    VkSamplerReductionMode reduction = VK_SAMPLER_REDUCTION_MODE_WEIGHTED_AVERAGE;
+    for (const VkBaseInStructure *s = next(info.pNext); s != nullptr; s = s->pNext) {
+        if (s->sType != VK_STRUCTURE_TYPE_SAMPLER_REDUCTION_MODE_CREATE_INFO) {
+            throw std::runtime_error("Layout cache can't key this sampler's pNext chain!");
+        }
+        reduction = reinterpret_cast<const VkSamplerReductionModeCreateInfo*>(s)->reductionMode;
+    }
+
+    KeyWriter key;
+    key.put(info.flags);
+    key.put(info.magFilter);
+    key.put(info.minFilter);
+    key.put(info.mipmapMode);
+    key.put(info.addressModeU);
+    key.put(info.addressModeV);
+    key.put(info.addressModeW);
+    key.put(info.mipLodBias);
+    key.put(info.anisotropyEnable);
+    key.put(info.maxAnisotropy);
+    key.put(info.compareEnable);
+    key.put(info.compareOp);
+    key.put(info.minLod);
+    key.put(info.maxLod);
+    key.put(info.borderColor);
+    key.put(info.unnormalizedCoordinates);
+    key.put(reduction);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = samplers.find(key.bytes);
+    if (it != samplers.end()) {
+        ++hits;
+        return it->second;
+    }
+    VkSampler sampler = VK_NULL_HANDLE;
+    if (vkCreateSampler(device, &info, nullptr, &sampler) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create sampler!");
+    }
+    samplers.emplace(std::move(key.bytes), sampler);
+    return sampler;
+}
+
+LayoutCacheStats LayoutCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    LayoutCacheStats s;
+    s.setLayouts = static_cast<uint32_t>(setLayouts.size());
+    s.pipelineLayouts = static_cast<uint32_t>(pipelineLayouts.size());
+    s.samplers = static_cast<uint32_t>(samplers.size());
+    s.hits = hits;
+    return s;
+}
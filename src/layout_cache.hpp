@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+struct LayoutCacheStats {
+    uint32_t setLayouts = 0;
+    uint32_t pipelineLayouts = 0;
+    uint32_t samplers = 0;
+    // Requests answered with an existing handle
+    uint64_t hits = 0;
+};
+
+// Hash-consed descriptor set layouts, pipeline layouts and samplers: create-infos that
+// describe the same object return the same handle, which the cache owns until destroy().
+// Each create-info is flattened into a byte key (set layout bindings in binding order, so
+// their order in pBindings doesn't matter). pNext chains are only accepted where listed
+// below; anything else throws rather than risk handing out a handle that differs in state
+// the key doesn't see. Safe to call from multiple threads.
+class LayoutCache {
+public:
+    void init(VkDevice device);
+    // Destroys every cached object; nothing may still use them
+    void destroy();
+
+    // pNext may hold a VkDescriptorSetLayoutBindingFlagsCreateInfo
+    VkDescriptorSetLayout descriptorSetLayout(const VkDescriptorSetLayoutCreateInfo &info);
+    // pNext must be null
+    VkPipelineLayout pipelineLayout(const VkPipelineLayoutCreateInfo &info);
+    // pNext may hold a VkSamplerReductionModeCreateInfo
+    VkSampler sampler(const VkSamplerCreateInfo &info);
+
+    LayoutCacheStats stats() const;
+
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, VkDescriptorSetLayout> setLayouts;
+    std::unordered_map<std::string, VkPipelineLayout> pipelineLayouts;
+    std::unordered_map<std::string, VkSampler> samplers;
+    uint64_t hits = 0;
+};
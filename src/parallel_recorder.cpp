@@ -0,0 +1,85 @@
+#include "parallel_recorder.hpp"
+
+#include "vk_dispatch.hpp"
+
+#include <stdexcept>
+
+void ParallelRecorder::init(VkDevice dev, uint32_t queueFamily, uint32_t workerCount, uint32_t frames) {
+    device = dev;
+    frameCount = frames;
+    workerFrames.resize(static_cast<size_t>(workerCount) * frameCount);
+
+    for (auto &wf : workerFrames) {
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        poolInfo.queueFamilyIndex = queueFamily;
+        if (vkCreateCommandPool(device, &poolInfo, nullptr, &wf.pool) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create worker command pool!");
+        }
+    }
+}
+
+void ParallelRecorder::destroy() {
+    for (auto &wf : workerFrames) {
+        // Destroying the pool frees its command buffers
+        vkDestroyCommandPool(device, wf.pool, nullptr);
+    }
+    workerFrames.clear();
+    recorded.clear();
+}
+
+void ParallelRecorder::beginFrame(uint32_t frameIndex) {
+    currentFrame = frameIndex;
+    for (size_t i = frameIndex; i < workerFrames.size(); i += frameCount) {
+        // Resetting the pool is much cheaper than resetting each buffer, and the buffers stay
+        // allocated for reuse
+        vkd.resetCommandPool(device, workerFrames[i].pool, 0);
+        workerFrames[i].used = 0;
+    }
+}
+
+VkCommandBuffer ParallelRecorder::acquire(uint32_t worker) {
+    WorkerFrame &wf = workerFrames[static_cast<size_t>(worker) * frameCount + currentFrame];
+    if (wf.used == wf.buffers.size()) {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = wf.pool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandBufferCount = 1;
+        VkCommandBuffer cmd = VK_NULL_HANDLE;
+        if (vkd.allocateCommandBuffers(device, &allocInfo, &cmd) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate secondary command buffer!");
+        }
+        wf.buffers.push_back(cmd);
+    }
+    return wf.buffers[wf.used++];
+}
+
+const std::vector<VkCommandBuffer> &ParallelRecorder::record(JobSystem &jobs, uint32_t count, uint32_t grain,
+                                                             const VkCommandBufferInheritanceInfo &inheritance,
+                                                             const RecordFn &fn) {
+    grain = grain == 0 ? 1 : grain;
+    recorded.assign((count + grain - 1) / grain, VK_NULL_HANDLE);
+
+    jobs.parallelFor(count, grain, [&](uint32_t begin, uint32_t end, uint32_t worker) {
+        VkCommandBuffer cmd = acquire(worker);
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+                          VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &inheritance;
+        if (vkd.beginCommandBuffer(cmd, &beginInfo) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to begin secondary command buffer!");
+        }
+        fn(cmd, begin, end);
+        if (vkd.endCommandBuffer(cmd) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to record secondary command buffer!");
+        }
+
+        // Each job writes its own slot, so the submission order is the draw order
+        recorded[begin / grain] = cmd;
+    });
+    return recorded;
+}
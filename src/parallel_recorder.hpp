@@ -0,0 +1,47 @@
+#pragma once
+
+#include "job_system.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Records one frame's draws across JobSystem workers into secondary command buffers. Every
+// worker owns a command pool per frame in flight, so recording never shares a pool between
+// threads and a frame's pools can be reset wholesale once its fence has signalled.
+class ParallelRecorder {
+public:
+    // Records draws [begin, end) into cmd, which is already begun with the inheritance info
+    using RecordFn = std::function<void(VkCommandBuffer cmd, uint32_t begin, uint32_t end)>;
+
+    void init(VkDevice device, uint32_t queueFamily, uint32_t workerCount, uint32_t frameCount);
+    void destroy();
+
+    // Must only be called once the GPU has finished with frameIndex's previous submission
+    void beginFrame(uint32_t frameIndex);
+
+    // Splits [0, count) into jobs of at most grain draws and returns the recorded secondaries
+    // in draw order, ready for vkCmdExecuteCommands.
+    const std::vector<VkCommandBuffer> &record(JobSystem &jobs, uint32_t count, uint32_t grain,
+                                               const VkCommandBufferInheritanceInfo &inheritance,
+                                               const RecordFn &fn);
+
+private:
+    struct WorkerFrame {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        std::vector<VkCommandBuffer> buffers;
+        // Buffers handed out since the last reset
+        uint32_t used = 0;
+    };
+
+    VkCommandBuffer acquire(uint32_t worker);
+
+    VkDevice device = VK_NULL_HANDLE;
+    uint32_t frameCount = 0;
+    uint32_t currentFrame = 0;
+    // Indexed [worker * frameCount + frame]
+    std::vector<WorkerFrame> workerFrames;
+    std::vector<VkCommandBuffer> recorded;
+};
@@ -0,0 +1,182 @@
+#include "pipeline_cache.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+void PipelineCache::init(VkPhysicalDevice physicalDevice, VkDevice dev, const std::string &cachePath) {
+    device = dev;
+    path = cachePath;
+    vkGetPhysicalDeviceProperties(physicalDevice, &deviceProps);
+    // Creation feedback is core since 1.3
+    feedbackSupported = deviceProps.apiVersion >= VK_API_VERSION_1_3;
+
+    std::vector<char> blob;
+    if (!path.empty()) {
+        std::ifstream file(path, std::ios::ate | std::ios::binary);
+        if (file) {
+            blob.resize(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(blob.data(), static_cast<std::streamsize>(blob.size()));
+        }
+    }
+
+    std::string reason;
+    if (!blob.empty() && !validateHeader(blob, reason)) {
+        // A cache from another GPU or driver is at best useless and at worst rejected
+        // by the driver, so start cold rather than hand it over.
+        std::cout << "Ignoring pipeline cache " << path << ": " << reason << "\n";
+        blob.clear();
+    }
+
+    VkPipelineCacheCreateInfo info{};
+    info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    info.initialDataSize = blob.size();
+    info.pInitialData = blob.empty() ? nullptr : blob.data();
+    if (vkCreatePipelineCache(device, &info, nullptr, &cache) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create pipeline cache!");
+    }
+
+    loadedBytes = blob.size();
+    loadedFromDisk = !blob.empty();
+}
+
+bool PipelineCache::validateHeader(const std::vector<char> &blob, std::string &reason) const {
+    VkPipelineCacheHeaderVersionOne header;
+    if (blob.size() < sizeof(header)) {
+        reason = "truncated header";
+        return false;
+    }
+    std::memcpy(&header, blob.data(), sizeof(header));
+
+    if (header.headerSize < sizeof(header) || header.headerSize > blob.size()) {
+        reason = "bad header size";
+        return false;
+    }
+    if (header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE) {
+        reason = "unknown header version";
+        return false;
+    }
+    if (header.vendorID != deviceProps.vendorID || header.deviceID != deviceProps.deviceID) {
+        reason = "created on a different device";
+        return false;
+    }
+    if (std::memcmp(header.pipelineCacheUUID, deviceProps.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+        reason = "created by a different driver version";
+        return false;
+    }
+    return true;
+}
+
+bool PipelineCache::save() {
+    if (cache == VK_NULL_HANDLE || path.empty()) return false;
+
+    size_t size = 0;
+    if (vkGetPipelineCacheData(device, cache, &size, nullptr) != VK_SUCCESS || size == 0) {
+        return false;
+    }
+    std::vector<char> blob(size);
+    if (vkGetPipelineCacheData(device, cache, &size, blob.data()) != VK_SUCCESS) {
+        return false;
+    }
+
+    // Write next to the target and rename over it, so a crash mid-write can never leave a
+    // torn cache that the next launch would have to detect and discard.
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cerr << "Failed to write pipeline cache: " << tmpPath << std::endl;
+            return false;
+        }
+        out.write(blob.data(), static_cast<std::streamsize>(size));
+        out.flush();
+        if (!out) {
+            std::cerr << "Failed to write pipeline cache: " << tmpPath << std::endl;
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        std::cerr << "Failed to replace pipeline cache " << path << ": " << ec.message() << std::endl;
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+    return true;
+}
+
+void PipelineCache::destroy() {
+    if (cache != VK_NULL_HANDLE) {
+        vkDestroyPipelineCache(device, cache, nullptr);
+        cache = VK_NULL_HANDLE;
+    }
+}
+
+void PipelineCache::recordCreation(const VkPipelineCreationFeedback &feedback, double ms) {
+    ++pipelinesCreated;
+    totalCreateNs += static_cast<uint64_t>(ms * 1e6);
+    if (!(feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT)) {
+        ++feedbackUnavailable;
+    } else if (feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT) {
+        ++cacheHits;
+    }
+}
+
+VkPipeline PipelineCache::createGraphicsPipeline(const VkGraphicsPipelineCreateInfo &info) {
+    VkPipelineCreationFeedback feedback{};
+    VkPipelineCreationFeedbackCreateInfo feedbackInfo{};
+    feedbackInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO;
+    feedbackInfo.pPipelineCreationFeedback = &feedback;
+
+    VkGraphicsPipelineCreateInfo ci = info;
+    if (feedbackSupported) {
+        feedbackInfo.pNext = ci.pNext;
+        ci.pNext = &feedbackInfo;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    if (vkCreateGraphicsPipelines(device, cache, 1, &ci, nullptr, &pipeline) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create graphics pipeline!");
+    }
+    recordCreation(feedback, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    return pipeline;
+}
+
+VkPipeline PipelineCache::createComputePipeline(const VkComputePipelineCreateInfo &info) {
+    VkPipelineCreationFeedback feedback{};
+    VkPipelineCreationFeedbackCreateInfo feedbackInfo{};
+    feedbackInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO;
+    feedbackInfo.pPipelineCreationFeedback = &feedback;
+
+    VkComputePipelineCreateInfo ci = info;
+    if (feedbackSupported) {
+        feedbackInfo.pNext = ci.pNext;
+        ci.pNext = &feedbackInfo;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    if (vkCreateComputePipelines(device, cache, 1, &ci, nullptr, &pipeline) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create compute pipeline!");
+    }
+    recordCreation(feedback, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    return pipeline;
+}
+
+PipelineCacheStats PipelineCache::stats() const {
+    PipelineCacheStats s;
+    s.loadedBytes = loadedBytes;
+    s.loadedFromDisk = loadedFromDisk;
+    s.pipelinesCreated = pipelinesCreated.load();
+    s.cacheHits = cacheHits.load();
+    s.feedbackUnavailable = feedbackUnavailable.load();
+    s.totalCreateMs = static_cast<double>(totalCreateNs.load()) / 1e6;
+    return s;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct PipelineCacheStats {
+    size_t loadedBytes = 0;
+    bool loadedFromDisk = false;
+    uint32_t pipelinesCreated = 0;
+    // Pipelines the driver reports as served from the application cache
+    uint32_t cacheHits = 0;
+    // Pipelines created without VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT (hit state unknown)
+    uint32_t feedbackUnavailable = 0;
+    double totalCreateMs = 0.0;
+};
+
+// Owns the engine's VkPipelineCache. The blob is loaded from disk at startup and only
+// accepted if its header matches this exact device and driver (vendorID, deviceID and
+// pipelineCacheUUID), then written back atomically on save().
+//
+// All pipeline creation should go through createGraphicsPipeline()/createComputePipeline() so
+// every pipeline benefits from the cache and is counted in the hit statistics. Both are safe
+// to call from multiple threads.
+class PipelineCache {
+public:
+    void init(VkPhysicalDevice physicalDevice, VkDevice device, const std::string &path);
+    // Serializes the cache to path via a temporary file and rename. Never throws.
+    bool save();
+    void destroy();
+
+    VkPipelineCache handle() const { return cache; }
+
+    VkPipeline createGraphicsPipeline(const VkGraphicsPipelineCreateInfo &info);
+    VkPipeline createComputePipeline(const VkComputePipelineCreateInfo &info);
+
+    PipelineCacheStats stats() const;
+
+private:
+    bool validateHeader(const std::vector<char> &blob, std::string &reason) const;
+    void recordCreation(const VkPipelineCreationFeedback &feedback, double ms);
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkPipelineCache cache = VK_NULL_HANDLE;
+    std::string path;
+    VkPhysicalDeviceProperties deviceProps{};
+    bool feedbackSupported = false;
+
+    size_t loadedBytes = 0;
+    bool loadedFromDisk = false;
+    std::atomic<uint32_t> pipelinesCreated{0};
+    std::atomic<uint32_t> cacheHits{0};
+    std::atomic<uint32_t> feedbackUnavailable{0};
+    std::atomic<uint64_t> totalCreateNs{0};
+};
@@ -0,0 +1,210 @@
+#include "post_process.hpp"
+
+#include "vk_dispatch.hpp"
+#include "vk_utils.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+// Must match the push_constant block in shaders/bloom.comp
+struct BloomPushConstants {
+    int32_t srcSize[2];
+    int32_t dstSize[2];
+    uint32_t src;
+    uint32_t dst;
+    float threshold;
+};
+
+// Must match the push_constant block in shaders/tonemap.comp
+struct TonemapPushConstants {
+    int32_t size[2];
+    uint32_t hdr;
+    uint32_t bloom;
+    uint32_t dst;
+    uint32_t samplerIndex;
+    float exposure;
+    float bloomStrength;
+};
+
+constexpr VkFormat BLOOM_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+constexpr VkFormat LDR_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+constexpr uint32_t GROUP_SIZE = 8;
+constexpr float BLOOM_THRESHOLD = 0.6f;
+constexpr float BLOOM_STRENGTH = 0.5f;
+constexpr float EXPOSURE = 1.2f;
+
+uint32_t groups(uint32_t n, uint32_t size) {
+    return (n + size - 1) / size;
+}
+
+} // namespace
+
+void PostProcess::init(VkDevice dev, PipelineCache &pipelineCache, LayoutCache &layouts, BindlessTable &table) {
+    device = dev;
+    bindless = &table;
+
+    VkPushConstantRange pushRange{};
+    pushRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushRange.offset = 0;
+    pushRange.size = static_cast<uint32_t>(std::max(sizeof(BloomPushConstants), sizeof(TonemapPushConstants)));
+
+    VkDescriptorSetLayout setLayout = bindless->layout();
+    VkPipelineLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &setLayout;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &pushRange;
+    computeLayout = layouts.pipelineLayout(layoutInfo);
+
+    auto createPipeline = [&](const char *shader) {
+        VkShaderModule module = loadShaderModule(device, shader);
+        VkComputePipelineCreateInfo info{};
+        info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        info.stage.module = module;
+        info.stage.pName = "main";
+        info.layout = computeLayout;
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        try {
+            pipeline = pipelineCache.createComputePipeline(info);
+        } catch (...) {
+            vkDestroyShaderModule(device, module, nullptr);
+            throw;
+        }
+        vkDestroyShaderModule(device, module, nullptr);
+        return pipeline;
+    };
+    bloomPipeline = createPipeline("bloom.comp.spv");
+    tonemapPipeline = createPipeline("tonemap.comp.spv");
+
+    // Upsamples the half-resolution bloom
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    linearSampler = layouts.sampler(samplerInfo);
+    samplerHandle = bindless->addSampler(linearSampler);
+    if (samplerHandle == BINDLESS_INVALID) {
+        throw std::runtime_error("Bindless table is out of sampler slots!");
+    }
+}
+
+void PostProcess::destroy() {
+    releaseHandles();
+    bindless->release(BindlessType::Sampler, samplerHandle);
+    samplerHandle = BINDLESS_INVALID;
+    if (tonemapPipeline != VK_NULL_HANDLE) vkDestroyPipeline(device, tonemapPipeline, nullptr);
+    if (bloomPipeline != VK_NULL_HANDLE) vkDestroyPipeline(device, bloomPipeline, nullptr);
+    linearSampler = VK_NULL_HANDLE;
+    tonemapPipeline = VK_NULL_HANDLE;
+    bloomPipeline = VK_NULL_HANDLE;
+    computeLayout = VK_NULL_HANDLE;
+}
+
+void PostProcess::releaseHandles() {
+    // A retired graph may still be using the old views; the slots are recycled frames later
+    for (const Handles &h : handles) {
+        bindless->release(BindlessType::SampledImage, h.hdrSampled);
+        bindless->release(BindlessType::StorageImage, h.bloomStorage);
+        bindless->release(BindlessType::SampledImage, h.bloomSampled);
+        bindless->release(BindlessType::StorageImage, h.ldrStorage);
+    }
+    handles.clear();
+}
+
+void PostProcess::addPasses(RenderGraph &graph, RGHandle hdr, RGHandle output, VkExtent2D outputExtent) {
+    extent = outputExtent;
+    bloomExtent = {std::max(extent.width / 2, 1u), std::max(extent.height / 2, 1u)};
+    hdrRes = hdr;
+    outputRes = output;
+    bloomRes = graph.createTexture("bloom", {BLOOM_FORMAT, bloomExtent});
+    ldrRes = graph.createTexture("ldr", {LDR_FORMAT, extent});
+
+    graph.addPass("bloom",
+        [&](RenderGraph::PassBuilder &pass) {
+            pass.read(hdrRes, RGUsage::SampledCompute);
+            pass.write(bloomRes, RGUsage::StorageWriteCompute);
+            pass.asyncCompute();
+        },
+        [this](RGPassContext &ctx) {
+            const Handles &h = handles[ctx.frameSlot % handles.size()];
+            BloomPushConstants push{};
+            push.srcSize[0] = static_cast<int32_t>(extent.width);
+            push.srcSize[1] = static_cast<int32_t>(extent.height);
+            push.dstSize[0] = static_cast<int32_t>(bloomExtent.width);
+            push.dstSize[1] = static_cast<int32_t>(bloomExtent.height);
+            push.src = h.hdrSampled;
+            push.dst = h.bloomStorage;
+            push.threshold = BLOOM_THRESHOLD;
+            vkd.cmdBindPipeline(ctx.cmd, VK_PIPELINE_BIND_POINT_COMPUTE, bloomPipeline);
+            bindless->bind(ctx.cmd, VK_PIPELINE_BIND_POINT_COMPUTE, computeLayout);
+            vkd.cmdPushConstants(ctx.cmd, computeLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), &push);
+            vkd.cmdDispatch(ctx.cmd, groups(bloomExtent.width, GROUP_SIZE), groups(bloomExtent.height, GROUP_SIZE), 1);
+        });
+
+    graph.addPass("tonemap",
+        [&](RenderGraph::PassBuilder &pass) {
+            pass.read(hdrRes, RGUsage::SampledCompute);
+            pass.read(bloomRes, RGUsage::SampledCompute);
+            pass.write(ldrRes, RGUsage::StorageWriteCompute);
+            pass.asyncCompute();
+        },
+        [this](RGPassContext &ctx) {
+            const Handles &h = handles[ctx.frameSlot % handles.size()];
+            TonemapPushConstants push{};
+            push.size[0] = static_cast<int32_t>(extent.width);
+            push.size[1] = static_cast<int32_t>(extent.height);
+            push.hdr = h.hdrSampled;
+            push.bloom = h.bloomSampled;
+            push.dst = h.ldrStorage;
+            push.samplerIndex = samplerHandle;
+            push.exposure = EXPOSURE;
+            push.bloomStrength = BLOOM_STRENGTH;
+            vkd.cmdBindPipeline(ctx.cmd, VK_PIPELINE_BIND_POINT_COMPUTE, tonemapPipeline);
+            bindless->bind(ctx.cmd, VK_PIPELINE_BIND_POINT_COMPUTE, computeLayout);
+            vkd.cmdPushConstants(ctx.cmd, computeLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), &push);
+            vkd.cmdDispatch(ctx.cmd, groups(extent.width, GROUP_SIZE), groups(extent.height, GROUP_SIZE), 1);
+        });
+
+    // Swapchain formats generally can't be storage images, so the result is blitted over
+    graph.addPass("resolve",
+        [&](RenderGraph::PassBuilder &pass) {
+            pass.read(ldrRes, RGUsage::TransferSrc);
+            pass.write(outputRes, RGUsage::TransferDst);
+        },
+        [this](RGPassContext &ctx) {
+            VkImageBlit region{};
+            region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+            region.srcOffsets[1] = {static_cast<int32_t>(extent.width), static_cast<int32_t>(extent.height), 1};
+            region.dstSubresource = region.srcSubresource;
+            region.dstOffsets[1] = region.srcOffsets[1];
+            vkd.cmdBlitImage(ctx.cmd, ctx.graph->image(ldrRes), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                           ctx.graph->image(outputRes), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region,
+                           VK_FILTER_NEAREST);
+        });
+}
+
+void PostProcess::graphCompiled(const RenderGraph &graph) {
+    releaseHandles();
+    // All three are used by the async passes, so they have the same number of copies
+    handles.resize(graph.copyCount(hdrRes));
+    for (uint32_t c = 0; c < handles.size(); ++c) {
+        Handles &h = handles[c];
+        h.hdrSampled = bindless->addSampledImage(graph.view(hdrRes, c));
+        h.bloomStorage = bindless->addStorageImage(graph.view(bloomRes, c));
+        h.bloomSampled = bindless->addSampledImage(graph.view(bloomRes, c));
+        h.ldrStorage = bindless->addStorageImage(graph.view(ldrRes, c));
+        if (h.hdrSampled == BINDLESS_INVALID || h.bloomStorage == BINDLESS_INVALID ||
+            h.bloomSampled == BINDLESS_INVALID || h.ldrStorage == BINDLESS_INVALID) {
+            throw std::runtime_error("Bindless table is out of image slots!");
+        }
+    }
+}
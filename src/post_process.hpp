@@ -0,0 +1,64 @@
+#pragma once
+
+#include "bindless.hpp"
+#include "layout_cache.hpp"
+#include "pipeline_cache.hpp"
+#include "render_graph.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+// Post-processing of the HDR scene color as render graph passes:
+//   bloom (compute): bright-pass and blur into a half-resolution image
+//   tonemap (compute): exposure, bloom and ACES tonemapping into an RGBA8 image
+//   resolve (graphics): blits the result into the output, converting to its format
+// Both compute passes are async compute passes, so they run on the compute queue when the
+// device has a separate compute family. The graph then keeps a copy of hdr, bloom and ldr per
+// frame in flight, letting the next frame's scene pass run on the graphics queue meanwhile.
+// Needs BindlessTable (the passes address their images through it).
+class PostProcess {
+public:
+    // What the scene renders into when post-processing is on
+    static constexpr VkFormat HDR_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+    void init(VkDevice device, PipelineCache &pipelineCache, LayoutCache &layouts, BindlessTable &bindless);
+    // The GPU must be idle
+    void destroy();
+
+    // Adds the passes after the one writing hdr (HDR_FORMAT, extent). output needs
+    // VK_IMAGE_USAGE_TRANSFER_DST_BIT and a format that supports blitting into.
+    void addPasses(RenderGraph &graph, RGHandle hdr, RGHandle output, VkExtent2D extent);
+    // Call after graph.compile(), once the transient images exist
+    void graphCompiled(const RenderGraph &graph);
+
+private:
+    void releaseHandles();
+
+    VkDevice device = VK_NULL_HANDLE;
+    BindlessTable *bindless = nullptr;
+
+    // Layout and sampler are owned by the layout cache
+    VkPipelineLayout computeLayout = VK_NULL_HANDLE;
+    VkPipeline bloomPipeline = VK_NULL_HANDLE;
+    VkPipeline tonemapPipeline = VK_NULL_HANDLE;
+    VkSampler linearSampler = VK_NULL_HANDLE;
+    BindlessHandle samplerHandle = BINDLESS_INVALID;
+
+    // Handles into the graph the passes were last added to
+    RGHandle hdrRes = RG_INVALID;
+    RGHandle bloomRes = RG_INVALID;
+    RGHandle ldrRes = RG_INVALID;
+    RGHandle outputRes = RG_INVALID;
+    VkExtent2D extent{};
+    VkExtent2D bloomExtent{};
+    // Per copy of the transients, indexed by frame slot modulo copies
+    struct Handles {
+        BindlessHandle hdrSampled = BINDLESS_INVALID;
+        BindlessHandle bloomStorage = BINDLESS_INVALID;
+        BindlessHandle bloomSampled = BINDLESS_INVALID;
+        BindlessHandle ldrStorage = BINDLESS_INVALID;
+    };
+    std::vector<Handles> handles;
+};
@@ -0,0 +1,278 @@
+#include "profiler.hpp"
+
+#include "vk_dispatch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+std::atomic<uint64_t> nextInstanceId{1};
+
+// Set for threads that have recorded into a Profiler; 0 = none
+thread_local uint64_t tlsOwner = 0;
+thread_local void *tlsBuffer = nullptr;
+
+int64_t steadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void writeJsonString(std::ofstream &out, const char *s) {
+    out << '"';
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\') out << '\\';
+        if (static_cast<unsigned char>(*s) >= 0x20) out << *s;
+    }
+    out << '"';
+}
+
+// Chrome trace timestamps are in microseconds
+double toUs(uint64_t ns) {
+    return static_cast<double>(ns) / 1000.0;
+}
+
+} // namespace
+
+void Profiler::setEnabled(bool on) {
+    if (on && !active) {
+        epoch = steadyNs();
+        lastFrameEnd = 0;
+    }
+    active = on;
+}
+
+void Profiler::initGpu(VkPhysicalDevice physicalDevice, VkDevice dev, uint32_t queueFamily, uint32_t frameCount,
+                       uint32_t maxZonesPerFrame) {
+    if (!active) return;
+    device = dev;
+
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &props);
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+
+    uint32_t validBits = queueFamily < familyCount ? families[queueFamily].timestampValidBits : 0;
+    if (validBits == 0 || props.limits.timestampPeriod == 0.0f) return;
+    timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+    timestampPeriod = props.limits.timestampPeriod;
+    maxZones = maxZonesPerFrame;
+    slots.assign(frameCount, GpuSlot{});
+    queryScratch.resize(static_cast<size_t>(maxZones) * 2);
+
+    VkQueryPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = frameCount * maxZones * 2;
+    if (vkCreateQueryPool(device, &poolInfo, nullptr, &queryPool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create timestamp query pool!");
+    }
+}
+
+void Profiler::destroy() {
+    if (queryPool != VK_NULL_HANDLE) {
+        vkDestroyQueryPool(device, queryPool, nullptr);
+        queryPool = VK_NULL_HANDLE;
+    }
+    slots.clear();
+}
+
+uint32_t Profiler::internName(const std::string &name) {
+    auto it = nameIds.find(name);
+    if (it != nameIds.end()) return it->second;
+    uint32_t id = static_cast<uint32_t>(names.size());
+    names.push_back(name);
+    nameIds.emplace(name, id);
+    return id;
+}
+
+void Profiler::beginFrame(VkCommandBuffer cmd, uint32_t frameIndex) {
+    if (queryPool == VK_NULL_HANDLE) return;
+    currentSlot = frameIndex;
+    collectSlot(frameIndex);
+    slots[frameIndex].zoneNames.clear();
+    vkd.cmdResetQueryPool(cmd, queryPool, frameIndex * maxZones * 2, maxZones * 2);
+}
+
+uint32_t Profiler::beginGpuZone(VkCommandBuffer cmd, uint32_t nameId) {
+    if (queryPool == VK_NULL_HANDLE) return INVALID_ZONE;
+    GpuSlot &slot = slots[currentSlot];
+    if (slot.zoneNames.size() >= maxZones) return INVALID_ZONE;
+
+    uint32_t zone = static_cast<uint32_t>(slot.zoneNames.size());
+    slot.zoneNames.push_back(nameId);
+    vkd.cmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, queryPool,
+                         (currentSlot * maxZones + zone) * 2);
+    return zone;
+}
+
+void Profiler::endGpuZone(VkCommandBuffer cmd, uint32_t zone) {
+    if (zone == INVALID_ZONE) return;
+    vkd.cmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT, queryPool,
+                         (currentSlot * maxZones + zone) * 2 + 1);
+}
+
+void Profiler::collectSlot(uint32_t index) {
+    GpuSlot &slot = slots[index];
+    uint32_t zoneCount = static_cast<uint32_t>(slot.zoneNames.size());
+    if (zoneCount == 0) return;
+
+    // The slot's fence has signalled, so this never waits; anything still unavailable
+    // (a zone whose end wasn't recorded) just drops the frame
+    VkResult result = vkd.getQueryPoolResults(device, queryPool, index * maxZones * 2, zoneCount * 2,
+                                            zoneCount * 2 * sizeof(uint64_t), queryScratch.data(),
+                                            sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS) return;
+
+    uint64_t first = UINT64_MAX;
+    uint64_t last = 0;
+    for (uint32_t z = 0; z < zoneCount; ++z) {
+        first = std::min(first, queryScratch[z * 2] & timestampMask);
+        last = std::max(last, queryScratch[z * 2 + 1] & timestampMask);
+    }
+    if (last <= first) return;
+    pushWindow(gpuWindow, gpuNext, static_cast<double>(last - first) * timestampPeriod / 1e6);
+
+    // GPU and CPU clocks aren't calibrated against each other, so the trace places the
+    // frame's first timestamp at its submit time; durations within the frame are exact
+    if (gpuEvents.size() < GPU_EVENT_LIMIT) gpuEvents.resize(std::min<uint64_t>(GPU_EVENT_LIMIT, gpuEventCount + zoneCount));
+    for (uint32_t z = 0; z < zoneCount; ++z) {
+        uint64_t begin = queryScratch[z * 2] & timestampMask;
+        uint64_t end = queryScratch[z * 2 + 1] & timestampMask;
+        GpuEvent &ev = gpuEvents[gpuEventCount++ % GPU_EVENT_LIMIT];
+        ev.nameId = slot.zoneNames[z];
+        ev.start = slot.submitTime + static_cast<uint64_t>(static_cast<double>(begin - first) * timestampPeriod);
+        ev.duration = end > begin ? static_cast<uint64_t>(static_cast<double>(end - begin) * timestampPeriod) : 0;
+    }
+}
+
+void Profiler::endFrame() {
+    if (!active) return;
+    uint64_t t = now();
+    if (queryPool != VK_NULL_HANDLE) {
+        slots[currentSlot].submitTime = t;
+    }
+    uint64_t wait = frameWait.exchange(0, std::memory_order_relaxed);
+    if (lastFrameEnd != 0) {
+        uint64_t frame = t - lastFrameEnd;
+        pushWindow(frameWindow, frameNext, static_cast<double>(frame) / 1e6);
+        pushWindow(cpuWindow, cpuNext, static_cast<double>(frame > wait ? frame - wait : 0) / 1e6);
+    }
+    lastFrameEnd = t;
+}
+
+uint64_t Profiler::now() const {
+    return static_cast<uint64_t>(steadyNs() - epoch);
+}
+
+uint64_t Profiler::newInstanceId() {
+    return nextInstanceId.fetch_add(1, std::memory_order_relaxed);
+}
+
+Profiler::ThreadBuffer &Profiler::threadBuffer() {
+    if (tlsOwner != instanceId) {
+        auto buffer = std::make_unique<ThreadBuffer>();
+        buffer->events = std::make_unique<CpuEvent[]>(CPU_RING_SIZE);
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        buffer->threadId = static_cast<uint32_t>(threads.size());
+        tlsOwner = instanceId;
+        tlsBuffer = buffer.get();
+        threads.push_back(std::move(buffer));
+    }
+    return *static_cast<ThreadBuffer *>(tlsBuffer);
+}
+
+void Profiler::recordCpuZone(const char *name, uint64_t start, uint64_t end, bool wait) {
+    if (!active) return;
+    ThreadBuffer &buffer = threadBuffer();
+    // Single producer: only this thread advances head, the release publishes the event
+    uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    buffer.events[head % CPU_RING_SIZE] = {name, start, end};
+    buffer.head.store(head + 1, std::memory_order_release);
+
+    if (wait) frameWait.fetch_add(end - start, std::memory_order_relaxed);
+}
+
+void Profiler::pushWindow(std::vector<double> &window, uint32_t &next, double value) {
+    if (window.size() < WINDOW_SIZE) {
+        window.push_back(value);
+    } else {
+        window[next] = value;
+    }
+    next = (next + 1) % WINDOW_SIZE;
+}
+
+FrameTimePercentiles Profiler::percentiles(const std::vector<double> &samples) {
+    FrameTimePercentiles result;
+    if (samples.empty()) return result;
+    std::vector<double> sorted = samples;
+    std::sort(sorted.begin(), sorted.end());
+    auto at = [&](double p) { return sorted[static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5)]; };
+    result.p50 = at(0.50);
+    result.p95 = at(0.95);
+    result.p99 = at(0.99);
+    return result;
+}
+
+ProfilerSummary Profiler::summary() const {
+    ProfilerSummary s;
+    s.frames = static_cast<uint32_t>(frameWindow.size());
+    s.frame = percentiles(frameWindow);
+    s.cpu = percentiles(cpuWindow);
+    s.gpu = percentiles(gpuWindow);
+    return s;
+}
+
+std::vector<CpuZoneTotal> Profiler::cpuZoneTotals() const {
+    std::vector<CpuZoneTotal> totals;
+    std::unordered_map<std::string, size_t> index;
+    std::lock_guard<std::mutex> lock(threadsMutex);
+    for (const auto &buffer : threads) {
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        uint64_t begin = head > CPU_RING_SIZE ? head - CPU_RING_SIZE : 0;
+        for (uint64_t i = begin; i < head; ++i) {
+            const CpuEvent &ev = buffer->events[i % CPU_RING_SIZE];
+            auto [it, added] = index.emplace(ev.name, totals.size());
+            if (added) totals.push_back({ev.name});
+            totals[it->second].totalMs += static_cast<double>(ev.end - ev.start) / 1e6;
+            ++totals[it->second].count;
+        }
+    }
+    return totals;
+}
+
+bool Profiler::writeTrace(const std::string &path) const {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) return false;
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":0,\"args\":{\"name\":\"CPU\"}},\n";
+    out << "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":1,\"args\":{\"name\":\"GPU (graphics queue)\"}}";
+
+    std::lock_guard<std::mutex> lock(threadsMutex);
+    for (const auto &buffer : threads) {
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        uint64_t begin = head > CPU_RING_SIZE ? head - CPU_RING_SIZE : 0;
+        for (uint64_t i = begin; i < head; ++i) {
+            const CpuEvent &ev = buffer->events[i % CPU_RING_SIZE];
+            out << ",\n{\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->threadId << ",\"name\":";
+            writeJsonString(out, ev.name);
+            out << ",\"ts\":" << toUs(ev.start) << ",\"dur\":" << toUs(ev.end - ev.start) << "}";
+        }
+    }
+
+    uint64_t gpuBegin = gpuEventCount > GPU_EVENT_LIMIT ? gpuEventCount - GPU_EVENT_LIMIT : 0;
+    for (uint64_t i = gpuBegin; i < gpuEventCount; ++i) {
+        const GpuEvent &ev = gpuEvents[i % GPU_EVENT_LIMIT];
+        out << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":0,\"name\":";
+        writeJsonString(out, names[ev.nameId].c_str());
+        out << ",\"ts\":" << toUs(ev.start) << ",\"dur\":" << toUs(ev.duration) << "}";
+    }
+
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct FrameTimePercentiles {
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+};
+
+// Over the most recent frames, in milliseconds. cpu is the frame time minus time spent in
+// wait zones (fences, acquire), so cpu close to frame means CPU-bound and gpu close to frame
+// means GPU-bound.
+struct ProfilerSummary {
+    uint32_t frames = 0;
+    FrameTimePercentiles frame;
+    FrameTimePercentiles cpu;
+    FrameTimePercentiles gpu;
+};
+
+// Time spent in every zone of one name, across threads
+struct CpuZoneTotal {
+    std::string name;
+    double totalMs = 0.0;
+    uint32_t count = 0;
+};
+
+// CPU zones plus GPU timestamp queries, exported as a Chrome trace (chrome://tracing or
+// ui.perfetto.dev).
+//
+// CPU zones go into a per-thread ring that only its own thread writes, so recording takes
+// no lock; a thread's first zone registers its ring under a mutex. GPU zones write
+// timestamps into a query range owned by the frame slot. The range is read back when the
+// slot comes around again, after its fence has signalled, so results are framesInFlight
+// frames late but reading them never stalls.
+//
+// Everything is a no-op until setEnabled(true), which must happen before other threads
+// record zones.
+class Profiler {
+public:
+    static constexpr uint32_t INVALID_ZONE = UINT32_MAX;
+
+    void setEnabled(bool on);
+    bool enabled() const { return active; }
+
+    // GPU timestamps are skipped if the queue family has no valid timestamp bits
+    void initGpu(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily, uint32_t frameCount,
+                 uint32_t maxZonesPerFrame = 64);
+    void destroy();
+
+    // Stable id for a GPU zone name; call at setup time, not per frame
+    uint32_t internName(const std::string &name);
+
+    // Collects the results the slot recorded last time round and resets its queries. Must be
+    // recorded outside any rendering, after the slot's fence has been waited on.
+    void beginFrame(VkCommandBuffer cmd, uint32_t frameIndex);
+    uint32_t beginGpuZone(VkCommandBuffer cmd, uint32_t nameId);
+    void endGpuZone(VkCommandBuffer cmd, uint32_t zone);
+    // Call right after the frame's submit; closes the CPU frame interval
+    void endFrame();
+
+    // Nanoseconds since setEnabled(true)
+    uint64_t now() const;
+    void recordCpuZone(const char *name, uint64_t start, uint64_t end, bool wait);
+
+    ProfilerSummary summary() const;
+    // Over the events still in the CPU rings, in order of first appearance. Producers must be
+    // idle, as for writeTrace().
+    std::vector<CpuZoneTotal> cpuZoneTotals() const;
+    // Producers must be idle (e.g. after vkDeviceWaitIdle and with no jobs running)
+    bool writeTrace(const std::string &path) const;
+
+    // Nearest-rank percentiles of samples
+    static FrameTimePercentiles percentiles(const std::vector<double> &samples);
+
+private:
+    struct CpuEvent {
+        const char *name;
+        uint64_t start;
+        uint64_t end;
+    };
+
+    struct ThreadBuffer {
+        std::unique_ptr<CpuEvent[]> events;
+        // Total events written; the ring holds the last CPU_RING_SIZE of them
+        std::atomic<uint64_t> head{0};
+        uint32_t threadId = 0;
+    };
+
+    struct GpuEvent {
+        uint32_t nameId;
+        uint64_t start;
+        uint64_t duration;
+    };
+
+    struct GpuSlot {
+        std::vector<uint32_t> zoneNames;
+        uint64_t submitTime = 0;
+    };
+
+    static constexpr uint32_t CPU_RING_SIZE = 1u << 16;
+    static constexpr uint32_t GPU_EVENT_LIMIT = 1u << 16;
+    static constexpr uint32_t WINDOW_SIZE = 512;
+
+    ThreadBuffer &threadBuffer();
+    static uint64_t newInstanceId();
+    void collectSlot(uint32_t slot);
+    static void pushWindow(std::vector<double> &window, uint32_t &next, double value);
+
+    bool active = false;
+    int64_t epoch = 0;
+
+    // Identifies this profiler to the thread-local buffer cache; unlike the address it is never
+    // reused by a later profiler
+    const uint64_t instanceId = newInstanceId();
+    mutable std::mutex threadsMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> threads;
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkQueryPool queryPool = VK_NULL_HANDLE;
+    double timestampPeriod = 0.0;
+    uint64_t timestampMask = 0;
+    uint32_t maxZones = 0;
+    uint32_t currentSlot = 0;
+    std::vector<GpuSlot> slots;
+    std::vector<uint64_t> queryScratch;
+    std::vector<std::string> names;
+    std::unordered_map<std::string, uint32_t> nameIds;
+    // Ring of the last GPU_EVENT_LIMIT zones for the trace
+    std::vector<GpuEvent> gpuEvents;
+    uint64_t gpuEventCount = 0;
+
+    uint64_t lastFrameEnd = 0;
+    std::atomic<uint64_t> frameWait{0};
+    std::vector<double> frameWindow, cpuWindow, gpuWindow;
+    uint32_t frameNext = 0, cpuNext = 0, gpuNext = 0;
+};
+
+// Times the enclosing scope as a CPU zone. name must outlive the profiler (a literal).
+// Wait zones count as idle time in the frame summary.
+class ProfileZone {
+public:
+    ProfileZone(Profiler &profiler, const char *name, bool wait = false)
+        : profiler(profiler), name(name), wait(wait), start(profiler.enabled() ? profiler.now() : 0) {}
+    ~ProfileZone() {
+        if (profiler.enabled()) profiler.recordCpuZone(name, start, profiler.now(), wait);
+    }
+    ProfileZone(const ProfileZone &) = delete;
+    ProfileZone &operator=(const ProfileZone &) = delete;
+
+private:
+    Profiler &profiler;
+    const char *name;
+    bool wait;
+    uint64_t start;
+};
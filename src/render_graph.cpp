@@ -0,0 +1,798 @@
+#include "render_graph.hpp"
+
+#include "vk_dispatch.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+struct UsageInfo {
+    VkPipelineStageFlags2 stages;
+    VkAccessFlags2 readAccess;
+    VkAccessFlags2 writeAccess;
+    VkImageLayout layout;
+    VkImageUsageFlags imageUsage;
+};
+
+UsageInfo usageInfo(RGUsage usage) {
+    switch (usage) {
+    case RGUsage::ColorAttachment:
+        return {VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT,
+                VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT};
+    case RGUsage::DepthAttachment:
+        return {VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+                VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT};
+    case RGUsage::DepthRead:
+        return {VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+                VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT, VK_ACCESS_2_NONE,
+                VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT};
+    case RGUsage::SampledFragment:
+        return {VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_ACCESS_2_NONE,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT};
+    case RGUsage::SampledCompute:
+        return {VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_ACCESS_2_NONE,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT};
+    case RGUsage::StorageReadCompute:
+        return {VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT, VK_ACCESS_2_NONE,
+                VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT};
+    case RGUsage::StorageWriteCompute:
+        return {VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_NONE, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT};
+    case RGUsage::StorageReadWriteCompute:
+        return {VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+                VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT};
+    case RGUsage::IndirectRead:
+        return {VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT, VK_ACCESS_2_NONE,
+                VK_IMAGE_LAYOUT_UNDEFINED, 0};
+    case RGUsage::VertexRead:
+        return {VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT,
+                VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_2_INDEX_READ_BIT, VK_ACCESS_2_NONE,
+                VK_IMAGE_LAYOUT_UNDEFINED, 0};
+    case RGUsage::UniformRead:
+        return {VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT |
+                    VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_UNIFORM_READ_BIT, VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_UNDEFINED, 0};
+    case RGUsage::TransferSrc:
+        return {VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT, VK_ACCESS_2_NONE,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT};
+    case RGUsage::TransferDst:
+        return {VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, VK_ACCESS_2_NONE, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT};
+    }
+    throw std::runtime_error("Unknown render graph usage!");
+}
+
+bool isDepthFormat(VkFormat format) {
+    return format == VK_FORMAT_D16_UNORM || format == VK_FORMAT_D32_SFLOAT ||
+           format == VK_FORMAT_D24_UNORM_S8_UINT || format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+}
+
+bool hasStencil(VkFormat format) {
+    return format == VK_FORMAT_D24_UNORM_S8_UINT || format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+}
+
+} // namespace
+
+RenderGraph::PassBuilder &RenderGraph::PassBuilder::writeColor(RGHandle res, VkAttachmentLoadOp loadOp, VkClearColorValue clear) {
+    Attachment att;
+    att.res = res;
+    att.loadOp = loadOp;
+    att.clear.color = clear;
+    graph.passes[pass].colors.push_back(att);
+    graph.addAccess(pass, res, RGUsage::ColorAttachment, loadOp == VK_ATTACHMENT_LOAD_OP_LOAD, true);
+    return *this;
+}
+
+RenderGraph::PassBuilder &RenderGraph::PassBuilder::writeDepth(RGHandle res, VkAttachmentLoadOp loadOp, float clearDepth) {
+    Attachment &att = graph.passes[pass].depth;
+    att.res = res;
+    att.loadOp = loadOp;
+    att.clear.depthStencil = {clearDepth, 0};
+    graph.addAccess(pass, res, RGUsage::DepthAttachment, loadOp == VK_ATTACHMENT_LOAD_OP_LOAD, true);
+    return *this;
+}
+
+RenderGraph::PassBuilder &RenderGraph::PassBuilder::read(RGHandle res, RGUsage usage) {
+    graph.addAccess(pass, res, usage, true, false);
+    return *this;
+}
+
+RenderGraph::PassBuilder &RenderGraph::PassBuilder::write(RGHandle res, RGUsage usage) {
+    // Storage read-write keeps the previous contents, everything else overwrites them
+    graph.addAccess(pass, res, usage, usage == RGUsage::StorageReadWriteCompute, true);
+    return *this;
+}
+
+RenderGraph::PassBuilder &RenderGraph::PassBuilder::sideEffect() {
+    graph.passes[pass].sideEffect = true;
+    return *this;
+}
+
+RenderGraph::PassBuilder &RenderGraph::PassBuilder::asyncCompute() {
+    graph.passes[pass].async = true;
+    return *this;
+}
+
+void RenderGraph::init(GpuAllocator &alloc) {
+    allocator = &alloc;
+    device = alloc.getDevice();
+}
+
+void RenderGraph::destroy() {
+    for (auto &res : resources) {
+        if (res.imported) continue;
+        for (VkImageView view : res.views) {
+            if (view != VK_NULL_HANDLE) vkDestroyImageView(device, view, nullptr);
+        }
+        for (VkImage image : res.images) {
+            if (image != VK_NULL_HANDLE) vkDestroyImage(device, image, nullptr);
+        }
+        res.views.clear();
+        res.images.clear();
+        res.view = VK_NULL_HANDLE;
+        res.image = VK_NULL_HANDLE;
+    }
+    for (auto &slot : slots) {
+        for (GpuAllocation &allocation : slot.allocations) allocator->free(allocation);
+    }
+    slots.clear();
+    resources.clear();
+    passes.clear();
+    segments.clear();
+    finalBarriers.clear();
+    compiled = false;
+}
+
+RGHandle RenderGraph::importImage(const std::string &name, VkImage image, VkImageView view, VkFormat format,
+                                  VkExtent2D extent, const RGState &initial, const RGState &final) {
+    Resource res;
+    res.name = name;
+    res.imported = true;
+    res.desc.format = format;
+    res.desc.extent = extent;
+    res.aspect = isDepthFormat(format) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+    res.image = image;
+    res.view = view;
+    res.initial = initial;
+    res.final = final;
+    resources.push_back(res);
+    return static_cast<RGHandle>(resources.size() - 1);
+}
+
+RGHandle RenderGraph::importBuffer(const std::string &name, VkBuffer buffer, VkDeviceSize size,
+                                   const RGState &initial, const RGState &final) {
+    Resource res;
+    res.name = name;
+    res.isImage = false;
+    res.imported = true;
+    res.buffer = buffer;
+    res.size = size;
+    res.initial = initial;
+    res.final = final;
+    resources.push_back(res);
+    return static_cast<RGHandle>(resources.size() - 1);
+}
+
+RGHandle RenderGraph::createTexture(const std::string &name, const RGTextureDesc &desc) {
+    Resource res;
+    res.name = name;
+    res.desc = desc;
+    if (isDepthFormat(desc.format)) {
+        res.aspect = VK_IMAGE_ASPECT_DEPTH_BIT | (hasStencil(desc.format) ? VK_IMAGE_ASPECT_STENCIL_BIT : 0);
+    }
+    resources.push_back(res);
+    return static_cast<RGHandle>(resources.size() - 1);
+}
+
+void RenderGraph::setQueueFamilies(uint32_t graphics, uint32_t compute) {
+    graphicsFamily = graphics;
+    computeFamily = compute;
+}
+
+void RenderGraph::setFrameCount(uint32_t count) {
+    if (compiled) {
+        throw std::runtime_error("Render graph is already compiled!");
+    }
+    frames = std::max(count, 1u);
+}
+
+void RenderGraph::setFrameSlot(uint32_t slot) {
+    frameSlot = slot;
+    for (Resource &res : resources) {
+        if (res.imported || res.images.empty()) continue;
+        res.image = res.images[slot % res.copies];
+        res.view = res.views[slot % res.copies];
+    }
+}
+
+void RenderGraph::setImportedImage(RGHandle res, VkImage image, VkImageView view) {
+    resources[res].image = image;
+    resources[res].view = view;
+}
+
+void RenderGraph::setImportedBuffer(RGHandle res, VkBuffer buffer) {
+    resources[res].buffer = buffer;
+}
+
+uint32_t RenderGraph::addPass(const std::string &name, const std::function<void(PassBuilder &)> &setup, ExecuteFn execute) {
+    if (compiled) {
+        throw std::runtime_error("Render graph is already compiled!");
+    }
+    Pass pass;
+    pass.name = name;
+    pass.execute = std::move(execute);
+    passes.push_back(std::move(pass));
+
+    uint32_t index = static_cast<uint32_t>(passes.size() - 1);
+    PassBuilder builder(*this, index);
+    setup(builder);
+    return index;
+}
+
+void RenderGraph::addAccess(uint32_t pass, RGHandle res, RGUsage usage, bool read, bool write) {
+    if (res >= resources.size()) {
+        throw std::runtime_error("Render graph pass " + passes[pass].name + " uses an unknown resource!");
+    }
+    passes[pass].accesses.push_back({res, usage, read, write});
+}
+
+void RenderGraph::setSecondaryContents(uint32_t pass, bool secondary) {
+    passes[pass].secondary = secondary;
+}
+
+const VkCommandBufferInheritanceRenderingInfo &RenderGraph::renderingInheritance(uint32_t pass) const {
+    return passes[pass].inheritance;
+}
+
+VkImage RenderGraph::image(RGHandle res) const { return resources[res].image; }
+VkImageView RenderGraph::view(RGHandle res) const { return resources[res].view; }
+VkImageView RenderGraph::view(RGHandle res, uint32_t slot) const {
+    const Resource &r = resources[res];
+    return r.imported || r.views.empty() ? r.view : r.views[slot % r.copies];
+}
+VkBuffer RenderGraph::buffer(RGHandle res) const { return resources[res].buffer; }
+bool RenderGraph::isCulled(uint32_t pass) const { return passes[pass].culled; }
+
+uint32_t RenderGraph::firstSegment(RGHandle res) const {
+    uint32_t first = resources[res].firstUse;
+    return first != UINT32_MAX ? passes[first].segment : 0;
+}
+
+// Walks passes back to front keeping the set of resources whose current contents are still
+// needed. Imported resources are needed at the end; a pass survives if it has side effects or
+// writes something needed, and then its reads become needed in turn. A pure overwrite ends
+// the need, so earlier writers of the same resource can still be dropped.
+void RenderGraph::cullPasses() {
+    std::vector<bool> needed(resources.size(), false);
+    for (size_t i = 0; i < resources.size(); ++i) {
+        needed[i] = resources[i].imported;
+    }
+
+    for (size_t p = passes.size(); p-- > 0;) {
+        Pass &pass = passes[p];
+        bool live = pass.sideEffect;
+        for (const Access &a : pass.accesses) {
+            if (a.write && needed[a.res]) live = true;
+        }
+        pass.culled = !live;
+        if (!live) continue;
+
+        for (const Access &a : pass.accesses) {
+            if (a.write && !a.read) needed[a.res] = false;
+        }
+        for (const Access &a : pass.accesses) {
+            if (a.read) needed[a.res] = true;
+        }
+    }
+}
+
+// Starts a new segment at every queue switch between live passes. Async passes stay on the
+// graphics queue unless there is a separate compute family; either way they are checked, so a
+// graph that works on one device works on all of them.
+void RenderGraph::assignSegments() {
+    bool asyncQueue = computeFamily != VK_QUEUE_FAMILY_IGNORED && computeFamily != graphicsFamily;
+    segments.clear();
+    segments.push_back(Segment{});
+    for (uint32_t p = 0; p < passes.size(); ++p) {
+        Pass &pass = passes[p];
+        if (pass.culled) continue;
+        if (pass.async) {
+            if (!pass.colors.empty() || pass.depth.res != RG_INVALID) {
+                throw std::runtime_error("Render graph pass " + pass.name + " renders and can't run on the compute queue!");
+            }
+            for (const Access &a : pass.accesses) {
+                if (resources[a.res].imported) {
+                    throw std::runtime_error("Async compute pass " + pass.name + " uses imported resource " +
+                                             resources[a.res].name + "!");
+                }
+            }
+        }
+
+        // Segment 0 stays on the graphics queue even if the first live pass is async
+        bool async = pass.async && asyncQueue;
+        if (async) ++graphStats.asyncPasses;
+        if (segments.back().async != async) {
+            Segment next;
+            next.async = async;
+            next.firstPass = p;
+            next.waits.push_back({static_cast<uint32_t>(segments.size() - 1), false, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT});
+            segments.push_back(std::move(next));
+        }
+        pass.segment = static_cast<uint32_t>(segments.size() - 1);
+        segments.back().endPass = p + 1;
+    }
+    if (segments.back().async) {
+        throw std::runtime_error("Render graph must end with a pass on the graphics queue!");
+    }
+    graphStats.segmentCount = static_cast<uint32_t>(segments.size());
+}
+
+void RenderGraph::addSegmentWait(uint32_t segment, const RGSegmentWait &wait) {
+    for (RGSegmentWait &w : segments[segment].waits) {
+        if (w.segment == wait.segment && w.previousExecution == wait.previousExecution) {
+            w.stages |= wait.stages;
+            return;
+        }
+    }
+    segments[segment].waits.push_back(wait);
+}
+
+// Greedy interval packing: biggest transients first, each into the first slot whose occupants'
+// lifetimes are all disjoint from its own and whose memory types are compatible.
+void RenderGraph::allocateTransients() {
+    std::vector<RGHandle> transients;
+    std::vector<VkMemoryRequirements> reqs(resources.size());
+    for (RGHandle h = 0; h < resources.size(); ++h) {
+        Resource &res = resources[h];
+        if (res.imported || res.firstUse == UINT32_MAX) continue;
+        res.copies = res.asyncUse ? frames : 1;
+
+        VkImageCreateInfo info{};
+        info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        info.imageType = VK_IMAGE_TYPE_2D;
+        info.format = res.desc.format;
+        info.extent = {res.desc.extent.width, res.desc.extent.height, 1};
+        info.mipLevels = 1;
+        info.arrayLayers = 1;
+        info.samples = res.desc.samples;
+        info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        info.usage = res.usage;
+        info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        res.images.assign(res.copies, VK_NULL_HANDLE);
+        res.views.assign(res.copies, VK_NULL_HANDLE);
+        for (VkImage &image : res.images) {
+            if (vkCreateImage(device, &info, nullptr, &image) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create transient image " + res.name + "!");
+            }
+        }
+        // Copies share a create-info, so their requirements match
+        vkGetImageMemoryRequirements(device, res.images[0], &reqs[h]);
+        graphStats.transientBytesUnaliased += reqs[h].size * res.copies;
+        transients.push_back(h);
+    }
+
+    std::sort(transients.begin(), transients.end(), [&](RGHandle a, RGHandle b) {
+        return reqs[a].size > reqs[b].size;
+    });
+
+    for (RGHandle h : transients) {
+        Resource &res = resources[h];
+        for (uint32_t s = 0; s < slots.size() && res.slot == UINT32_MAX; ++s) {
+            MemorySlot &slot = slots[s];
+            if (slot.copies != res.copies || (slot.reqs.memoryTypeBits & reqs[h].memoryTypeBits) == 0) continue;
+            bool overlaps = std::any_of(slot.occupants.begin(), slot.occupants.end(), [&](RGHandle o) {
+                return resources[o].firstUse <= res.lastUse && res.firstUse <= resources[o].lastUse;
+            });
+            if (overlaps) continue;
+
+            slot.reqs.size = std::max(slot.reqs.size, reqs[h].size);
+            slot.reqs.alignment = std::max(slot.reqs.alignment, reqs[h].alignment);
+            slot.reqs.memoryTypeBits &= reqs[h].memoryTypeBits;
+            slot.occupants.push_back(h);
+            res.slot = s;
+        }
+        if (res.slot == UINT32_MAX) {
+            MemorySlot slot;
+            slot.reqs = reqs[h];
+            slot.copies = res.copies;
+            slot.occupants.push_back(h);
+            res.slot = static_cast<uint32_t>(slots.size());
+            slots.push_back(std::move(slot));
+        }
+    }
+
+    for (MemorySlot &slot : slots) {
+        for (uint32_t c = 0; c < slot.copies; ++c) {
+            slot.allocations.push_back(allocator->allocate(slot.reqs, MemoryUsage::GpuOnly, false));
+        }
+        graphStats.transientBytes += slot.reqs.size * slot.copies;
+        // Occupants in execution order, which buildBarriers() relies on
+        std::sort(slot.occupants.begin(), slot.occupants.end(), [&](RGHandle a, RGHandle b) {
+            return resources[a].firstUse < resources[b].firstUse;
+        });
+
+        for (RGHandle h : slot.occupants) {
+            Resource &res = resources[h];
+            for (uint32_t c = 0; c < res.copies; ++c) {
+                const GpuAllocation &allocation = slot.allocations[c];
+                if (vkBindImageMemory(device, res.images[c], allocation.memory, allocation.offset) != VK_SUCCESS) {
+                    throw std::runtime_error("Failed to bind transient image " + res.name + "!");
+                }
+
+                VkImageViewCreateInfo viewInfo{};
+                viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+                viewInfo.image = res.images[c];
+                viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+                viewInfo.format = res.desc.format;
+                viewInfo.subresourceRange.aspectMask = res.aspect;
+                viewInfo.subresourceRange.levelCount = 1;
+                viewInfo.subresourceRange.layerCount = 1;
+                if (vkCreateImageView(device, &viewInfo, nullptr, &res.views[c]) != VK_SUCCESS) {
+                    throw std::runtime_error("Failed to create transient image view " + res.name + "!");
+                }
+            }
+        }
+    }
+    setFrameSlot(frameSlot);
+}
+
+// Replays every live pass against a per-resource state and only emits a barrier when there is
+// a hazard: a write after anything, a read of data not yet visible to that stage, or a layout
+// change. Reads that follow an already-covered read need nothing.
+void RenderGraph::buildBarriers() {
+    struct Track {
+        VkImageLayout layout;
+        VkPipelineStageFlags2 writeStages;
+        VkAccessFlags2 writeAccess;
+        // Stages that read since the last write; a following write must wait for them
+        VkPipelineStageFlags2 readStages;
+        // What the last write has already been made visible to
+        VkPipelineStageFlags2 visibleStages;
+        VkAccessFlags2 visibleAccess;
+        // Segment of the last use; UINT32_MAX before the first
+        uint32_t segment;
+    };
+
+    std::vector<Track> track(resources.size());
+    for (RGHandle h = 0; h < resources.size(); ++h) {
+        const Resource &res = resources[h];
+        // Imports chain onto whatever produced them (e.g. the acquire semaphore's wait stage)
+        track[h] = {res.imported ? res.initial.layout : VK_IMAGE_LAYOUT_UNDEFINED,
+                    res.imported ? res.initial.stages : VK_PIPELINE_STAGE_2_NONE,
+                    res.imported ? res.initial.access : VK_ACCESS_2_NONE,
+                    VK_PIPELINE_STAGE_2_NONE, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE,
+                    res.imported ? 0u : UINT32_MAX};
+    }
+    auto familyOf = [&](uint32_t segment) { return segments[segment].async ? computeFamily : graphicsFamily; };
+
+    // The first barrier of every transient, patched below once the previous occupant of its
+    // memory is known
+    std::vector<std::pair<uint32_t, size_t>> firstBarrier(resources.size(), {UINT32_MAX, 0});
+
+    for (uint32_t p = 0; p < passes.size(); ++p) {
+        Pass &pass = passes[p];
+        pass.barriers.clear();
+        if (pass.culled) continue;
+
+        // Merge repeated accesses to one resource within the pass
+        struct Merged {
+            RGHandle res;
+            VkPipelineStageFlags2 stages = 0;
+            VkAccessFlags2 readAccess = 0;
+            VkAccessFlags2 writeAccess = 0;
+            VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            bool write = false;
+        };
+        std::vector<Merged> merged;
+        for (const Access &a : pass.accesses) {
+            UsageInfo info = usageInfo(a.usage);
+            auto it = std::find_if(merged.begin(), merged.end(), [&](const Merged &m) { return m.res == a.res; });
+            if (it == merged.end()) {
+                merged.push_back({a.res});
+                it = merged.end() - 1;
+                it->layout = info.layout;
+            } else if (resources[a.res].isImage && it->layout != info.layout) {
+                throw std::runtime_error("Render graph pass " + pass.name + " uses " + resources[a.res].name +
+                                         " in two different layouts!");
+            }
+            it->stages |= info.stages;
+            it->readAccess |= info.readAccess;
+            if (a.write) {
+                it->writeAccess |= info.writeAccess;
+                it->write = true;
+            }
+        }
+
+        for (const Merged &m : merged) {
+            const Resource &res = resources[m.res];
+            Track &t = track[m.res];
+            VkImageLayout layout = res.isImage ? m.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+            bool layoutChange = res.isImage && t.layout != layout;
+            VkAccessFlags2 dstAccess = m.readAccess | m.writeAccess;
+
+            bool isFirstTransientUse = !res.imported && firstBarrier[m.res].first == UINT32_MAX;
+            if (t.segment != UINT32_MAX && segments[t.segment].async != segments[pass.segment].async) {
+                // Ownership transfer: released after the last use on the other queue, acquired
+                // here. The semaphore between the segments orders the two halves.
+                uint32_t srcFamily = familyOf(t.segment);
+                uint32_t dstFamily = familyOf(pass.segment);
+                segments[t.segment].releases.push_back({m.res, t.writeStages | t.readStages, t.writeAccess,
+                                                        VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, t.layout, layout,
+                                                        srcFamily, dstFamily});
+                pass.barriers.push_back({m.res, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, m.stages, dstAccess,
+                                         t.layout, layout, srcFamily, dstFamily});
+                ++graphStats.queueTransfers;
+                // Later uses on this queue chain onto the acquire like onto a write
+                t.writeStages = m.stages;
+                t.writeAccess = m.write ? m.writeAccess : m.readAccess;
+                t.readStages = VK_PIPELINE_STAGE_2_NONE;
+                t.visibleStages = m.stages;
+                t.visibleAccess = dstAccess;
+                t.layout = layout;
+                t.segment = pass.segment;
+                continue;
+            }
+            t.segment = pass.segment;
+            if (m.write || layoutChange) {
+                VkPipelineStageFlags2 src = t.writeStages | t.readStages;
+                if (src != VK_PIPELINE_STAGE_2_NONE || layoutChange || isFirstTransientUse) {
+                    pass.barriers.push_back({m.res, src, t.writeAccess, m.stages, dstAccess, t.layout, layout});
+                    if (isFirstTransientUse) firstBarrier[m.res] = {p, pass.barriers.size() - 1};
+                }
+                if (m.write) {
+                    t.writeStages = m.stages;
+                    t.writeAccess = m.writeAccess;
+                    t.readStages = VK_PIPELINE_STAGE_2_NONE;
+                } else {
+                    // A read-only transition. The transition itself is a write that only these
+                    // stages wait for, so reads at other stages still need an execution dependency
+                    t.writeStages = m.stages;
+                    t.writeAccess = VK_ACCESS_2_NONE;
+                    t.readStages = m.stages;
+                }
+                t.visibleStages = m.stages;
+                t.visibleAccess = dstAccess;
+                t.layout = layout;
+            } else {
+                bool covered = (m.stages & ~t.visibleStages) == 0 && (m.readAccess & ~t.visibleAccess) == 0;
+                bool written = t.writeStages != VK_PIPELINE_STAGE_2_NONE || t.writeAccess != VK_ACCESS_2_NONE;
+                if (written && !covered) {
+                    pass.barriers.push_back({m.res, t.writeStages, t.writeAccess, m.stages, m.readAccess, t.layout, t.layout});
+                    t.visibleStages |= m.stages;
+                    t.visibleAccess |= m.readAccess;
+                }
+                t.readStages |= m.stages;
+            }
+        }
+    }
+
+    // A transient's first use has to wait for the last use of the previous occupant of its
+    // memory. The first occupant of a slot waits for the last one of the previous execution.
+    for (const MemorySlot &slot : slots) {
+        for (size_t i = 0; i < slot.occupants.size(); ++i) {
+            RGHandle h = slot.occupants[i];
+            RGHandle prev = slot.occupants[(i + slot.occupants.size() - 1) % slot.occupants.size()];
+            auto [p, b] = firstBarrier[h];
+            if (p == UINT32_MAX) continue;
+            Barrier &barrier = passes[p].barriers[b];
+            barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            uint32_t prevSegment = track[prev].segment;
+            if (prevSegment != UINT32_MAX && segments[prevSegment].async != segments[passes[p].segment].async) {
+                // The contents are discarded, so no ownership transfer; a semaphore orders the
+                // other queue's use, which for the first occupant is in the previous execution
+                barrier.srcStages = VK_PIPELINE_STAGE_2_NONE;
+                barrier.srcAccess = VK_ACCESS_2_NONE;
+                // With a copy per frame slot, that execution is the slot's previous one, which
+                // the fence the caller waited on already covers
+                if (i == 0 && slot.copies == 1) {
+                    addSegmentWait(passes[p].segment, {prevSegment, true, barrier.dstStages});
+                }
+                continue;
+            }
+            barrier.srcStages = track[prev].writeStages | track[prev].readStages;
+            barrier.srcAccess = track[prev].writeAccess;
+        }
+    }
+
+    finalBarriers.clear();
+    for (RGHandle h = 0; h < resources.size(); ++h) {
+        const Resource &res = resources[h];
+        if (!res.imported) continue;
+        const Track &t = track[h];
+        VkImageLayout finalLayout = res.final.layout != VK_IMAGE_LAYOUT_UNDEFINED ? res.final.layout : t.layout;
+        bool layoutChange = res.isImage && finalLayout != t.layout;
+        if (!layoutChange && res.final.stages == VK_PIPELINE_STAGE_2_NONE) continue;
+        finalBarriers.push_back({h, t.writeStages | t.readStages, t.writeAccess,
+                                 res.final.stages, res.final.access, t.layout, finalLayout});
+    }
+
+    graphStats.barrierCount = static_cast<uint32_t>(finalBarriers.size());
+    for (const Pass &pass : passes) {
+        graphStats.barrierCount += static_cast<uint32_t>(pass.barriers.size());
+    }
+    for (const Segment &segment : segments) {
+        graphStats.barrierCount += static_cast<uint32_t>(segment.releases.size());
+    }
+}
+
+void RenderGraph::compile() {
+    graphStats = RenderGraphStats{};
+    graphStats.passCount = static_cast<uint32_t>(passes.size());
+
+    cullPasses();
+    assignSegments();
+
+    for (uint32_t p = 0; p < passes.size(); ++p) {
+        Pass &pass = passes[p];
+        if (pass.culled) {
+            ++graphStats.culledPasses;
+            continue;
+        }
+        for (const Access &a : pass.accesses) {
+            Resource &res = resources[a.res];
+            res.firstUse = std::min(res.firstUse, p);
+            res.lastUse = std::max(res.lastUse, p);
+            if (segments[pass.segment].async) res.asyncUse = true;
+            res.usage |= usageInfo(a.usage).imageUsage;
+        }
+    }
+
+    allocateTransients();
+    buildBarriers();
+
+    for (Pass &pass : passes) {
+        if (profiler) pass.profileName = profiler->internName(pass.name);
+        pass.colorFormats.clear();
+        for (const Attachment &att : pass.colors) {
+            pass.colorFormats.push_back(resources[att.res].desc.format);
+        }
+        RGHandle first = !pass.colors.empty() ? pass.colors[0].res : pass.depth.res;
+
+        pass.inheritance = VkCommandBufferInheritanceRenderingInfo{};
+        pass.inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+        pass.inheritance.colorAttachmentCount = static_cast<uint32_t>(pass.colorFormats.size());
+        pass.inheritance.pColorAttachmentFormats = pass.colorFormats.data();
+        pass.inheritance.depthAttachmentFormat =
+            pass.depth.res != RG_INVALID ? resources[pass.depth.res].desc.format : VK_FORMAT_UNDEFINED;
+        pass.inheritance.rasterizationSamples =
+            first != RG_INVALID ? resources[first].desc.samples : VK_SAMPLE_COUNT_1_BIT;
+    }
+
+    compiled = true;
+}
+
+void RenderGraph::emitBarriers(VkCommandBuffer cmd, const std::vector<Barrier> &barriers) {
+    if (barriers.empty()) return;
+
+    imageScratch.clear();
+    bufferScratch.clear();
+    for (const Barrier &b : barriers) {
+        const Resource &res = resources[b.res];
+        if (res.isImage) {
+            VkImageMemoryBarrier2 barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+            barrier.srcStageMask = b.srcStages;
+            barrier.srcAccessMask = b.srcAccess;
+            barrier.dstStageMask = b.dstStages;
+            barrier.dstAccessMask = b.dstAccess;
+            barrier.oldLayout = b.oldLayout;
+            barrier.newLayout = b.newLayout;
+            barrier.srcQueueFamilyIndex = b.srcFamily;
+            barrier.dstQueueFamilyIndex = b.dstFamily;
+            barrier.image = res.image;
+            barrier.subresourceRange.aspectMask = res.aspect;
+            barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+            barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+            imageScratch.push_back(barrier);
+        } else {
+            VkBufferMemoryBarrier2 barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+            barrier.srcStageMask = b.srcStages;
+            barrier.srcAccessMask = b.srcAccess;
+            barrier.dstStageMask = b.dstStages;
+            barrier.dstAccessMask = b.dstAccess;
+            barrier.srcQueueFamilyIndex = b.srcFamily;
+            barrier.dstQueueFamilyIndex = b.dstFamily;
+            barrier.buffer = res.buffer;
+            barrier.offset = 0;
+            barrier.size = VK_WHOLE_SIZE;
+            bufferScratch.push_back(barrier);
+        }
+    }
+
+    VkDependencyInfo dep{};
+    dep.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    dep.bufferMemoryBarrierCount = static_cast<uint32_t>(bufferScratch.size());
+    dep.pBufferMemoryBarriers = bufferScratch.data();
+    dep.imageMemoryBarrierCount = static_cast<uint32_t>(imageScratch.size());
+    dep.pImageMemoryBarriers = imageScratch.data();
+    vkd.cmdPipelineBarrier2(cmd, &dep);
+}
+
+void RenderGraph::execute(VkCommandBuffer cmd) {
+    if (compiled && segments.size() > 1) {
+        throw std::runtime_error("Render graph has async compute segments; record them with executeSegment()!");
+    }
+    executeSegment(0, cmd);
+}
+
+void RenderGraph::executeSegment(uint32_t segment, VkCommandBuffer cmd) {
+    if (!compiled) {
+        throw std::runtime_error("Render graph executed before compile()!");
+    }
+
+    const Segment &seg = segments[segment];
+    // The profiler's queries belong to the graphics queue
+    Profiler *zones = seg.async ? nullptr : profiler;
+    VkRenderingAttachmentInfo colorInfos[8];
+    for (uint32_t p = seg.firstPass; p < seg.endPass; ++p) {
+        Pass &pass = passes[p];
+        if (pass.culled) continue;
+        uint32_t zone = zones ? zones->beginGpuZone(cmd, pass.profileName) : Profiler::INVALID_ZONE;
+        emitBarriers(cmd, pass.barriers);
+
+        RGPassContext ctx;
+        ctx.cmd = cmd;
+        ctx.graph = this;
+        ctx.pass = p;
+        ctx.frameSlot = frameSlot;
+
+        bool raster = !pass.colors.empty() || pass.depth.res != RG_INVALID;
+        if (!raster) {
+            pass.execute(ctx);
+            if (zones) zones->endGpuZone(cmd, zone);
+            continue;
+        }
+
+        if (pass.colors.size() > 8) {
+            throw std::runtime_error("Render graph pass " + pass.name + " has too many color attachments!");
+        }
+        for (size_t i = 0; i < pass.colors.size(); ++i) {
+            const Attachment &att = pass.colors[i];
+            colorInfos[i] = VkRenderingAttachmentInfo{};
+            colorInfos[i].sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+            colorInfos[i].imageView = resources[att.res].view;
+            colorInfos[i].imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            colorInfos[i].loadOp = att.loadOp;
+            colorInfos[i].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+            colorInfos[i].clearValue = att.clear;
+        }
+
+        VkRenderingAttachmentInfo depthInfo{};
+        if (pass.depth.res != RG_INVALID) {
+            depthInfo.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+            depthInfo.imageView = resources[pass.depth.res].view;
+            depthInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL;
+            depthInfo.loadOp = pass.depth.loadOp;
+            depthInfo.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+            depthInfo.clearValue = pass.depth.clear;
+        }
+
+        RGHandle first = !pass.colors.empty() ? pass.colors[0].res : pass.depth.res;
+        ctx.renderExtent = resources[first].desc.extent;
+
+        VkRenderingInfo renderingInfo{};
+        renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+        renderingInfo.flags = pass.secondary ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0;
+        renderingInfo.renderArea = {{0, 0}, ctx.renderExtent};
+        renderingInfo.layerCount = 1;
+        renderingInfo.colorAttachmentCount = static_cast<uint32_t>(pass.colors.size());
+        renderingInfo.pColorAttachments = colorInfos;
+        renderingInfo.pDepthAttachment = pass.depth.res != RG_INVALID ? &depthInfo : nullptr;
+
+        vkd.cmdBeginRendering(cmd, &renderingInfo);
+        pass.execute(ctx);
+        vkd.cmdEndRendering(cmd);
+        // Timestamps can't go inside a rendering instance that only executes secondaries
+        if (zones) zones->endGpuZone(cmd, zone);
+    }
+
+    emitBarriers(cmd, seg.releases);
+    if (segment + 1 == segments.size()) {
+        emitBarriers(cmd, finalBarriers);
+    }
+}
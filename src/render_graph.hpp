@@ -0,0 +1,301 @@
+#pragma once
+
+#include "gpu_allocator.hpp"
+#include "profiler.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+using RGHandle = uint32_t;
+constexpr RGHandle RG_INVALID = UINT32_MAX;
+
+// How a pass touches a resource. Each usage maps to one synchronization2 stage/access pair
+// and, for images, the layout the pass expects.
+enum class RGUsage {
+    ColorAttachment,
+    DepthAttachment,
+    DepthRead,
+    SampledFragment,
+    SampledCompute,
+    StorageReadCompute,
+    StorageWriteCompute,
+    StorageReadWriteCompute,
+    IndirectRead,
+    VertexRead,
+    UniformRead,
+    TransferSrc,
+    TransferDst,
+};
+
+// State an imported resource is in when the graph starts, or must be left in when it ends
+struct RGState {
+    VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkPipelineStageFlags2 stages = VK_PIPELINE_STAGE_2_NONE;
+    VkAccessFlags2 access = VK_ACCESS_2_NONE;
+};
+
+// Transient images are created by the graph and live only within one execution. Usage flags
+// are derived from the passes that touch them.
+struct RGTextureDesc {
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkExtent2D extent{};
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+};
+
+struct RenderGraphStats {
+    uint32_t passCount = 0;
+    uint32_t culledPasses = 0;
+    // Live passes running on the async compute queue, and the command buffers an execution is split into
+    uint32_t asyncPasses = 0;
+    uint32_t segmentCount = 0;
+    // Image and buffer barriers emitted per execution; an ownership transfer counts twice
+    uint32_t barrierCount = 0;
+    uint32_t queueTransfers = 0;
+    VkDeviceSize transientBytes = 0;        // memory actually bound to transients
+    VkDeviceSize transientBytesUnaliased = 0;
+};
+
+// A segment waits for another segment to finish before its stages run. Segments of one
+// execution are submitted in order and each waits for its predecessor; a segment may also have
+// to wait for a segment of the previous execution that used its transients on the other queue.
+struct RGSegmentWait {
+    uint32_t segment = 0;
+    bool previousExecution = false;
+    VkPipelineStageFlags2 stages = VK_PIPELINE_STAGE_2_NONE;
+};
+
+class RenderGraph;
+
+// Handed to a pass while it records. For raster passes the graph has already begun dynamic
+// rendering on cmd with the declared attachments.
+struct RGPassContext {
+    VkCommandBuffer cmd = VK_NULL_HANDLE;
+    RenderGraph *graph = nullptr;
+    uint32_t pass = 0;
+    // As passed to setFrameSlot(), e.g. to pick per-copy bindless handles
+    uint32_t frameSlot = 0;
+    VkExtent2D renderExtent{};
+};
+
+// Frame graph over synchronization2 and dynamic rendering. Passes are declared in submission
+// order with the resources they read and write; compile() then
+//  - culls passes whose results never reach an imported resource or a side-effect pass,
+//  - creates transient images and aliases their memory when lifetimes don't overlap,
+//  - precomputes the minimal barriers between consecutive uses of every resource,
+//  - splits the passes into segments at every switch between the graphics and the async
+//    compute queue, with queue family ownership transfers for resources crossing over.
+// The compiled graph is executed every frame. Imported resources can be rebound between
+// executions (e.g. the acquired swapchain image) as long as their description is unchanged.
+//
+// Without async compute (the default) there is one segment and execute() records the whole
+// graph. Otherwise the caller records every segment into a command buffer of its queue with
+// executeSegment() and submits them in order, honouring segmentWaits() with a timeline
+// semaphore. Segment 0 is always on the graphics queue, possibly empty, so frame setup can be
+// recorded into it, and the last segment is on the graphics queue too.
+//
+// Transients used on the async queue get one copy per frame in flight (setFrameCount()), so an
+// execution's graphics work never waits for the previous execution's async work on them; the
+// caller selects the copy of the frame slot it is recording with setFrameSlot().
+class RenderGraph {
+public:
+    using ExecuteFn = std::function<void(RGPassContext &ctx)>;
+
+    class PassBuilder {
+    public:
+        // loadOp LOAD also counts as a read of the previous contents
+        PassBuilder &writeColor(RGHandle res, VkAttachmentLoadOp loadOp, VkClearColorValue clear = {});
+        PassBuilder &writeDepth(RGHandle res, VkAttachmentLoadOp loadOp, float clearDepth = 1.0f);
+        PassBuilder &read(RGHandle res, RGUsage usage);
+        PassBuilder &write(RGHandle res, RGUsage usage);
+        // Never culled, e.g. passes that only write through the host or to other queues
+        PassBuilder &sideEffect();
+        // Runs on the async compute queue when the graph has one. Only for non-raster passes
+        // that use transient resources exclusively.
+        PassBuilder &asyncCompute();
+
+    private:
+        friend class RenderGraph;
+        PassBuilder(RenderGraph &graph, uint32_t pass) : graph(graph), pass(pass) {}
+        RenderGraph &graph;
+        uint32_t pass;
+    };
+
+    void init(GpuAllocator &allocator);
+    // Wraps every executed pass, barriers included, in a GPU zone named after it; set before compile()
+    void setProfiler(Profiler *profiler) { this->profiler = profiler; }
+    // Destroys transient images and their memory; the GPU must be done with the graph
+    void destroy();
+
+    RGHandle importImage(const std::string &name, VkImage image, VkImageView view, VkFormat format,
+                         VkExtent2D extent, const RGState &initial, const RGState &final = {});
+    RGHandle importBuffer(const std::string &name, VkBuffer buffer, VkDeviceSize size,
+                          const RGState &initial, const RGState &final = {});
+    RGHandle createTexture(const std::string &name, const RGTextureDesc &desc);
+
+    // Before compile(): async compute passes go to computeFamily when it differs from
+    // graphicsFamily, otherwise they run on the graphics queue like every other pass
+    void setQueueFamilies(uint32_t graphicsFamily, uint32_t computeFamily);
+    // Before compile(): frames in flight, one copy of each async-used transient per frame
+    void setFrameCount(uint32_t count);
+    // Before recording: binds the copies of the frame slot, whose previous execution must have
+    // completed (its last segment signalled the slot's fence)
+    void setFrameSlot(uint32_t slot);
+    uint32_t frameCount() const { return frames; }
+
+    // Rebinds an imported image before execute(); format and extent must not change
+    void setImportedImage(RGHandle res, VkImage image, VkImageView view);
+    // Rebinds an imported buffer before execute(); size must not change
+    void setImportedBuffer(RGHandle res, VkBuffer buffer);
+
+    uint32_t addPass(const std::string &name, const std::function<void(PassBuilder &)> &setup, ExecuteFn execute);
+
+    void compile();
+    // Records the whole graph; only for graphs with a single segment
+    void execute(VkCommandBuffer cmd);
+
+    uint32_t segmentCount() const { return static_cast<uint32_t>(segments.size()); }
+    bool isAsyncSegment(uint32_t segment) const { return segments[segment].async; }
+    const std::vector<RGSegmentWait> &segmentWaits(uint32_t segment) const { return segments[segment].waits; }
+    // Segment of the first pass using res
+    uint32_t firstSegment(RGHandle res) const;
+    void executeSegment(uint32_t segment, VkCommandBuffer cmd);
+
+    // Raster passes whose contents are recorded into secondary command buffers; can change
+    // between executions
+    void setSecondaryContents(uint32_t pass, bool secondary);
+    // Inheritance for secondaries recorded for a raster pass; valid until the next compile()
+    const VkCommandBufferInheritanceRenderingInfo &renderingInheritance(uint32_t pass) const;
+
+    VkImage image(RGHandle res) const;
+    VkImageView view(RGHandle res) const;
+    // The copy of a transient used by the given frame slot
+    VkImageView view(RGHandle res, uint32_t slot) const;
+    // Valid after compile()
+    uint32_t copyCount(RGHandle res) const { return resources[res].copies; }
+    VkBuffer buffer(RGHandle res) const;
+    bool isCulled(uint32_t pass) const;
+    const RenderGraphStats &stats() const { return graphStats; }
+
+private:
+    struct Resource {
+        std::string name;
+        bool isImage = true;
+        bool imported = false;
+        RGTextureDesc desc;
+        VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+        VkImageUsageFlags usage = 0;
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+        RGState initial;
+        RGState final;
+        // Live pass range using the resource, in pass indices
+        uint32_t firstUse = UINT32_MAX;
+        uint32_t lastUse = 0;
+        // Memory slot for transients
+        uint32_t slot = UINT32_MAX;
+        // Used by a pass in an async segment
+        bool asyncUse = false;
+        // Per frame slot for async-used transients, otherwise one; image and view above are
+        // the copy setFrameSlot() selected
+        uint32_t copies = 1;
+        std::vector<VkImage> images;
+        std::vector<VkImageView> views;
+    };
+
+    struct Access {
+        RGHandle res;
+        RGUsage usage;
+        bool read;
+        bool write;
+    };
+
+    struct Attachment {
+        RGHandle res = RG_INVALID;
+        VkAttachmentLoadOp loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        VkClearValue clear{};
+    };
+
+    // Barrier with the resource recorded instead of the handle, so rebinding imports works.
+    // Different families make it one half of an ownership transfer.
+    struct Barrier {
+        RGHandle res;
+        VkPipelineStageFlags2 srcStages;
+        VkAccessFlags2 srcAccess;
+        VkPipelineStageFlags2 dstStages;
+        VkAccessFlags2 dstAccess;
+        VkImageLayout oldLayout;
+        VkImageLayout newLayout;
+        uint32_t srcFamily = VK_QUEUE_FAMILY_IGNORED;
+        uint32_t dstFamily = VK_QUEUE_FAMILY_IGNORED;
+    };
+
+    struct Pass {
+        std::string name;
+        std::vector<Access> accesses;
+        std::vector<Attachment> colors;
+        Attachment depth;
+        ExecuteFn execute;
+        bool sideEffect = false;
+        bool async = false;
+        bool culled = false;
+        bool secondary = false;
+        uint32_t segment = 0;
+        std::vector<Barrier> barriers;
+        std::vector<VkFormat> colorFormats;
+        VkCommandBufferInheritanceRenderingInfo inheritance{};
+        uint32_t profileName = 0;
+    };
+
+    // Consecutive live passes on one queue, recorded into one command buffer
+    struct Segment {
+        bool async = false;
+        // Pass index range; culled passes inside it are skipped
+        uint32_t firstPass = 0;
+        uint32_t endPass = 0;
+        // Release halves of ownership transfers, recorded after the last pass
+        std::vector<Barrier> releases;
+        std::vector<RGSegmentWait> waits;
+    };
+
+    // Transients sharing one allocation; their lifetimes are disjoint. Occupants all have the
+    // same number of copies, and copy c of each lives in allocations[c].
+    struct MemorySlot {
+        VkMemoryRequirements reqs{};
+        std::vector<RGHandle> occupants;
+        uint32_t copies = 1;
+        std::vector<GpuAllocation> allocations;
+    };
+
+    void addAccess(uint32_t pass, RGHandle res, RGUsage usage, bool read, bool write);
+    void cullPasses();
+    void assignSegments();
+    void addSegmentWait(uint32_t segment, const RGSegmentWait &wait);
+    void allocateTransients();
+    void buildBarriers();
+    void emitBarriers(VkCommandBuffer cmd, const std::vector<Barrier> &barriers);
+
+    GpuAllocator *allocator = nullptr;
+    Profiler *profiler = nullptr;
+    VkDevice device = VK_NULL_HANDLE;
+    uint32_t graphicsFamily = VK_QUEUE_FAMILY_IGNORED;
+    uint32_t computeFamily = VK_QUEUE_FAMILY_IGNORED;
+    uint32_t frames = 1;
+    uint32_t frameSlot = 0;
+    std::vector<Resource> resources;
+    std::vector<Pass> passes;
+    std::vector<Segment> segments;
+    std::vector<MemorySlot> slots;
+    // Transitions of imported resources into their final state
+    std::vector<Barrier> finalBarriers;
+    // Reused by emitBarriers() so executing a compiled graph doesn't allocate
+    std::vector<VkImageMemoryBarrier2> imageScratch;
+    std::vector<VkBufferMemoryBarrier2> bufferScratch;
+    RenderGraphStats graphStats;
+    bool compiled = false;
+};
@@ -0,0 +1,327 @@
+#include "scene.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define VUK_SCENE_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VUK_SCENE_SSE2 1
+#endif
+
+// Slack after each chunk's visible list: the SIMD cull stores a full batch unconditionally
+static constexpr uint32_t SIMD_SLACK = 8;
+
+template <typename T>
+static void permute(std::vector<T> &values, const std::vector<uint32_t> &order) {
+    std::vector<T> sorted(values.size());
+    for (size_t i = 0; i < order.size(); ++i) sorted[i] = values[order[i]];
+    values.swap(sorted);
+}
+
+void Scene::clear() {
+    for (auto *v : {&parent, &levels, &renderKeys, &nodeOf, &indexOf, &levelStart}) v->clear();
+    for (auto *v : {&localXs, &localYs, &localScales, &radii, &worldXs, &worldYs, &worldScales, &worldRadii, &hues, &depths}) {
+        v->clear();
+    }
+    drawKeys.clear();
+    grouped = true;
+    transformsDirty = true;
+}
+
+void Scene::reserve(uint32_t count) {
+    for (auto *v : {&parent, &levels, &renderKeys, &nodeOf, &indexOf}) v->reserve(count);
+    for (auto *v : {&localXs, &localYs, &localScales, &radii, &worldXs, &worldYs, &worldScales, &worldRadii, &hues, &depths}) {
+        v->reserve(count);
+    }
+}
+
+SceneNode Scene::add(const SceneObjectDesc &desc) {
+    uint32_t parentIndex = SCENE_NO_PARENT;
+    uint32_t level = 0;
+    if (desc.parent != SCENE_NO_PARENT) {
+        if (desc.parent >= indexOf.size()) {
+            throw std::runtime_error("Scene object parent does not exist!");
+        }
+        parentIndex = indexOf[desc.parent];
+        level = levels[parentIndex] + 1;
+    }
+    // Appending keeps parents before children; only a shallower level after a deeper one
+    // breaks the grouping
+    if (!levels.empty() && level < levels.back()) grouped = false;
+
+    SceneNode node = static_cast<SceneNode>(indexOf.size());
+    indexOf.push_back(size());
+    nodeOf.push_back(node);
+    parent.push_back(parentIndex);
+    levels.push_back(level);
+    localXs.push_back(desc.x);
+    localYs.push_back(desc.y);
+    localScales.push_back(desc.scale);
+    radii.push_back(desc.radius);
+    worldXs.push_back(0.0f);
+    worldYs.push_back(0.0f);
+    worldScales.push_back(0.0f);
+    worldRadii.push_back(0.0f);
+    hues.push_back(desc.hue);
+    depths.push_back(desc.depth);
+    // Larger depths are farther away and get smaller keys, so they are drawn first
+    auto quantized = static_cast<uint32_t>(std::clamp(desc.depth, 0.0f, 1.0f) * 0xFFFFFF);
+    renderKeys.push_back(static_cast<uint32_t>(desc.layer) << 24 | (0xFFFFFF - quantized));
+
+    levelStart.clear();
+    transformsDirty = true;
+    return node;
+}
+
+void Scene::setLocal(SceneNode node, float x, float y, float scale) {
+    uint32_t i = index(node);
+    localXs[i] = x;
+    localYs[i] = y;
+    localScales[i] = scale;
+    transformsDirty = true;
+}
+
+uint32_t Scene::index(SceneNode node) {
+    if (levelStart.empty()) regroup();
+    return indexOf[node];
+}
+
+void Scene::regroup() {
+    if (!grouped) {
+        std::vector<uint32_t> order(size());
+        std::iota(order.begin(), order.end(), 0u);
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return levels[a] < levels[b]; });
+        std::vector<uint32_t> newIndex(size());
+        for (uint32_t i = 0; i < size(); ++i) newIndex[order[i]] = i;
+
+        permute(parent, order);
+        for (uint32_t &p : parent) {
+            if (p != SCENE_NO_PARENT) p = newIndex[p];
+        }
+        permute(levels, order);
+        for (auto *v : {&localXs, &localYs, &localScales, &radii, &hues, &depths}) permute(*v, order);
+        permute(renderKeys, order);
+        permute(nodeOf, order);
+        for (uint32_t i = 0; i < size(); ++i) indexOf[nodeOf[i]] = i;
+        grouped = true;
+    }
+
+    levelStart.assign(1, 0u);
+    for (uint32_t i = 0; i < size(); ++i) {
+        while (levelStart.size() <= levels[i]) levelStart.push_back(i);
+    }
+    levelStart.push_back(size());
+}
+
+void Scene::updateTransforms(JobSystem *jobs) {
+    if (levelStart.empty()) regroup();
+    if (!transformsDirty) return;
+    for (uint32_t level = 0; level < levelCount(); ++level) {
+        uint32_t start = levelStart[level];
+        uint32_t count = levelStart[level + 1] - start;
+        // A level only reads the finished levels above it, so its chunks are independent
+        if (jobs != nullptr && jobs->workerCount() > 1 && count > CHUNK_SIZE) {
+            jobs->parallelFor(count, CHUNK_SIZE, [&](uint32_t begin, uint32_t end, uint32_t) {
+                transformRange(level, start + begin, start + end);
+            });
+        } else {
+            transformRange(level, start, start + count);
+        }
+    }
+    transformsDirty = false;
+}
+
+void Scene::transformRange(uint32_t level, uint32_t begin, uint32_t end) {
+    const float *lx = localXs.data();
+    const float *ly = localYs.data();
+    const float *ls = localScales.data();
+    const float *r = radii.data();
+    float *wx = worldXs.data();
+    float *wy = worldYs.data();
+    float *ws = worldScales.data();
+    float *wr = worldRadii.data();
+    uint32_t i = begin;
+
+    if (level == 0) {
+        if (simd) {
+#if defined(VUK_SCENE_AVX2)
+            for (; i + 8 <= end; i += 8) {
+                __m256 scale = _mm256_loadu_ps(ls + i);
+                _mm256_storeu_ps(wx + i, _mm256_loadu_ps(lx + i));
+                _mm256_storeu_ps(wy + i, _mm256_loadu_ps(ly + i));
+                _mm256_storeu_ps(ws + i, scale);
+                _mm256_storeu_ps(wr + i, _mm256_mul_ps(scale, _mm256_loadu_ps(r + i)));
+            }
+#elif defined(VUK_SCENE_SSE2)
+            for (; i + 4 <= end; i += 4) {
+                __m128 scale = _mm_loadu_ps(ls + i);
+                _mm_storeu_ps(wx + i, _mm_loadu_ps(lx + i));
+                _mm_storeu_ps(wy + i, _mm_loadu_ps(ly + i));
+                _mm_storeu_ps(ws + i, scale);
+                _mm_storeu_ps(wr + i, _mm_mul_ps(scale, _mm_loadu_ps(r + i)));
+            }
+#endif
+        }
+        for (; i < end; ++i) {
+            wx[i] = lx[i];
+            wy[i] = ly[i];
+            ws[i] = ls[i];
+            wr[i] = ls[i] * r[i];
+        }
+        return;
+    }
+
+    const uint32_t *p = parent.data();
+    if (simd) {
+#if defined(VUK_SCENE_AVX2)
+        for (; i + 8 <= end; i += 8) {
+            __m256i parents = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+            __m256 px = _mm256_i32gather_ps(wx, parents, 4);
+            __m256 py = _mm256_i32gather_ps(wy, parents, 4);
+            __m256 ps = _mm256_i32gather_ps(ws, parents, 4);
+            __m256 scale = _mm256_mul_ps(ps, _mm256_loadu_ps(ls + i));
+            _mm256_storeu_ps(wx + i, _mm256_add_ps(px, _mm256_mul_ps(ps, _mm256_loadu_ps(lx + i))));
+            _mm256_storeu_ps(wy + i, _mm256_add_ps(py, _mm256_mul_ps(ps, _mm256_loadu_ps(ly + i))));
+            _mm256_storeu_ps(ws + i, scale);
+            _mm256_storeu_ps(wr + i, _mm256_mul_ps(scale, _mm256_loadu_ps(r + i)));
+        }
+#elif defined(VUK_SCENE_SSE2)
+        // No gather before AVX2; siblings are adjacent, so the parent loads mostly hit one line
+        for (; i + 4 <= end; i += 4) {
+            __m128 px = _mm_setr_ps(wx[p[i]], wx[p[i + 1]], wx[p[i + 2]], wx[p[i + 3]]);
+            __m128 py = _mm_setr_ps(wy[p[i]], wy[p[i + 1]], wy[p[i + 2]], wy[p[i + 3]]);
+            __m128 ps = _mm_setr_ps(ws[p[i]], ws[p[i + 1]], ws[p[i + 2]], ws[p[i + 3]]);
+            __m128 scale = _mm_mul_ps(ps, _mm_loadu_ps(ls + i));
+            _mm_storeu_ps(wx + i, _mm_add_ps(px, _mm_mul_ps(ps, _mm_loadu_ps(lx + i))));
+            _mm_storeu_ps(wy + i, _mm_add_ps(py, _mm_mul_ps(ps, _mm_loadu_ps(ly + i))));
+            _mm_storeu_ps(ws + i, scale);
+            _mm_storeu_ps(wr + i, _mm_mul_ps(scale, _mm_loadu_ps(r + i)));
+        }
+#endif
+    }
+    for (; i < end; ++i) {
+        float ps = ws[p[i]];
+        wx[i] = wx[p[i]] + ps * lx[i];
+        wy[i] = wy[p[i]] + ps * ly[i];
+        ws[i] = ps * ls[i];
+        wr[i] = ws[i] * r[i];
+    }
+}
+
+void Scene::cull(float centerX, float centerY, float zoom, JobSystem *jobs) {
+    // |(x - center) * zoom| - radius * zoom <= 1, with the zoom moved to the right-hand side
+    const float extent = 1.0f / zoom;
+    const uint32_t count = size();
+    const uint32_t chunks = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    if (chunkVisible.size() < chunks) chunkVisible.resize(chunks);
+    chunkCounts.assign(chunks, 0);
+    auto cullChunk = [&](uint32_t begin, uint32_t end, uint32_t) {
+        uint32_t chunk = begin / CHUNK_SIZE;
+        std::vector<uint32_t> &out = chunkVisible[chunk];
+        if (out.size() < CHUNK_SIZE + SIMD_SLACK) out.resize(CHUNK_SIZE + SIMD_SLACK);
+        chunkCounts[chunk] = cullRange(begin, end, centerX, centerY, extent, out.data());
+    };
+    if (jobs != nullptr && jobs->workerCount() > 1 && chunks > 1) {
+        jobs->parallelFor(count, CHUNK_SIZE, cullChunk);
+    } else {
+        for (uint32_t begin = 0; begin < count; begin += CHUNK_SIZE) cullChunk(begin, std::min(count, begin + CHUNK_SIZE), 0);
+    }
+
+    uint32_t visible = 0;
+    for (uint32_t chunk = 0; chunk < chunks; ++chunk) visible += chunkCounts[chunk];
+    drawKeys.resize(visible);
+    uint64_t *key = drawKeys.data();
+    for (uint32_t chunk = 0; chunk < chunks; ++chunk) {
+        const uint32_t *indices = chunkVisible[chunk].data();
+        for (uint32_t k = 0; k < chunkCounts[chunk]; ++k) {
+            *key++ = static_cast<uint64_t>(renderKeys[indices[k]]) << 32 | indices[k];
+        }
+    }
+}
+
+uint32_t Scene::cullRange(uint32_t begin, uint32_t end, float centerX, float centerY, float extent,
+                          uint32_t *out) const {
+    const float *wx = worldXs.data();
+    const float *wy = worldYs.data();
+    const float *wr = worldRadii.data();
+    uint32_t n = 0;
+    uint32_t i = begin;
+    if (simd) {
+        // Branch-free compaction: every lane is stored, but only visible ones advance n
+#if defined(VUK_SCENE_AVX2)
+        const __m256 sign = _mm256_set1_ps(-0.0f);
+        const __m256 cx = _mm256_set1_ps(centerX);
+        const __m256 cy = _mm256_set1_ps(centerY);
+        const __m256 ext = _mm256_set1_ps(extent);
+        for (; i + 8 <= end; i += 8) {
+            __m256 r = _mm256_loadu_ps(wr + i);
+            __m256 dx = _mm256_sub_ps(_mm256_andnot_ps(sign, _mm256_sub_ps(_mm256_loadu_ps(wx + i), cx)), r);
+            __m256 dy = _mm256_sub_ps(_mm256_andnot_ps(sign, _mm256_sub_ps(_mm256_loadu_ps(wy + i), cy)), r);
+            __m256 in = _mm256_and_ps(_mm256_cmp_ps(dx, ext, _CMP_LE_OQ), _mm256_cmp_ps(dy, ext, _CMP_LE_OQ));
+            uint32_t mask = static_cast<uint32_t>(_mm256_movemask_ps(in));
+            for (uint32_t lane = 0; lane < 8; ++lane) {
+                out[n] = i + lane;
+                n += (mask >> lane) & 1;
+            }
+        }
+#elif defined(VUK_SCENE_SSE2)
+        const __m128 sign = _mm_set1_ps(-0.0f);
+        const __m128 cx = _mm_set1_ps(centerX);
+        const __m128 cy = _mm_set1_ps(centerY);
+        const __m128 ext = _mm_set1_ps(extent);
+        for (; i + 4 <= end; i += 4) {
+            __m128 r = _mm_loadu_ps(wr + i);
+            __m128 dx = _mm_sub_ps(_mm_andnot_ps(sign, _mm_sub_ps(_mm_loadu_ps(wx + i), cx)), r);
+            __m128 dy = _mm_sub_ps(_mm_andnot_ps(sign, _mm_sub_ps(_mm_loadu_ps(wy + i), cy)), r);
+            __m128 in = _mm_and_ps(_mm_cmple_ps(dx, ext), _mm_cmple_ps(dy, ext));
+            uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(in));
+            for (uint32_t lane = 0; lane < 4; ++lane) {
+                out[n] = i + lane;
+                n += (mask >> lane) & 1;
+            }
+        }
+#endif
+    }
+    for (; i < end; ++i) {
+        if (std::abs(wx[i] - centerX) - wr[i] <= extent && std::abs(wy[i] - centerY) - wr[i] <= extent) {
+            out[n++] = i;
+        }
+    }
+    return n;
+}
+
+void Scene::sortDrawKeys() {
+    // LSD radix sort on the render key (the upper half); the index below keeps ties in
+    // scene order. Digits every key shares, e.g. the layer of a single-pipeline scene, are skipped.
+    const size_t count = drawKeys.size();
+    sortScratch.resize(count);
+    for (uint32_t shift = 32; shift < 64; shift += 8) {
+        uint32_t histogram[256] = {};
+        for (uint64_t key : drawKeys) ++histogram[(key >> shift) & 0xFF];
+        if (count == 0 || histogram[(drawKeys[0] >> shift) & 0xFF] == count) continue;
+
+        uint32_t offset = 0;
+        for (uint32_t &bucket : histogram) {
+            uint32_t n = bucket;
+            bucket = offset;
+            offset += n;
+        }
+        for (uint64_t key : drawKeys) sortScratch[histogram[(key >> shift) & 0xFF]++] = key;
+        drawKeys.swap(sortScratch);
+    }
+}
+
+const char *Scene::simdName() {
+#if defined(VUK_SCENE_AVX2)
+    return "AVX2";
+#elif defined(VUK_SCENE_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "job_system.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Stable handle of a scene object; its dense index changes when the hierarchy is regrouped
+using SceneNode = uint32_t;
+static constexpr SceneNode SCENE_NO_PARENT = UINT32_MAX;
+
+struct SceneObjectDesc {
+    SceneNode parent = SCENE_NO_PARENT;
+    // Relative to the parent: world = parent offset + parent scale * local offset
+    float x = 0.0f;
+    float y = 0.0f;
+    float scale = 1.0f;
+    // Bounding circle in local units
+    float radius = 0.0f;
+    float hue = 0.0f;
+    float depth = 0.5f;
+    // Pipeline bucket; draws sort by layer, then back to front
+    uint8_t layer = 0;
+};
+
+// Flat scene of 2D objects (offset plus uniform scale, what triangle.vert takes) stored as
+// structure of arrays. Objects are kept dense in parent-before-child order and grouped by
+// hierarchy level, so transforms propagate one level at a time with every parent already
+// final, and each level is a contiguous range that splits into chunks across JobSystem
+// workers. The per-object kernels (transforms, culling) run 8 objects at a time with AVX2,
+// 4 with SSE2, or one at a time otherwise; setSimdEnabled(false) forces the scalar path.
+class Scene {
+public:
+    // Objects per job of the parallel kernels
+    static constexpr uint32_t CHUNK_SIZE = 4096;
+
+    void clear();
+    void reserve(uint32_t count);
+    // desc.parent must already exist
+    SceneNode add(const SceneObjectDesc &desc);
+    uint32_t size() const { return static_cast<uint32_t>(parent.size()); }
+    uint32_t levelCount() const { return levelStart.empty() ? 0 : static_cast<uint32_t>(levelStart.size() - 1); }
+
+    void setLocal(SceneNode node, float x, float y, float scale);
+    // Dense index of a node, valid until the next add()
+    uint32_t index(SceneNode node);
+
+    // Recomputes world transforms and bounds if anything changed since the last call. jobs may
+    // be null (or its caller already inside a job) to run on the calling thread.
+    void updateTransforms(JobSystem *jobs);
+    // Keeps the objects whose bounding circle overlaps the view, the same test as
+    // shaders/cull.comp, and builds their draw keys (unsorted)
+    void cull(float centerX, float centerY, float zoom, JobSystem *jobs);
+    // Orders the visible objects by layer, then back to front (stable radix sort)
+    void sortDrawKeys();
+
+    uint32_t visibleCount() const { return static_cast<uint32_t>(drawKeys.size()); }
+    // Dense index of the k-th draw after sortDrawKeys()
+    uint32_t drawIndex(uint32_t k) const { return static_cast<uint32_t>(drawKeys[k]); }
+
+    // World-space values by dense index, valid after updateTransforms()
+    float worldX(uint32_t i) const { return worldXs[i]; }
+    float worldY(uint32_t i) const { return worldYs[i]; }
+    float worldScale(uint32_t i) const { return worldScales[i]; }
+    float worldRadius(uint32_t i) const { return worldRadii[i]; }
+    float hue(uint32_t i) const { return hues[i]; }
+    float depth(uint32_t i) const { return depths[i]; }
+
+    void setSimdEnabled(bool on) { simd = on; }
+    // Widest kernel path this build was compiled for
+    static const char *simdName();
+
+private:
+    // Stable-sorts the objects by level so each level is contiguous
+    void regroup();
+    void transformRange(uint32_t level, uint32_t begin, uint32_t end);
+    // Writes the visible indices of [begin, end) to out and returns how many there are
+    uint32_t cullRange(uint32_t begin, uint32_t end, float centerX, float centerY, float extent, uint32_t *out) const;
+
+    // Dense arrays, indexed alike
+    std::vector<uint32_t> parent;
+    std::vector<uint32_t> levels;
+    std::vector<float> localXs, localYs, localScales, radii;
+    std::vector<float> worldXs, worldYs, worldScales, worldRadii;
+    std::vector<float> hues, depths;
+    std::vector<uint32_t> renderKeys;
+    std::vector<SceneNode> nodeOf;
+
+    // Handle to dense index
+    std::vector<uint32_t> indexOf;
+    // Dense range of level l is [levelStart[l], levelStart[l + 1])
+    std::vector<uint32_t> levelStart;
+    bool grouped = true;
+    bool transformsDirty = true;
+    bool simd = true;
+
+    // renderKey << 32 | dense index
+    std::vector<uint64_t> drawKeys;
+    std::vector<uint64_t> sortScratch;
+    // One visible list per cull chunk, each with room for a full SIMD batch past the chunk
+    std::vector<std::vector<uint32_t>> chunkVisible;
+    std::vector<uint32_t> chunkCounts;
+};
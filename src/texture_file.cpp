@@ -0,0 +1,237 @@
+#include "texture_file.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr uint64_t LEVEL_ALIGNMENT = 16;
+
+uint64_t alignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+bool textureBlockInfo(VkFormat format, TextureBlockInfo &out) {
+    switch (format) {
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+        out = {1, 1, 4};
+        return true;
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        out = {4, 4, 8};
+        return true;
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+        out = {4, 4, 16};
+        return true;
+    default:
+        return false;
+    }
+}
+
+VkExtent3D textureLevelExtent(uint32_t width, uint32_t height, uint32_t level) {
+    return {std::max(width >> level, 1u), std::max(height >> level, 1u), 1};
+}
+
+VkDeviceSize textureLevelSize(VkFormat format, uint32_t width, uint32_t height, uint32_t level) {
+    TextureBlockInfo block;
+    if (!textureBlockInfo(format, block)) return 0;
+    VkExtent3D extent = textureLevelExtent(width, height, level);
+    VkDeviceSize blocksX = (extent.width + block.width - 1) / block.width;
+    VkDeviceSize blocksY = (extent.height + block.height - 1) / block.height;
+    return blocksX * blocksY * block.bytes;
+}
+
+uint32_t textureFullMipCount(uint32_t width, uint32_t height) {
+    uint32_t count = 1;
+    for (uint32_t size = std::max(width, height); size > 1; size >>= 1) ++count;
+    return count;
+}
+
+void writeTextureFile(const std::string &path, VkFormat format, uint32_t width, uint32_t height,
+                      const std::vector<std::vector<uint8_t>> &levelData) {
+    TextureBlockInfo block;
+    if (!textureBlockInfo(format, block)) {
+        throw std::runtime_error("Unsupported texture file format!");
+    }
+    uint32_t mipCount = static_cast<uint32_t>(levelData.size());
+    if (width == 0 || height == 0 || mipCount == 0 || mipCount > textureFullMipCount(width, height)) {
+        throw std::runtime_error("Invalid texture file dimensions!");
+    }
+
+    TextureFileHeader header{};
+    std::memcpy(header.magic, TEXTURE_FILE_MAGIC, sizeof(header.magic));
+    header.format = static_cast<uint32_t>(format);
+    header.width = width;
+    header.height = height;
+    header.mipCount = mipCount;
+
+    // Smallest level first
+    std::vector<TextureFileLevel> levels(mipCount);
+    uint64_t offset = alignUp(sizeof(header) + sizeof(TextureFileLevel) * mipCount, LEVEL_ALIGNMENT);
+    for (uint32_t level = mipCount; level-- > 0;) {
+        if (levelData[level].size() != textureLevelSize(format, width, height, level)) {
+            throw std::runtime_error("Texture level size does not match its format!");
+        }
+        levels[level] = {offset, levelData[level].size()};
+        offset = alignUp(offset + levelData[level].size(), LEVEL_ALIGNMENT);
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("Failed to create texture file " + path + "!");
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(levels.data()), sizeof(TextureFileLevel) * mipCount);
+    const char padding[LEVEL_ALIGNMENT] = {};
+    for (uint32_t level = mipCount; level-- > 0;) {
+        uint64_t position = static_cast<uint64_t>(file.tellp());
+        file.write(padding, static_cast<std::streamsize>(levels[level].offset - position));
+        file.write(reinterpret_cast<const char *>(levelData[level].data()),
+                   static_cast<std::streamsize>(levelData[level].size()));
+    }
+    if (!file) {
+        throw std::runtime_error("Failed to write texture file " + path + "!");
+    }
+}
+
+void writeSyntheticTextureFile(const std::string &path, uint32_t size, uint32_t seed) {
+    static const uint8_t tints[8][3] = {
+        {255, 255, 255}, {255, 96, 96}, {96, 255, 96}, {96, 96, 255},
+        {255, 255, 96}, {255, 96, 255}, {96, 255, 255}, {160, 160, 160},
+    };
+    uint32_t mipCount = textureFullMipCount(size, size);
+    std::vector<std::vector<uint8_t>> levels(mipCount);
+    for (uint32_t level = 0; level < mipCount; ++level) {
+        uint32_t extent = std::max(size >> level, 1u);
+        uint32_t cell = std::max(32u >> level, 1u);
+        const uint8_t *tint = tints[level % 8];
+        uint8_t shade = static_cast<uint8_t>(64 + (seed * 37) % 128);
+        std::vector<uint8_t> &texels = levels[level];
+        texels.resize(static_cast<size_t>(extent) * extent * 4);
+        for (uint32_t y = 0; y < extent; ++y) {
+            for (uint32_t x = 0; x < extent; ++x) {
+                bool dark = ((x / cell) + (y / cell)) & 1;
+                uint8_t *texel = &texels[(static_cast<size_t>(y) * extent + x) * 4];
+                for (uint32_t c = 0; c < 3; ++c) {
+                    texel[c] = dark ? static_cast<uint8_t>(tint[c] * shade / 255) : tint[c];
+                }
+                texel[3] = 255;
+            }
+        }
+    }
+    writeTextureFile(path, VK_FORMAT_R8G8B8A8_UNORM, size, size, levels);
+}
+
+void MappedTextureFile::open(const std::string &path) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Failed to open texture file " + path + "!");
+    }
+    LARGE_INTEGER size{};
+    GetFileSizeEx(file, &size);
+    HANDLE mapping = size.QuadPart > 0 ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    const void *view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (view == nullptr) {
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        throw std::runtime_error("Failed to map texture file " + path + "!");
+    }
+    fileHandle = file;
+    mappingHandle = mapping;
+    fileSize = static_cast<size_t>(size.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open texture file " + path + "!");
+    }
+    struct stat st{};
+    void *view = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    // The mapping keeps the file referenced
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        throw std::runtime_error("Failed to map texture file " + path + "!");
+    }
+    fileSize = static_cast<size_t>(st.st_size);
+#endif
+    data = static_cast<const uint8_t *>(view);
+
+    auto invalid = [&](const char *reason) {
+        close();
+        return std::runtime_error("Invalid texture file " + path + ": " + reason + "!");
+    };
+    if (fileSize < sizeof(header)) throw invalid("truncated header");
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, TEXTURE_FILE_MAGIC, sizeof(header.magic)) != 0) throw invalid("bad magic");
+    TextureBlockInfo block;
+    if (!textureBlockInfo(format(), block)) throw invalid("unsupported format");
+    if (header.width == 0 || header.height == 0 || header.mipCount == 0 ||
+        header.mipCount > textureFullMipCount(header.width, header.height)) {
+        throw invalid("bad dimensions");
+    }
+    if (fileSize < sizeof(header) + sizeof(TextureFileLevel) * header.mipCount) throw invalid("truncated level table");
+    levels.resize(header.mipCount);
+    std::memcpy(levels.data(), data + sizeof(header), sizeof(TextureFileLevel) * header.mipCount);
+    for (uint32_t level = 0; level < header.mipCount; ++level) {
+        const TextureFileLevel &l = levels[level];
+        if (l.size != textureLevelSize(format(), header.width, header.height, level)) throw invalid("bad level size");
+        if (l.offset > fileSize || l.size > fileSize - l.offset) throw invalid("level out of bounds");
+    }
+}
+
+void MappedTextureFile::close() {
+    if (data != nullptr) {
+#ifdef _WIN32
+        UnmapViewOfFile(data);
+        CloseHandle(static_cast<HANDLE>(mappingHandle));
+        CloseHandle(static_cast<HANDLE>(fileHandle));
+        mappingHandle = nullptr;
+        fileHandle = nullptr;
+#else
+        munmap(const_cast<uint8_t *>(data), fileSize);
+#endif
+    }
+    data = nullptr;
+    fileSize = 0;
+    header = {};
+    levels.clear();
+}
+
+void MappedTextureFile::prefetch(uint32_t firstLevel) const {
+#ifndef _WIN32
+    if (data == nullptr || firstLevel >= header.mipCount) return;
+    // Levels are stored smallest first, so [firstLevel, mipCount) is one contiguous range
+    uint64_t begin = levels[header.mipCount - 1].offset;
+    uint64_t end = levels[firstLevel].offset + levels[firstLevel].size;
+    uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    begin = begin / page * page;
+    madvise(const_cast<uint8_t *>(data) + begin, static_cast<size_t>(end - begin), MADV_WILLNEED);
+#else
+    (void)firstLevel;
+#endif
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// On-disk texture container, laid out so a memory mapping can be handed to the GPU upload
+// path as is (little-endian):
+//
+//   TextureFileHeader
+//   TextureFileLevel[mipCount]   indexed by mip level, 0 = largest
+//   level data                   smallest level first, each 16-byte aligned
+//
+// Like KTX2 the level index is largest-first while the data is smallest-first, so the mip
+// tail is one contiguous run at the start of the payload and a streamer reading low-detail
+// levels first touches the file front to back. Level data is tightly packed texel blocks,
+// exactly what UploadService::uploadImage() expects.
+struct TextureFileHeader {
+    char magic[8];
+    uint32_t format;  // VkFormat
+    uint32_t width;
+    uint32_t height;
+    uint32_t mipCount;
+};
+
+struct TextureFileLevel {
+    uint64_t offset;  // from the start of the file
+    uint64_t size;
+};
+
+constexpr char TEXTURE_FILE_MAGIC[8] = {'V', 'U', 'K', 'T', 'E', 'X', '0', '1'};
+
+// Texel block layout of the formats the container accepts (uncompressed RGBA8 and BC1/BC7)
+struct TextureBlockInfo {
+    uint32_t width = 1;
+    uint32_t height = 1;
+    uint32_t bytes = 0;
+};
+
+// Returns false for formats the container does not support
+bool textureBlockInfo(VkFormat format, TextureBlockInfo &out);
+VkExtent3D textureLevelExtent(uint32_t width, uint32_t height, uint32_t level);
+VkDeviceSize textureLevelSize(VkFormat format, uint32_t width, uint32_t height, uint32_t level);
+uint32_t textureFullMipCount(uint32_t width, uint32_t height);
+
+// levels[i] holds mip level i; throws on I/O errors or sizes that don't match the format
+void writeTextureFile(const std::string &path, VkFormat format, uint32_t width, uint32_t height,
+                      const std::vector<std::vector<uint8_t>> &levels);
+// Full mip chain of an RGBA8 checkerboard whose tint identifies the level, so the resident
+// mip is visible on screen. For exercising streaming without real assets.
+void writeSyntheticTextureFile(const std::string &path, uint32_t size, uint32_t seed);
+
+// Read-only memory mapping of a texture file. Level data points straight into the mapping, so
+// uploads copy from the page cache into the staging ring with no intermediate buffer.
+class MappedTextureFile {
+public:
+    MappedTextureFile() = default;
+    MappedTextureFile(const MappedTextureFile &) = delete;
+    MappedTextureFile &operator=(const MappedTextureFile &) = delete;
+    ~MappedTextureFile() { close(); }
+
+    // Throws if the file can't be mapped or its header and level table are inconsistent
+    void open(const std::string &path);
+    void close();
+
+    VkFormat format() const { return static_cast<VkFormat>(header.format); }
+    uint32_t width() const { return header.width; }
+    uint32_t height() const { return header.height; }
+    uint32_t mipCount() const { return header.mipCount; }
+    VkExtent3D levelExtent(uint32_t level) const { return textureLevelExtent(header.width, header.height, level); }
+    const void *levelData(uint32_t level) const { return data + levels[level].offset; }
+    VkDeviceSize levelSize(uint32_t level) const { return levels[level].size; }
+
+    // Asks the OS to start reading levels [firstLevel, mipCount) in; a no-op on Windows
+    void prefetch(uint32_t firstLevel) const;
+
+private:
+    const uint8_t *data = nullptr;
+    size_t fileSize = 0;
+#ifdef _WIN32
+    void *fileHandle = nullptr;
+    void *mappingHandle = nullptr;
+#endif
+    TextureFileHeader header{};
+    std::vector<TextureFileLevel> levels;
+};
@@ -0,0 +1,329 @@
+#include "texture_streamer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+// Share of the device-local budget streaming may grow into; the rest is left for other
+// allocations and the driver
+constexpr double BUDGET_FRACTION = 0.9;
+
+} // namespace
+
+void TextureStreamer::init(VkDevice dev, GpuAllocator &gpuAllocator, UploadService &uploadService,
+                           BindlessTable &table, DeletionQueue &deletion) {
+    device = dev;
+    allocator = &gpuAllocator;
+    uploads = &uploadService;
+    bindless = &table;
+    deletionQueue = &deletion;
+    currentFrame = 0;
+    budgetOverride = 0;
+    frameUploadLimit = DEFAULT_FRAME_UPLOAD_BYTES;
+    loads = 0;
+    evictions = 0;
+    bytesStreamed = 0;
+    starved = 0;
+}
+
+void TextureStreamer::destroy() {
+    for (Texture &texture : textures) {
+        if (!texture.live) continue;
+        bindless->release(BindlessType::SampledImage, texture.handle);
+        destroyImage(texture.current);
+        destroyImage(texture.pending);
+    }
+    for (Orphan &o : orphans) {
+        retiringBytes -= o.image.allocation.size;
+        destroyImage(o.image);
+    }
+    textures.clear();
+    freeSlots.clear();
+    orphans.clear();
+}
+
+StreamedTexture TextureStreamer::add(const std::string &path) {
+    auto file = std::make_unique<MappedTextureFile>();
+    file->open(path);
+
+    StreamedTexture id;
+    if (!freeSlots.empty()) {
+        id = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        id = static_cast<StreamedTexture>(textures.size());
+        textures.emplace_back();
+    }
+    Texture &texture = textures[id];
+    texture = Texture{};
+    texture.file = std::move(file);
+    texture.live = true;
+    texture.lastRequested = currentFrame;
+
+    const MappedTextureFile &f = *texture.file;
+    uint32_t last = f.mipCount() - 1;
+    texture.minMip = 0;
+    while (texture.minMip < last && f.levelSize(texture.minMip) > uploads->stagingCapacity()) ++texture.minMip;
+    texture.tailMip = 0;
+    while (texture.tailMip < last && std::max(f.levelExtent(texture.tailMip).width,
+                                              f.levelExtent(texture.tailMip).height) > TAIL_SIZE) {
+        ++texture.tailMip;
+    }
+    texture.tailMip = std::max(texture.tailMip, texture.minMip);
+    // Nothing is resident until the tail arrives
+    texture.residentMip = f.mipCount();
+    rebuild(texture, texture.tailMip);
+    return id;
+}
+
+void TextureStreamer::remove(StreamedTexture id) {
+    Texture &texture = textures[id];
+    if (!texture.live) return;
+    bindless->release(BindlessType::SampledImage, texture.handle);
+    retire(texture.current, 0);
+    if (texture.hasPending) retire(texture.pending, texture.pendingToken);
+    texture = Texture{};
+    freeSlots.push_back(id);
+}
+
+void TextureStreamer::request(StreamedTexture id, float pixels) {
+    Texture &texture = textures[id];
+    texture.requestedPixels = std::max(texture.requestedPixels, std::max(pixels, 1.0f));
+    texture.lastRequested = currentFrame;
+}
+
+void TextureStreamer::beginFrame(uint64_t frameNumber) {
+    currentFrame = frameNumber;
+
+    for (Texture &texture : textures) {
+        if (!texture.live || !texture.hasPending || !uploads->isAvailable(texture.pendingToken)) continue;
+        if (texture.pending.firstMip < texture.residentMip) {
+            ++loads;
+        } else {
+            ++evictions;
+        }
+        // Frames already recorded keep sampling the old image through the old slot
+        bindless->release(BindlessType::SampledImage, texture.handle);
+        retire(texture.current, 0);
+        texture.current = texture.pending;
+        texture.pending = Image{};
+        texture.hasPending = false;
+        texture.residentMip = texture.current.firstMip;
+        texture.handle = bindless->addSampledImage(texture.current.view);
+        if (texture.handle == BINDLESS_INVALID) {
+            throw std::runtime_error("Bindless table is out of image slots!");
+        }
+    }
+
+    auto acquired = [&](const Orphan &o) { return uploads->isAvailable(o.token); };
+    for (const Orphan &o : orphans) {
+        if (acquired(o)) release(o.image);
+    }
+    orphans.erase(std::remove_if(orphans.begin(), orphans.end(), acquired), orphans.end());
+}
+
+void TextureStreamer::update() {
+    struct Load {
+        StreamedTexture id;
+        uint32_t mip;
+        uint32_t deficit;
+        float pixels;
+    };
+
+    VkDeviceSize limit = budget();
+    VkDeviceSize committed = 0;
+    std::vector<Load> wanted;
+    std::vector<StreamedTexture> victims;
+    starved = 0;
+    for (StreamedTexture id = 0; id < textures.size(); ++id) {
+        const Texture &texture = textures[id];
+        if (!texture.live) continue;
+        committed += committedBytes(texture);
+        bool requested = texture.requestedPixels > 0.0f;
+        uint32_t mip = wantedMip(texture);
+        if (requested && texture.residentMip > mip) ++starved;
+        // A texture with a change in flight is left alone until it lands
+        if (texture.hasPending) continue;
+        if (requested && mip < texture.residentMip) {
+            wanted.push_back({id, mip, texture.residentMip - mip, texture.requestedPixels});
+        } else if (!requested && texture.residentMip < texture.tailMip) {
+            victims.push_back(id);
+        }
+    }
+
+    // Most starved first; the ones covering more of the screen break ties
+    std::sort(wanted.begin(), wanted.end(), [](const Load &a, const Load &b) {
+        return a.deficit != b.deficit ? a.deficit > b.deficit : a.pixels > b.pixels;
+    });
+    std::sort(victims.begin(), victims.end(), [this](StreamedTexture a, StreamedTexture b) {
+        return textures[a].lastRequested < textures[b].lastRequested;
+    });
+
+    VkDeviceSize queued = 0;
+    size_t nextVictim = 0;
+    for (const Load &load : wanted) {
+        if (frameUploadLimit != 0 && queued >= frameUploadLimit) break;
+        Texture &texture = textures[load.id];
+        // The current image leaves the committed set once the new one is swapped in
+        VkDeviceSize released = committedBytes(texture);
+        VkDeviceSize cost = imageBytes(texture, load.mip);
+        while (committed - released + cost > limit && nextVictim < victims.size()) {
+            Texture &victim = textures[victims[nextVictim++]];
+            committed -= committedBytes(victim);
+            queued += rebuild(victim, victim.tailMip);
+            committed += committedBytes(victim);
+        }
+        // A smaller load further down may still fit
+        if (committed - released + cost > limit) continue;
+        queued += rebuild(texture, load.mip);
+        committed = committed - released + committedBytes(texture);
+    }
+
+    for (Texture &texture : textures) texture.requestedPixels = 0.0f;
+}
+
+TextureStreamerStats TextureStreamer::stats() const {
+    TextureStreamerStats s;
+    for (const Texture &texture : textures) {
+        if (!texture.live) continue;
+        ++s.textures;
+        s.residentBytes += committedBytes(texture);
+        if (texture.hasPending) {
+            ++s.pending;
+            // Until the swap both images are alive
+            s.retiringBytes += texture.current.allocation.size;
+        }
+    }
+    s.retiringBytes += retiringBytes;
+    s.budgetBytes = budget();
+    s.loads = loads;
+    s.evictions = evictions;
+    s.bytesStreamed = bytesStreamed;
+    s.starved = starved;
+    return s;
+}
+
+// About one texel per covered pixel, never finer than what fits the staging ring or coarser
+// than the tail
+uint32_t TextureStreamer::wantedMip(const Texture &texture) const {
+    if (texture.requestedPixels <= 0.0f) return committedMip(texture);
+    float size = static_cast<float>(std::max(texture.file->width(), texture.file->height()));
+    float ratio = size / texture.requestedPixels;
+    uint32_t mip = ratio > 1.0f ? static_cast<uint32_t>(std::floor(std::log2(ratio))) : 0;
+    return std::clamp(mip, texture.minMip, texture.tailMip);
+}
+
+uint32_t TextureStreamer::committedMip(const Texture &texture) const {
+    return texture.hasPending ? texture.pending.firstMip : texture.residentMip;
+}
+
+VkDeviceSize TextureStreamer::committedBytes(const Texture &texture) const {
+    return texture.hasPending ? texture.pending.allocation.size : texture.current.allocation.size;
+}
+
+// Texel bytes only; the allocation adds alignment on top, which the next update() accounts for
+VkDeviceSize TextureStreamer::imageBytes(const Texture &texture, uint32_t firstMip) const {
+    VkDeviceSize bytes = 0;
+    for (uint32_t level = firstMip; level < texture.file->mipCount(); ++level) {
+        bytes += texture.file->levelSize(level);
+    }
+    return bytes;
+}
+
+VkDeviceSize TextureStreamer::budget() const {
+    if (budgetOverride != 0) return budgetOverride;
+
+    // The heap figures include the streamer's own images, so take those out to get everyone else's usage
+    VkDeviceSize owned = 0;
+    for (const Texture &texture : textures) {
+        owned += texture.current.allocation.size + texture.pending.allocation.size;
+    }
+    owned += retiringBytes;
+
+    VkDeviceSize best = 0;
+    for (const GpuHeapBudget &heap : allocator->heapBudgets()) {
+        if (!heap.deviceLocal) continue;
+        VkDeviceSize others = heap.usage > owned ? heap.usage - owned : 0;
+        VkDeviceSize usable = static_cast<VkDeviceSize>(static_cast<double>(heap.budget) * BUDGET_FRACTION);
+        best = std::max(best, usable > others ? usable - others : 0);
+    }
+    return best;
+}
+
+VkDeviceSize TextureStreamer::rebuild(Texture &texture, uint32_t firstMip) {
+    const MappedTextureFile &file = *texture.file;
+    uint32_t levelCount = file.mipCount() - firstMip;
+
+    Image image;
+    image.firstMip = firstMip;
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = file.format();
+    imageInfo.extent = file.levelExtent(firstMip);
+    imageInfo.mipLevels = levelCount;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    image.image = allocator->createImage(imageInfo, MemoryUsage::GpuOnly, image.allocation);
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = image.image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = file.format();
+    viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, levelCount, 0, 1};
+    if (vkCreateImageView(device, &viewInfo, nullptr, &image.view) != VK_SUCCESS) {
+        allocator->destroyImage(image.image, image.allocation);
+        throw std::runtime_error("Failed to create streamed texture view!");
+    }
+
+    // Smallest level first, matching the file layout, so reads walk the mapping forwards
+    file.prefetch(firstMip);
+    VkDeviceSize bytes = 0;
+    UploadToken token = 0;
+    for (uint32_t level = file.mipCount(); level-- > firstMip;) {
+        ImageUpload dst{};
+        dst.image = image.image;
+        dst.extent = file.levelExtent(level);
+        dst.mipLevel = level - firstMip;
+        token = uploads->uploadImage(dst, file.levelData(level), file.levelSize(level));
+        bytes += file.levelSize(level);
+    }
+
+    texture.pending = image;
+    texture.pendingToken = token;
+    texture.hasPending = true;
+    bytesStreamed += bytes;
+    return bytes;
+}
+
+void TextureStreamer::retire(Image &image, UploadToken token) {
+    if (image.image == VK_NULL_HANDLE) return;
+    retiringBytes += image.allocation.size;
+    if (uploads->isAvailable(token)) {
+        release(image);
+    } else {
+        // Removed mid-upload: the acquire still has to be recorded before the image can go
+        orphans.push_back({image, token});
+    }
+    image = Image{};
+}
+
+void TextureStreamer::release(Image image) {
+    deletionQueue->defer([this, image]() mutable {
+        retiringBytes -= image.allocation.size;
+        destroyImage(image);
+    });
+}
+
+void TextureStreamer::destroyImage(Image &image) {
+    if (image.view != VK_NULL_HANDLE) vkDestroyImageView(device, image.view, nullptr);
+    if (image.image != VK_NULL_HANDLE) allocator->destroyImage(image.image, image.allocation);
+    image = Image{};
+}
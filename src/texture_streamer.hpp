@@ -0,0 +1,147 @@
+#pragma once
+
+#include "bindless.hpp"
+#include "deletion_queue.hpp"
+#include "gpu_allocator.hpp"
+#include "texture_file.hpp"
+#include "upload_service.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+using StreamedTexture = uint32_t;
+
+struct TextureStreamerStats {
+    uint32_t textures = 0;
+    // Device memory of the images textures are using or being upgraded to, and the limit on it
+    VkDeviceSize residentBytes = 0;
+    VkDeviceSize budgetBytes = 0;
+    // Images swapped out but still in use by frames in flight
+    VkDeviceSize retiringBytes = 0;
+    // Residency changes that finished since init(); a load adds detail, an eviction drops it
+    uint64_t loads = 0;
+    uint64_t evictions = 0;
+    VkDeviceSize bytesStreamed = 0;
+    uint32_t pending = 0;
+    // Textures whose resident detail is below what this frame asked for
+    uint32_t starved = 0;
+};
+
+// Streams mip levels of texture files (see texture_file.hpp) by screen-space demand. Each
+// texture always keeps its mip tail (levels up to TAIL_SIZE) resident; callers report how many
+// pixels a texture covers each frame and update() picks the level that gives about one texel
+// per pixel, loading the most starved textures first while staying inside a budget taken from
+// VK_EXT_memory_budget. When a load doesn't fit, textures not requested this frame are evicted
+// back to their tail, least recently requested first. Without memory pressure nothing is
+// dropped, so textures that come back into view are usually still resident.
+//
+// A residency change builds a new image holding exactly the wanted levels and re-uploads them
+// from the file mapping, smallest first, on the transfer queue; the current image stays in use
+// until the new one is available and is destroyed once no frame in flight reads it. Shaders
+// reach a texture through handle(), which changes whenever a new image is swapped in.
+class TextureStreamer {
+public:
+    // Levels no larger than this on either axis are loaded by add() and never evicted
+    static constexpr uint32_t TAIL_SIZE = 64;
+    static constexpr VkDeviceSize DEFAULT_FRAME_UPLOAD_BYTES = 16ull * 1024 * 1024;
+
+    void init(VkDevice device, GpuAllocator &allocator, UploadService &uploads, BindlessTable &bindless,
+              DeletionQueue &deletionQueue);
+    // The GPU must be idle
+    void destroy();
+
+    // Maps the file and queues its mip tail; throws if the file is invalid
+    StreamedTexture add(const std::string &path);
+    void remove(StreamedTexture texture);
+
+    // The texture covers about pixels pixels along its larger axis this frame; the largest
+    // request of the frame counts
+    void request(StreamedTexture texture, float pixels);
+
+    // 0 (the default) follows VK_EXT_memory_budget
+    void setBudget(VkDeviceSize bytes) { budgetOverride = bytes; }
+    // Bytes queued for upload per update(); 0 = unlimited. The first load of a frame always goes out.
+    void setFrameUploadLimit(VkDeviceSize bytes) { frameUploadLimit = bytes; }
+
+    // frameNumber as for BindlessTable::beginFrame(); swaps in images whose uploads are
+    // available and hands the swapped-out ones to the DeletionQueue
+    void beginFrame(uint64_t frameNumber);
+    // Evicts and queues loads for this frame's requests, then clears them. Call before
+    // UploadService::flush().
+    void update();
+
+    // BINDLESS_INVALID until the mip tail has arrived
+    BindlessHandle handle(StreamedTexture texture) const { return textures[texture].handle; }
+    // Most detailed level of the image behind handle()
+    uint32_t residentMip(StreamedTexture texture) const { return textures[texture].residentMip; }
+    TextureStreamerStats stats() const;
+
+private:
+    struct Image {
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        GpuAllocation allocation;
+        // Level of the file stored in the image's level 0
+        uint32_t firstMip = 0;
+    };
+
+    struct Texture {
+        std::unique_ptr<MappedTextureFile> file;
+        // Most detailed level that fits in the staging ring, and the first level of the tail
+        uint32_t minMip = 0;
+        uint32_t tailMip = 0;
+        Image current;
+        BindlessHandle handle = BINDLESS_INVALID;
+        uint32_t residentMip = 0;
+        Image pending;
+        UploadToken pendingToken = 0;
+        bool hasPending = false;
+        float requestedPixels = 0.0f;
+        uint64_t lastRequested = 0;
+        bool live = false;
+    };
+
+    // Image of a texture removed mid-upload
+    struct Orphan {
+        Image image;
+        // Upload into the image; it may only go once its acquire has been recorded
+        UploadToken token = 0;
+    };
+
+    uint32_t wantedMip(const Texture &texture) const;
+    uint32_t committedMip(const Texture &texture) const;
+    // Device memory the texture will hold once its pending change (if any) lands
+    VkDeviceSize committedBytes(const Texture &texture) const;
+    VkDeviceSize imageBytes(const Texture &texture, uint32_t firstMip) const;
+    VkDeviceSize budget() const;
+    // Creates the image holding [firstMip, mipCount) and queues its uploads; returns the bytes queued
+    VkDeviceSize rebuild(Texture &texture, uint32_t firstMip);
+    void retire(Image &image, UploadToken token);
+    // Queues image for destruction once no frame in flight uses it
+    void release(Image image);
+    void destroyImage(Image &image);
+
+    VkDevice device = VK_NULL_HANDLE;
+    GpuAllocator *allocator = nullptr;
+    UploadService *uploads = nullptr;
+    BindlessTable *bindless = nullptr;
+    DeletionQueue *deletionQueue = nullptr;
+    uint64_t currentFrame = 0;
+    VkDeviceSize budgetOverride = 0;
+    VkDeviceSize frameUploadLimit = DEFAULT_FRAME_UPLOAD_BYTES;
+
+    std::vector<Texture> textures;
+    std::vector<StreamedTexture> freeSlots;
+    std::vector<Orphan> orphans;
+    // Retired images not destroyed yet. Not reset by init(): the deletion queue may still hold
+    // images from before a destroy()
+    VkDeviceSize retiringBytes = 0;
+    uint64_t loads = 0;
+    uint64_t evictions = 0;
+    VkDeviceSize bytesStreamed = 0;
+    uint32_t starved = 0;
+};
@@ -0,0 +1,391 @@
+#include "upload_service.hpp"
+
+#include "vk_dispatch.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+uint64_t alignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+void UploadService::init(GpuAllocator &alloc, VkPhysicalDevice physicalDevice,
+                         uint32_t transferFam, VkQueue queue, uint32_t graphicsFam, VkDeviceSize size) {
+    allocator = &alloc;
+    device = alloc.getDevice();
+    transferQueue = queue;
+    transferFamily = transferFam;
+    graphicsFamily = graphicsFam;
+
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &props);
+    // 16 covers every texel block size; the driver may want more for fast copies
+    copyAlignment = std::max<VkDeviceSize>(16, props.limits.optimalBufferCopyOffsetAlignment);
+    // A whole number of alignment units keeps virtual and physical offsets equally aligned
+    ringSize = alignUp(size, copyAlignment);
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex = transferFamily;
+    if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create upload command pool!");
+    }
+
+    VkSemaphoreTypeCreateInfo typeInfo{};
+    typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeInfo.initialValue = 0;
+    VkSemaphoreCreateInfo semInfo{};
+    semInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semInfo.pNext = &typeInfo;
+    if (vkCreateSemaphore(device, &semInfo, nullptr, &timelineSemaphore) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create upload timeline semaphore!");
+    }
+
+    VkBufferCreateInfo bufInfo{};
+    bufInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufInfo.size = ringSize;
+    bufInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    bufInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    ringBuffer = allocator->createBuffer(bufInfo, MemoryUsage::CpuToGpu, ringAllocation);
+    if (!ringAllocation.mapped) {
+        throw std::runtime_error("Upload staging ring is not host visible!");
+    }
+}
+
+void UploadService::destroy() {
+    if (device == VK_NULL_HANDLE) return;
+
+    // Destroying the pool frees every batch's command buffer
+    vkDestroyCommandPool(device, commandPool, nullptr);
+    vkDestroySemaphore(device, timelineSemaphore, nullptr);
+    allocator->destroyBuffer(ringBuffer, ringAllocation);
+
+    commandPool = VK_NULL_HANDLE;
+    timelineSemaphore = VK_NULL_HANDLE;
+    ringBuffer = VK_NULL_HANDLE;
+    freeCommandBuffers.clear();
+    current = Batch{};
+    inFlight.clear();
+    completed.clear();
+    device = VK_NULL_HANDLE;
+}
+
+VkCommandBuffer UploadService::currentCommandBuffer() {
+    if (current.cmd != VK_NULL_HANDLE) return current.cmd;
+
+    if (!freeCommandBuffers.empty()) {
+        current.cmd = freeCommandBuffers.back();
+        freeCommandBuffers.pop_back();
+    } else {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = commandPool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+        if (vkd.allocateCommandBuffers(device, &allocInfo, &current.cmd) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate upload command buffer!");
+        }
+    }
+
+    // The pool allows per-buffer reset, so begin implicitly resets a recycled buffer
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (vkd.beginCommandBuffer(current.cmd, &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to begin upload command buffer!");
+    }
+    return current.cmd;
+}
+
+VkDeviceSize UploadService::allocateStaging(VkDeviceSize size, VkDeviceSize alignment) {
+    if (size > ringSize) {
+        throw std::runtime_error("Upload does not fit in the staging ring!");
+    }
+
+    for (;;) {
+        reclaimLocked();
+        if (inFlight.empty() && current.cmd == VK_NULL_HANDLE) {
+            // Nothing references the ring, so restart at its beginning
+            ringHead = ringTail = alignUp(ringHead, ringSize);
+        }
+
+        uint64_t pos = alignUp(ringHead, alignment);
+        uint64_t physical = pos % ringSize;
+        if (physical + size > ringSize) {
+            // Never split an allocation across the wrap; skip the leftover tail
+            pos += ringSize - physical;
+        }
+        if (pos + size - ringTail <= ringSize) {
+            ringHead = pos + size;
+            return pos % ringSize;
+        }
+
+        // Full: make the oldest staging space reclaimable and wait for it
+        ++counters.ringStalls;
+        if (inFlight.empty()) {
+            flushLocked();
+        }
+        waitValue(inFlight.front().value);
+    }
+}
+
+UploadToken UploadService::uploadBuffer(VkBuffer dst, VkDeviceSize dstOffset, const void *data, VkDeviceSize size,
+                                        VkPipelineStageFlags dstStage, VkAccessFlags dstAccess) {
+    // Nothing to copy; token 0 is already available and complete
+    if (size == 0) return 0;
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Large uploads are split so they can stream through the ring while earlier chunks copy
+    const char *src = static_cast<const char*>(data);
+    VkDeviceSize remaining = size;
+    VkDeviceSize written = 0;
+    while (remaining > 0) {
+        VkDeviceSize chunk = std::min(remaining, ringSize / 2);
+        VkDeviceSize staging = allocateStaging(chunk, 4);
+        std::memcpy(static_cast<char*>(ringAllocation.mapped) + staging, src + written, chunk);
+        allocator->flush(ringAllocation, staging, chunk);
+
+        VkBufferCopy region{};
+        region.srcOffset = staging;
+        region.dstOffset = dstOffset + written;
+        region.size = chunk;
+        vkd.cmdCopyBuffer(currentCommandBuffer(), ringBuffer, dst, 1, &region);
+
+        written += chunk;
+        remaining -= chunk;
+    }
+    counters.bytesUploaded += size;
+
+    // One release covers every chunk: earlier batches precede it in submission order
+    VkCommandBuffer cmd = currentCommandBuffer();
+    if (ownershipTransfers()) {
+        VkBufferMemoryBarrier release{};
+        release.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        release.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        release.dstAccessMask = 0;
+        release.srcQueueFamilyIndex = transferFamily;
+        release.dstQueueFamilyIndex = graphicsFamily;
+        release.buffer = dst;
+        release.offset = dstOffset;
+        release.size = size;
+        vkd.cmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                             0, nullptr, 1, &release, 0, nullptr);
+    }
+    current.bufferAcquires.push_back({dst, dstOffset, size, dstStage, dstAccess});
+    return submittedValue + 1;
+}
+
+UploadToken UploadService::uploadImage(const ImageUpload &dst, const void *data, VkDeviceSize size) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    VkDeviceSize staging = allocateStaging(size, copyAlignment);
+    std::memcpy(static_cast<char*>(ringAllocation.mapped) + staging, data, size);
+    allocator->flush(ringAllocation, staging, size);
+    counters.bytesUploaded += size;
+
+    VkCommandBuffer cmd = currentCommandBuffer();
+
+    VkImageSubresourceRange range{};
+    range.aspectMask = dst.aspect;
+    range.baseMipLevel = dst.mipLevel;
+    range.levelCount = 1;
+    range.baseArrayLayer = dst.baseArrayLayer;
+    range.layerCount = dst.layerCount;
+
+    VkImageMemoryBarrier toTransfer{};
+    toTransfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    toTransfer.srcAccessMask = 0;
+    toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toTransfer.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    toTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.image = dst.image;
+    toTransfer.subresourceRange = range;
+    vkd.cmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                         0, nullptr, 0, nullptr, 1, &toTransfer);
+
+    VkBufferImageCopy region{};
+    region.bufferOffset = staging;
+    region.imageSubresource.aspectMask = dst.aspect;
+    region.imageSubresource.mipLevel = dst.mipLevel;
+    region.imageSubresource.baseArrayLayer = dst.baseArrayLayer;
+    region.imageSubresource.layerCount = dst.layerCount;
+    region.imageExtent = dst.extent;
+    vkd.cmdCopyBufferToImage(cmd, ringBuffer, dst.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    // Transition to the final layout here; with an ownership transfer this is the release half
+    // and the graphics queue repeats the same layouts in its acquire.
+    VkImageMemoryBarrier release{};
+    release.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    release.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    release.dstAccessMask = 0;
+    release.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    release.newLayout = dst.finalLayout;
+    release.srcQueueFamilyIndex = ownershipTransfers() ? transferFamily : VK_QUEUE_FAMILY_IGNORED;
+    release.dstQueueFamilyIndex = ownershipTransfers() ? graphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+    release.image = dst.image;
+    release.subresourceRange = range;
+    vkd.cmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                         0, nullptr, 0, nullptr, 1, &release);
+
+    current.imageAcquires.push_back({dst});
+    return submittedValue + 1;
+}
+
+UploadToken UploadService::flush() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return flushLocked();
+}
+
+UploadToken UploadService::flushLocked() {
+    if (current.cmd == VK_NULL_HANDLE) return submittedValue;
+
+    if (vkd.endCommandBuffer(current.cmd) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to record upload command buffer!");
+    }
+
+    current.value = submittedValue + 1;
+    current.ringEnd = ringHead;
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &current.value;
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &current.cmd;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &timelineSemaphore;
+    if (vkd.queueSubmit(transferQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to submit upload batch!");
+    }
+
+    submittedValue = current.value;
+    ++counters.batchesSubmitted;
+    inFlight.push_back(std::move(current));
+    current = Batch{};
+    return submittedValue;
+}
+
+void UploadService::reclaimLocked() {
+    if (inFlight.empty()) return;
+
+    uint64_t done = 0;
+    vkd.getSemaphoreCounterValue(device, timelineSemaphore, &done);
+    while (!inFlight.empty() && inFlight.front().value <= done) {
+        Batch &batch = inFlight.front();
+        ringTail = batch.ringEnd;
+        freeCommandBuffers.push_back(batch.cmd);
+        batch.cmd = VK_NULL_HANDLE;
+        completed.push_back(std::move(batch));
+        inFlight.pop_front();
+    }
+}
+
+void UploadService::waitValue(uint64_t value) {
+    VkSemaphoreWaitInfo waitInfo{};
+    waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &timelineSemaphore;
+    waitInfo.pValues = &value;
+    if (vkd.waitSemaphores(device, &waitInfo, UINT64_MAX) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to wait for upload batch!");
+    }
+    reclaimLocked();
+}
+
+UploadWait UploadService::recordPendingAcquires(VkCommandBuffer cmd) {
+    std::lock_guard<std::mutex> lock(mutex);
+    reclaimLocked();
+
+    UploadWait wait;
+    if (completed.empty()) return wait;
+
+    std::vector<VkBufferMemoryBarrier> bufferBarriers;
+    std::vector<VkImageMemoryBarrier> imageBarriers;
+    for (const Batch &batch : completed) {
+        wait.value = std::max(wait.value, batch.value);
+        for (const BufferAcquire &a : batch.bufferAcquires) {
+            wait.stages |= a.dstStage;
+            VkBufferMemoryBarrier acquire{};
+            acquire.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            acquire.srcAccessMask = 0;
+            acquire.dstAccessMask = a.dstAccess;
+            acquire.srcQueueFamilyIndex = transferFamily;
+            acquire.dstQueueFamilyIndex = graphicsFamily;
+            acquire.buffer = a.buffer;
+            acquire.offset = a.offset;
+            acquire.size = a.size;
+            bufferBarriers.push_back(acquire);
+        }
+        for (const ImageAcquire &a : batch.imageAcquires) {
+            const ImageUpload &t = a.target;
+            wait.stages |= t.dstStage;
+            VkImageMemoryBarrier acquire{};
+            acquire.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            acquire.srcAccessMask = 0;
+            acquire.dstAccessMask = t.dstAccess;
+            acquire.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            acquire.newLayout = t.finalLayout;
+            acquire.srcQueueFamilyIndex = transferFamily;
+            acquire.dstQueueFamilyIndex = graphicsFamily;
+            acquire.image = t.image;
+            acquire.subresourceRange.aspectMask = t.aspect;
+            acquire.subresourceRange.baseMipLevel = t.mipLevel;
+            acquire.subresourceRange.levelCount = 1;
+            acquire.subresourceRange.baseArrayLayer = t.baseArrayLayer;
+            acquire.subresourceRange.layerCount = t.layerCount;
+            imageBarriers.push_back(acquire);
+        }
+    }
+    completed.clear();
+    if (wait.stages == 0) {
+        wait.stages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    }
+
+    // Same family: the semaphore wait alone makes the copies visible. Otherwise the acquire
+    // uses the wait's stages as its source scope so the two form a dependency chain.
+    if (ownershipTransfers() && (!bufferBarriers.empty() || !imageBarriers.empty())) {
+        vkd.cmdPipelineBarrier(cmd, wait.stages, wait.stages, 0, 0, nullptr,
+                             static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+                             static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+    }
+
+    acquiredValue = wait.value;
+    return wait;
+}
+
+bool UploadService::isAvailable(UploadToken token) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return token <= acquiredValue;
+}
+
+bool UploadService::isComplete(UploadToken token) const {
+    uint64_t done = 0;
+    vkd.getSemaphoreCounterValue(device, timelineSemaphore, &done);
+    return token <= done;
+}
+
+void UploadService::wait(UploadToken token) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (token > submittedValue) {
+        flushLocked();
+    }
+    waitValue(token);
+}
+
+UploadServiceStats UploadService::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
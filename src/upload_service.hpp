@@ -0,0 +1,146 @@
+#pragma once
+
+#include "gpu_allocator.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// Timeline value of the batch an upload was recorded into
+using UploadToken = uint64_t;
+
+// Timeline wait the graphics submission must add for the acquires it recorded
+struct UploadWait {
+    uint64_t value = 0;  // 0 = no wait needed
+    VkPipelineStageFlags stages = 0;
+};
+
+struct UploadServiceStats {
+    VkDeviceSize bytesUploaded = 0;
+    uint64_t batchesSubmitted = 0;
+    // Uploads that had to wait for the GPU because the staging ring was full
+    uint64_t ringStalls = 0;
+};
+
+// Destination of an image upload. Only the given mip level and layers are transitioned, so
+// individual mips can be streamed into an image whose other levels are already in use.
+struct ImageUpload {
+    VkImage image = VK_NULL_HANDLE;
+    VkExtent3D extent{};
+    uint32_t mipLevel = 0;
+    uint32_t baseArrayLayer = 0;
+    uint32_t layerCount = 1;
+    VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+    VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    VkAccessFlags dstAccess = VK_ACCESS_SHADER_READ_BIT;
+};
+
+// Streams buffer and image data to the GPU on the transfer queue through a persistently
+// mapped staging ring. Copies are batched into one command buffer per flush() and each batch
+// signals a timeline semaphore, whose value doubles as the completion token.
+//
+// When the transfer queue belongs to a different family than the graphics queue, resources
+// are released on the transfer queue and acquired by recordPendingAcquires() in the next
+// frame recorded after the batch completed, so the render loop never waits on an upload.
+// Without a dedicated family the service falls back to the graphics queue; flush() then
+// submits to it and must be called from the render thread.
+class UploadService {
+public:
+    static constexpr VkDeviceSize DEFAULT_RING_SIZE = 32ull * 1024 * 1024;
+
+    void init(GpuAllocator &allocator, VkPhysicalDevice physicalDevice,
+              uint32_t transferFamily, VkQueue transferQueue, uint32_t graphicsFamily,
+              VkDeviceSize ringSize = DEFAULT_RING_SIZE);
+    // The caller must have waited for the device to go idle
+    void destroy();
+
+    // dstStage/dstAccess describe the first graphics-queue use of the data. Empty uploads
+    // record nothing and return token 0.
+    UploadToken uploadBuffer(VkBuffer dst, VkDeviceSize dstOffset, const void *data, VkDeviceSize size,
+                             VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                             VkAccessFlags dstAccess = VK_ACCESS_MEMORY_READ_BIT);
+    // data holds tightly packed texels; throws if it does not fit in the staging ring
+    UploadToken uploadImage(const ImageUpload &dst, const void *data, VkDeviceSize size);
+
+    // Submits everything recorded since the last flush. Returns the batch's token (or the last
+    // submitted one if there was nothing to submit).
+    UploadToken flush();
+
+    // Graphics-queue side, called right after vkBeginCommandBuffer: records the acquire half of
+    // every ownership transfer whose batch has completed. The returned value has already been
+    // reached, so adding the wait to the submission of cmd never stalls the queue.
+    UploadWait recordPendingAcquires(VkCommandBuffer cmd);
+
+    // True once draws recorded after recordPendingAcquires() may use the data
+    bool isAvailable(UploadToken token) const;
+    bool isComplete(UploadToken token) const;
+    // Blocks until the batch has executed on the transfer queue (flushing it if needed)
+    void wait(UploadToken token);
+
+    VkSemaphore timeline() const { return timelineSemaphore; }
+    // Largest single upload the staging ring can take
+    VkDeviceSize stagingCapacity() const { return ringSize; }
+    bool ownershipTransfers() const { return transferFamily != graphicsFamily; }
+    UploadServiceStats stats() const;
+
+private:
+    struct BufferAcquire {
+        VkBuffer buffer;
+        VkDeviceSize offset;
+        VkDeviceSize size;
+        VkPipelineStageFlags dstStage;
+        VkAccessFlags dstAccess;
+    };
+
+    struct ImageAcquire {
+        ImageUpload target;
+    };
+
+    struct Batch {
+        VkCommandBuffer cmd = VK_NULL_HANDLE;
+        uint64_t value = 0;
+        // Virtual ring position just past the batch's last staging allocation
+        uint64_t ringEnd = 0;
+        std::vector<BufferAcquire> bufferAcquires;
+        std::vector<ImageAcquire> imageAcquires;
+    };
+
+    // Returns the staging offset of size bytes, flushing and waiting if the ring is full
+    VkDeviceSize allocateStaging(VkDeviceSize size, VkDeviceSize alignment);
+    VkCommandBuffer currentCommandBuffer();
+    UploadToken flushLocked();
+    void reclaimLocked();
+    void waitValue(uint64_t value);
+
+    GpuAllocator *allocator = nullptr;
+    VkDevice device = VK_NULL_HANDLE;
+    VkQueue transferQueue = VK_NULL_HANDLE;
+    uint32_t transferFamily = 0;
+    uint32_t graphicsFamily = 0;
+    VkDeviceSize copyAlignment = 16;
+
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    std::vector<VkCommandBuffer> freeCommandBuffers;
+    VkSemaphore timelineSemaphore = VK_NULL_HANDLE;
+
+    VkBuffer ringBuffer = VK_NULL_HANDLE;
+    GpuAllocation ringAllocation;
+    VkDeviceSize ringSize = 0;
+    // Monotonic virtual positions; the physical offset is position % ringSize
+    uint64_t ringHead = 0;
+    uint64_t ringTail = 0;
+
+    Batch current;
+    std::deque<Batch> inFlight;
+    // Batches that completed but whose acquires the graphics queue has not recorded yet
+    std::vector<Batch> completed;
+    uint64_t submittedValue = 0;
+    uint64_t acquiredValue = 0;
+
+    UploadServiceStats counters;
+    mutable std::mutex mutex;
+};
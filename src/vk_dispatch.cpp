@@ -0,0 +1,65 @@
+#include "vk_dispatch.hpp"
+
+#include <stdexcept>
+#include <string>
+
+DeviceDispatch vkd;
+
+namespace {
+
+template <typename Fn>
+void load(VkDevice device, Fn &out, const char *name) {
+    out = reinterpret_cast<Fn>(vkGetDeviceProcAddr(device, name));
+    if (out == nullptr) {
+        throw std::runtime_error(std::string("Missing device entry point ") + name + "!");
+    }
+}
+
+} // namespace
+
+void loadDeviceDispatch(VkDevice device, bool swapchain) {
+    vkd = {};
+    load(device, vkd.cmdBeginRendering, "vkCmdBeginRendering");
+    load(device, vkd.cmdEndRendering, "vkCmdEndRendering");
+    load(device, vkd.cmdBindPipeline, "vkCmdBindPipeline");
+    load(device, vkd.cmdBindDescriptorSets, "vkCmdBindDescriptorSets");
+    load(device, vkd.cmdBindIndexBuffer, "vkCmdBindIndexBuffer");
+    load(device, vkd.cmdBindVertexBuffers, "vkCmdBindVertexBuffers");
+    load(device, vkd.cmdPushConstants, "vkCmdPushConstants");
+    load(device, vkd.cmdSetViewport, "vkCmdSetViewport");
+    load(device, vkd.cmdSetScissor, "vkCmdSetScissor");
+    load(device, vkd.cmdDraw, "vkCmdDraw");
+    load(device, vkd.cmdDrawIndexed, "vkCmdDrawIndexed");
+    load(device, vkd.cmdDrawIndexedIndirectCount, "vkCmdDrawIndexedIndirectCount");
+    load(device, vkd.cmdDispatch, "vkCmdDispatch");
+    load(device, vkd.cmdPipelineBarrier, "vkCmdPipelineBarrier");
+    load(device, vkd.cmdPipelineBarrier2, "vkCmdPipelineBarrier2");
+    load(device, vkd.cmdExecuteCommands, "vkCmdExecuteCommands");
+    load(device, vkd.cmdCopyBuffer, "vkCmdCopyBuffer");
+    load(device, vkd.cmdCopyBufferToImage, "vkCmdCopyBufferToImage");
+    load(device, vkd.cmdCopyImageToBuffer, "vkCmdCopyImageToBuffer");
+    load(device, vkd.cmdBlitImage, "vkCmdBlitImage");
+    load(device, vkd.cmdClearColorImage, "vkCmdClearColorImage");
+    load(device, vkd.cmdFillBuffer, "vkCmdFillBuffer");
+    load(device, vkd.cmdResetQueryPool, "vkCmdResetQueryPool");
+    load(device, vkd.cmdWriteTimestamp2, "vkCmdWriteTimestamp2");
+    load(device, vkd.beginCommandBuffer, "vkBeginCommandBuffer");
+    load(device, vkd.endCommandBuffer, "vkEndCommandBuffer");
+    load(device, vkd.allocateCommandBuffers, "vkAllocateCommandBuffers");
+    load(device, vkd.resetCommandPool, "vkResetCommandPool");
+    load(device, vkd.waitForFences, "vkWaitForFences");
+    load(device, vkd.resetFences, "vkResetFences");
+    load(device, vkd.queueSubmit, "vkQueueSubmit");
+    load(device, vkd.queueSubmit2, "vkQueueSubmit2");
+    load(device, vkd.getSemaphoreCounterValue, "vkGetSemaphoreCounterValue");
+    load(device, vkd.waitSemaphores, "vkWaitSemaphores");
+    load(device, vkd.getQueryPoolResults, "vkGetQueryPoolResults");
+    load(device, vkd.allocateDescriptorSets, "vkAllocateDescriptorSets");
+    load(device, vkd.freeDescriptorSets, "vkFreeDescriptorSets");
+    load(device, vkd.resetDescriptorPool, "vkResetDescriptorPool");
+    load(device, vkd.updateDescriptorSets, "vkUpdateDescriptorSets");
+    if (swapchain) {
+        load(device, vkd.acquireNextImageKHR, "vkAcquireNextImageKHR");
+        load(device, vkd.queuePresentKHR, "vkQueuePresentKHR");
+    }
+}
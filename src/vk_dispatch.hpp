@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// Device-level entry points of the calls made per draw or per frame, fetched with
+// vkGetDeviceProcAddr. The global vk* functions exported by the loader are trampolines that
+// look up the device's dispatch table on every call; these pointers go straight to the
+// driver (or the first enabled layer). Setup code keeps using the global entry points.
+struct DeviceDispatch {
+    // Command recording
+    PFN_vkCmdBeginRendering cmdBeginRendering = nullptr;
+    PFN_vkCmdEndRendering cmdEndRendering = nullptr;
+    PFN_vkCmdBindPipeline cmdBindPipeline = nullptr;
+    PFN_vkCmdBindDescriptorSets cmdBindDescriptorSets = nullptr;
+    PFN_vkCmdBindIndexBuffer cmdBindIndexBuffer = nullptr;
+    PFN_vkCmdBindVertexBuffers cmdBindVertexBuffers = nullptr;
+    PFN_vkCmdPushConstants cmdPushConstants = nullptr;
+    PFN_vkCmdSetViewport cmdSetViewport = nullptr;
+    PFN_vkCmdSetScissor cmdSetScissor = nullptr;
+    PFN_vkCmdDraw cmdDraw = nullptr;
+    PFN_vkCmdDrawIndexed cmdDrawIndexed = nullptr;
+    PFN_vkCmdDrawIndexedIndirectCount cmdDrawIndexedIndirectCount = nullptr;
+    PFN_vkCmdDispatch cmdDispatch = nullptr;
+    PFN_vkCmdPipelineBarrier cmdPipelineBarrier = nullptr;
+    PFN_vkCmdPipelineBarrier2 cmdPipelineBarrier2 = nullptr;
+    PFN_vkCmdExecuteCommands cmdExecuteCommands = nullptr;
+    PFN_vkCmdCopyBuffer cmdCopyBuffer = nullptr;
+    PFN_vkCmdCopyBufferToImage cmdCopyBufferToImage = nullptr;
+    PFN_vkCmdCopyImageToBuffer cmdCopyImageToBuffer = nullptr;
+    PFN_vkCmdBlitImage cmdBlitImage = nullptr;
+    PFN_vkCmdClearColorImage cmdClearColorImage = nullptr;
+    PFN_vkCmdFillBuffer cmdFillBuffer = nullptr;
+    PFN_vkCmdResetQueryPool cmdResetQueryPool = nullptr;
+    PFN_vkCmdWriteTimestamp2 cmdWriteTimestamp2 = nullptr;
+
+    // Command buffers, synchronization and submission
+    PFN_vkBeginCommandBuffer beginCommandBuffer = nullptr;
+    PFN_vkEndCommandBuffer endCommandBuffer = nullptr;
+    PFN_vkAllocateCommandBuffers allocateCommandBuffers = nullptr;
+    PFN_vkResetCommandPool resetCommandPool = nullptr;
+    PFN_vkWaitForFences waitForFences = nullptr;
+    PFN_vkResetFences resetFences = nullptr;
+    PFN_vkQueueSubmit queueSubmit = nullptr;
+    PFN_vkQueueSubmit2 queueSubmit2 = nullptr;
+    PFN_vkGetSemaphoreCounterValue getSemaphoreCounterValue = nullptr;
+    PFN_vkWaitSemaphores waitSemaphores = nullptr;
+    PFN_vkGetQueryPoolResults getQueryPoolResults = nullptr;
+
+    // Transient descriptor sets
+    PFN_vkAllocateDescriptorSets allocateDescriptorSets = nullptr;
+    PFN_vkFreeDescriptorSets freeDescriptorSets = nullptr;
+    PFN_vkResetDescriptorPool resetDescriptorPool = nullptr;
+    PFN_vkUpdateDescriptorSets updateDescriptorSets = nullptr;
+
+    // Null unless VK_KHR_swapchain is enabled
+    PFN_vkAcquireNextImageKHR acquireNextImageKHR = nullptr;
+    PFN_vkQueuePresentKHR queuePresentKHR = nullptr;
+};
+
+// The table of the current device, shared by every subsystem (the engine runs one device at
+// a time). Filled by loadDeviceDispatch() right after the device is created.
+extern DeviceDispatch vkd;
+
+// Throws if a core entry point is missing
+void loadDeviceDispatch(VkDevice device, bool swapchain);
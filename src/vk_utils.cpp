@@ -0,0 +1,40 @@
+#include "vk_utils.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+
+#ifndef VUK_SHADER_DIR
+#define VUK_SHADER_DIR "shaders"
+#endif
+
+std::vector<char> readBinaryFile(const std::string &path) {
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to open file: " + path);
+    }
+    std::vector<char> data(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(data.data(), static_cast<std::streamsize>(data.size()));
+    return data;
+}
+
+std::string shaderPath(const std::string &name) {
+    const char *dir = std::getenv("VUK_SHADER_DIR");
+    return std::string(dir ? dir : VUK_SHADER_DIR) + "/" + name;
+}
+
+VkShaderModule loadShaderModule(VkDevice device, const std::string &name) {
+    std::vector<char> code = readBinaryFile(shaderPath(name));
+
+    VkShaderModuleCreateInfo info{};
+    info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    info.codeSize = code.size();
+    info.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+    VkShaderModule module = VK_NULL_HANDLE;
+    if (vkCreateShaderModule(device, &info, nullptr, &module) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create shader module: " + name);
+    }
+    return module;
+}
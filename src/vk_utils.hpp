@@ -0,0 +1,15 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <string>
+#include <vector>
+
+// Reads a whole file; throws std::runtime_error if it can't be opened
+std::vector<char> readBinaryFile(const std::string &path);
+
+// Resolves a compiled shader name (e.g. "triangle.vert.spv") against VUK_SHADER_DIR, which
+// can be overridden at runtime through the environment variable of the same name.
+std::string shaderPath(const std::string &name);
+
+VkShaderModule loadShaderModule(VkDevice device, const std::string &name);